@@ -0,0 +1,145 @@
+#include "bench_util.h"
+#include "commands.h"
+#include "pager.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <sstream>
+#include <thread>
+
+// --- listDirectory --------------------------------------------------------
+
+static void BM_ListDirectoryShort(benchmark::State& state) {
+    Terminal& term = benchTerminal();
+    const std::string dir = syntheticDirectory(state.range(0)).string();
+    const std::vector<std::string_view> tokens = {"ls", dir};
+    NullOutput out;
+    for (auto _ : state) {
+        listDirectory(term, tokens);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ListDirectoryShort)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+static void BM_ListDirectoryLong(benchmark::State& state) {
+    Terminal& term = benchTerminal();
+    const std::string dir = syntheticDirectory(state.range(0)).string();
+    const std::vector<std::string_view> tokens = {"ls", "-l", dir};
+    NullOutput out;
+    for (auto _ : state) {
+        listDirectory(term, tokens);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ListDirectoryLong)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+// --- showFileContent ------------------------------------------------------
+
+// Log-like file of roughly `megabytes` MB, built once per size
+static fs::path largeFile(int64_t megabytes) {
+    static std::map<int64_t, std::unique_ptr<ScopedTempDir>> cache;
+    auto& dir = cache[megabytes];
+    if (!dir) {
+        dir = std::make_unique<ScopedTempDir>("file" + std::to_string(megabytes));
+        std::ofstream file(dir->path / "big.log", std::ios::binary);
+        const std::string line = "2024-01-01T00:00:00Z INFO myterm: linea de registro de ejemplo con algo de texto\n";
+        std::string block;
+        while (block.size() < (1 << 20)) block += line;
+        for (int64_t written = 0; written < megabytes << 20; written += block.size()) file << block;
+    }
+    return dir->path / "big.log";
+}
+
+static void BM_ShowFileContent(benchmark::State& state) {
+    const std::string path = largeFile(state.range(0)).string();
+    NullOutput out;
+    for (auto _ : state) {
+        showFileContent(path);
+    }
+    state.SetBytesProcessed(state.iterations() * (state.range(0) << 20));
+}
+
+// --- less -----------------------------------------------------------------
+
+// Time to the first rendered screen, which never waits for the line index
+static void BM_PagerFirstScreen(benchmark::State& state) {
+    const std::string path = largeFile(state.range(0)).string();
+    std::string screen;
+    for (auto _ : state) {
+        Pager pager(path);
+        pager.open();
+        pager.setSize(50, 160);
+        if (state.range(1)) pager.goBottom();
+        pager.render(screen);
+        benchmark::DoNotOptimize(screen.data());
+    }
+}
+
+// Background index throughput, and how big the index gets
+static void BM_LineIndexBuild(benchmark::State& state) {
+    MappedFile file(largeFile(state.range(0)).string());
+    size_t memory = 0;
+    for (auto _ : state) {
+        LineIndex index;
+        index.start(file.data(), file.size());
+        while (!index.complete()) std::this_thread::yield();
+        memory = index.memoryBytes();
+    }
+    state.SetBytesProcessed(state.iterations() * file.size());
+    state.counters["index_kb"] = (double)memory / 1024;
+}
+
+// Random "Ng" jumps once the index is complete
+static void BM_PagerGoToLine(benchmark::State& state) {
+    Pager pager(largeFile(64).string());
+    pager.open();
+    pager.setSize(50, 160);
+    while (!pager.lineIndex().complete()) std::this_thread::yield();
+    size_t lines = pager.lineIndex().lineCount();
+    std::mt19937_64 rng(7);
+    std::string screen;
+    for (auto _ : state) {
+        pager.goToLine(rng() % lines + 1);
+        pager.render(screen);
+        benchmark::DoNotOptimize(screen.data());
+    }
+}
+BENCHMARK(BM_PagerGoToLine)->Unit(benchmark::kMicrosecond);
+
+// Forward search that scans the whole file without a match
+static void BM_PagerSearch(benchmark::State& state) {
+    Pager pager(largeFile(64).string());
+    pager.open();
+    pager.setSize(50, 160);
+    for (auto _ : state) {
+        pager.goTop();
+        benchmark::DoNotOptimize(pager.search("registro de ejemplo sin texto", true));
+    }
+    state.SetBytesProcessed(state.iterations() * pager.fileSize());
+}
+BENCHMARK(BM_PagerSearch)->Unit(benchmark::kMillisecond);
+
+// Sizes come from MYTERM_BENCH_FILE_MB (comma separated, e.g. "64,4096") so
+// multi-GB runs are opt-in; the default keeps the suite quick.
+void registerFileBenchmarks() {
+    const char* env = getenv("MYTERM_BENCH_FILE_MB");
+    std::stringstream sizes(env ? env : "64");
+    std::string size;
+    while (std::getline(sizes, size, ',')) {
+        if (size.empty()) continue;
+        benchmark::RegisterBenchmark("BM_ShowFileContent", BM_ShowFileContent)
+            ->Arg(std::stoll(size))
+            ->Unit(benchmark::kMillisecond)
+            ->Iterations(1);
+        benchmark::RegisterBenchmark("BM_PagerFirstScreen", BM_PagerFirstScreen)
+            ->Args({std::stoll(size), 0})
+            ->Args({std::stoll(size), 1})
+            ->ArgNames({"mb", "end"})
+            ->Unit(benchmark::kMicrosecond);
+        benchmark::RegisterBenchmark("BM_LineIndexBuild", BM_LineIndexBuild)
+            ->Arg(std::stoll(size))
+            ->Unit(benchmark::kMillisecond)
+            ->UseRealTime();
+    }
+}
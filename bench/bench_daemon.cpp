@@ -0,0 +1,127 @@
+#include "bench_util.h"
+#include "completion.h"
+#include "daemon.h"
+#include "git_status.h"
+
+#include <benchmark/benchmark.h>
+
+#include <pwd.h>
+#include <thread>
+#include <unistd.h>
+
+// Daemon served from a thread of this process on a private socket, started
+// on first use and stopped when the process exits
+class BenchDaemon {
+public:
+    BenchDaemon() : dir("daemon") {
+        setenv("MYTERM_DAEMON_SOCKET", (dir.path / "daemon.sock").c_str(), 1);
+        setenv("HOME", dir.path.c_str(), 1); // history file
+        std::ofstream history(dir.path / ".myterm_history");
+        for (int i = 0; i < 2000; ++i) history << "git commit -m \"cambio " << i << "\"\n";
+        history.close();
+        server = std::thread([] { runDaemon(); });
+        for (int attempt = 0; attempt < 500 && !client.connect(); ++attempt) usleep(2000);
+    }
+    ~BenchDaemon() {
+        client.shutdown();
+        server.join();
+    }
+
+    ScopedTempDir dir;
+    DaemonClient client;
+    std::thread server;
+};
+
+static DaemonClient* benchDaemon() {
+    static BenchDaemon daemon;
+    return daemon.client.connected() ? &daemon.client : nullptr;
+}
+
+// Connection setup as paid by every new session, with the version check
+static void BM_DaemonConnect(benchmark::State& state) {
+    if (!benchDaemon()) {
+        state.SkipWithError("daemon no disponible");
+        return;
+    }
+    DaemonClient client;
+    for (auto _ : state) benchmark::DoNotOptimize(client.connect());
+}
+BENCHMARK(BM_DaemonConnect)->Unit(benchmark::kMicrosecond);
+
+// First Tab in a large directory: readdir + sort, or the cached listing
+// mapped from the daemon's shared buffer
+static void BM_CompletionListing(benchmark::State& state) {
+    std::string dir = syntheticDirectory(state.range(0)).string();
+    DaemonClient* daemon = benchDaemon();
+    bool useDaemon = state.range(1);
+    if (useDaemon && !daemon) {
+        state.SkipWithError("daemon no disponible");
+        return;
+    }
+    std::vector<CompletionEntry> entries;
+    for (auto _ : state) {
+        if (useDaemon) daemon->listDirectory(dir, entries);
+        else entries = listCompletionEntries(dir);
+        benchmark::DoNotOptimize(entries.data());
+    }
+    state.SetLabel(useDaemon ? "daemon" : "local");
+    state.SetItemsProcessed(state.iterations() * entries.size());
+}
+BENCHMARK(BM_CompletionListing)->Args({10000, 0})->Args({10000, 1})->Unit(benchmark::kMicrosecond);
+
+// What a new session does before its first prompt and first Tab: user and
+// host, history, git status, the directory listing and the PATH commands.
+// Standalone it all comes from the disk; with the daemon from its caches.
+static void BM_ColdSessionStart(benchmark::State& state) {
+    const fs::path* repo = gitRepository(10000);
+    DaemonClient* shared = benchDaemon();
+    bool useDaemon = state.range(0);
+    if (!repo || (useDaemon && !shared)) {
+        state.SkipWithError(repo ? "daemon no disponible" : "git no disponible");
+        return;
+    }
+    ScopedCwd cwd(*repo);
+    std::string dir = repo->string();
+    std::string history = (fs::path(getHomeDirectory()) / ".myterm_history").string();
+    const char* pathVar = getenv("PATH");
+    std::string path = pathVar ? pathVar : "";
+
+    std::string user, host;
+    std::vector<std::string> lines, commands;
+    std::vector<CompletionEntry> entries;
+    GitStatus status;
+    if (useDaemon) {
+        // The first request only starts filling the daemon's entry
+        bool found;
+        for (int attempt = 0; attempt < 500 && !shared->gitStatus(dir, found, status); ++attempt) usleep(10000);
+    }
+    for (auto _ : state) {
+        if (useDaemon) {
+            DaemonClient client;
+            bool found;
+            client.connect();
+            client.userInfo(user, host);
+            client.loadHistory(1000, lines);
+            client.gitStatus(dir, found, status);
+            client.listDirectory(dir, entries);
+            client.pathCommands(path, commands);
+        } else {
+            struct passwd* pw = getpwuid(getuid());
+            char hostname[256];
+            gethostname(hostname, sizeof(hostname));
+            user = pw ? pw->pw_name : "";
+            host = hostname;
+            readHistoryFile(history, 1000, lines);
+            GitRepository location;
+            status = GitStatus();
+            if (findGitRepository(dir, location)) readGitStatus(location, status);
+            entries = listCompletionEntries(dir);
+            ExecutableIndex executables;
+            executables.refresh(path);
+            commands = executables.names();
+        }
+        benchmark::DoNotOptimize(commands.data());
+    }
+    state.SetLabel(useDaemon ? "daemon" : "local");
+}
+BENCHMARK(BM_ColdSessionStart)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,79 @@
+#include "bench_util.h"
+#include "frecency.h"
+
+#include <benchmark/benchmark.h>
+
+#include <ctime>
+#include <random>
+
+// `count` real directories (lookups check that the winner exists) visited
+// with a skewed distribution, saved as a frecency store. Built once.
+static const fs::path& frecencyStore(size_t count) {
+    static std::map<size_t, std::unique_ptr<ScopedTempDir>> cache;
+    auto& dir = cache[count];
+    if (!dir) {
+        dir = std::make_unique<ScopedTempDir>("frecency" + std::to_string(count));
+        FrecencyIndex index;
+        index.load((dir->path / "dirs").string());
+        index.setMaxAge(1e9);
+        std::mt19937 rng(3);
+        int64_t now = (int64_t)std::time(nullptr);
+        char name[64];
+        for (size_t i = 0; i < count; ++i) {
+            snprintf(name, sizeof(name), "grupo%03zu/servicio-%06zu", i % 500, i);
+            fs::path path = dir->path / name;
+            fs::create_directories(path);
+            // A few directories get most of the visits
+            size_t visits = 1 + (i % 97 == 0 ? rng() % 200 : rng() % 3);
+            for (size_t v = 0; v < visits; ++v) index.add(path.string(), now - (int64_t)(rng() % 1000000));
+        }
+        index.save();
+    }
+    return dir->path;
+}
+
+// Startup: map the store and answer the first jump
+static void BM_FrecencyLoadAndQuery(benchmark::State& state) {
+    std::string store = (frecencyStore(state.range(0)) / "dirs").string();
+    int64_t now = (int64_t)std::time(nullptr);
+    std::string out;
+    for (auto _ : state) {
+        FrecencyIndex index;
+        index.load(store);
+        benchmark::DoNotOptimize(index.query({"servicio"}, "", now, out));
+    }
+}
+BENCHMARK(BM_FrecencyLoadAndQuery)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+// Lookups on the mapped store. "hit" matches many directories, so the rank
+// bound stops early; "rare" matches one low-ranked entry and "miss" none, so
+// both scan everything, skipping most entries by their character masks.
+static void BM_FrecencyQuery(benchmark::State& state, std::vector<std::string_view> keywords) {
+    FrecencyIndex index;
+    index.load((frecencyStore(state.range(0)) / "dirs").string());
+    int64_t now = (int64_t)std::time(nullptr);
+    std::string out;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(index.query(keywords, "", now, out));
+    }
+}
+BENCHMARK_CAPTURE(BM_FrecencyQuery, hit, {"servicio"})->Arg(100000)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_FrecencyQuery, rare, {"grupo123", "099623"})->Arg(100000)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_FrecencyQuery, miss, {"zqx"})->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+// A cd into a remembered directory, once the store is in memory
+static void BM_FrecencyAdd(benchmark::State& state) {
+    const fs::path& root = frecencyStore(state.range(0));
+    FrecencyIndex index;
+    index.load((root / "dirs").string());
+    index.setMaxAge(1e9);
+    std::mt19937 rng(5);
+    int64_t now = (int64_t)std::time(nullptr);
+    char name[64];
+    for (auto _ : state) {
+        size_t i = rng() % state.range(0);
+        snprintf(name, sizeof(name), "grupo%03zu/servicio-%06zu", i % 500, i);
+        index.add((root / name).string(), now);
+    }
+}
+BENCHMARK(BM_FrecencyAdd)->Arg(100000)->Unit(benchmark::kMicrosecond);
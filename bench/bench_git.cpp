@@ -0,0 +1,101 @@
+#include "bench_util.h"
+#include "git_index.h"
+#include "git_status.h"
+
+#include <benchmark/benchmark.h>
+
+static void BM_GitIndexLoad(benchmark::State& state) {
+    const fs::path* repo = gitRepository(state.range(0));
+    if (!repo) {
+        state.SkipWithError("git no disponible");
+        return;
+    }
+    std::string path = (*repo / ".git" / "index").string();
+    for (auto _ : state) {
+        GitIndex index;
+        benchmark::DoNotOptimize(index.load(path));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GitIndexLoad)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+// Full prompt status: staged, modified and untracked counts
+static void BM_GitStatus(benchmark::State& state) {
+    const fs::path* repo = gitRepository(state.range(0));
+    if (!repo) {
+        state.SkipWithError("git no disponible");
+        return;
+    }
+    GitRepository location;
+    findGitRepository(repo->string(), location);
+    GitStatus status;
+    for (auto _ : state) {
+        status = GitStatus();
+        readGitStatus(location, status);
+    }
+    state.counters["staged"] = (double)status.staged;
+    state.counters["modified"] = (double)status.modified;
+    state.counters["untracked"] = (double)status.untracked;
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GitStatus)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// What the prompt did before: spawn git and parse its output
+static void BM_GitStatusSpawn(benchmark::State& state) {
+    const fs::path* repo = gitRepository(state.range(0));
+    if (!repo) {
+        state.SkipWithError("git no disponible");
+        return;
+    }
+    std::string command = "git -C \"" + repo->string() + "\" status --porcelain > /dev/null";
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(std::system(command.c_str()));
+    }
+}
+BENCHMARK(BM_GitStatusSpawn)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Linear history of `commits` commits with the branch one commit ahead of
+// its upstream (a local branch, so no remote is needed)
+static const fs::path* aheadRepository(size_t commits) {
+    static std::map<size_t, std::unique_ptr<ScopedTempDir>> cache;
+    auto& dir = cache[commits];
+    if (!dir) {
+        dir = std::make_unique<ScopedTempDir>("ahead" + std::to_string(commits));
+        std::string stream;
+        for (size_t i = 1; i <= commits; ++i) {
+            std::string message = "c" + std::to_string(i);
+            stream += "commit refs/heads/main\nmark :" + std::to_string(i) + "\ncommitter bench <bench@localhost> " +
+                      std::to_string(1000000000 + i) + " +0000\ndata " + std::to_string(message.size()) + "\n" + message + "\n";
+            if (i > 1) stream += "from :" + std::to_string(i - 1) + "\n";
+            if (i == commits - 1) stream += "\nreset refs/heads/base\nfrom :" + std::to_string(i) + "\n";
+            stream += "\n";
+        }
+        std::ofstream(dir->path / "history") << stream;
+        std::string git = "git -C \"" + dir->path.string() + "\" ";
+        if (std::system((git + "init -q -b main && " + git + "fast-import --quiet < \"" + (dir->path / "history").string() +
+                         "\" && " + git + "config branch.main.remote . && " + git + "config branch.main.merge refs/heads/base")
+                            .c_str()) != 0) {
+            return nullptr;
+        }
+    }
+    return &dir->path;
+}
+
+// Prompt status when the branch has a long history behind its upstream
+static void BM_GitAheadBehind(benchmark::State& state) {
+    const fs::path* repo = aheadRepository(state.range(0));
+    if (!repo) {
+        state.SkipWithError("git no disponible");
+        return;
+    }
+    GitRepository location;
+    findGitRepository(repo->string(), location);
+    GitStatus status;
+    for (auto _ : state) {
+        status = GitStatus();
+        readGitStatus(location, status);
+    }
+    state.counters["ahead"] = status.ahead;
+    state.counters["behind"] = status.behind;
+}
+BENCHMARK(BM_GitAheadBehind)->Arg(3001)->Arg(20000)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,54 @@
+#include "bench_util.h"
+#include "glob.h"
+
+#include <benchmark/benchmark.h>
+
+// Build-tree-like layout: `dirs` directories spread over 3 levels, each with
+// 50 .cpp and 50 .o files
+static const fs::path& buildTree(size_t dirs) {
+    static std::map<size_t, std::unique_ptr<ScopedTempDir>> cache;
+    auto& dir = cache[dirs];
+    if (!dir) {
+        dir = std::make_unique<ScopedTempDir>("tree" + std::to_string(dirs));
+        for (size_t d = 0; d < dirs; ++d) {
+            fs::path sub = dir->path / ("m" + std::to_string(d % 8)) / ("s" + std::to_string(d % 64)) / ("d" + std::to_string(d));
+            fs::create_directories(sub);
+            for (int f = 0; f < 50; ++f) {
+                std::ofstream(sub / ("f" + std::to_string(f) + ".cpp"));
+                std::ofstream(sub / ("f" + std::to_string(f) + ".o"));
+            }
+        }
+    }
+    return dir->path;
+}
+
+static void BM_GlobFlat(benchmark::State& state) {
+    ScopedCwd cwd(syntheticDirectory(state.range(0)));
+    GlobPattern pattern("file_00042*.txt");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(pattern.expand());
+    }
+}
+BENCHMARK(BM_GlobFlat)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+// **/*.o over 100 files per directory
+static void BM_GlobRecursive(benchmark::State& state) {
+    ScopedCwd cwd(buildTree(state.range(0)));
+    GlobPattern pattern("**/*.o");
+    size_t found = 0;
+    for (auto _ : state) {
+        found = pattern.expand().size();
+    }
+    state.counters["matches"] = (double)found;
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 100);
+}
+BENCHMARK(BM_GlobRecursive)->Arg(200)->Arg(2000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_GlobSegmentMatch(benchmark::State& state) {
+    GlobSegment segment("*[0-9]_test.cpp");
+    const std::string names[] = {"parser_1_test.cpp", "parser_test.cpp", "main.cpp", "x9_test.cpp"};
+    for (auto _ : state) {
+        for (const auto& name : names) benchmark::DoNotOptimize(segment.matches(name));
+    }
+}
+BENCHMARK(BM_GlobSegmentMatch);
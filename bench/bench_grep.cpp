@@ -0,0 +1,123 @@
+#include "bench_util.h"
+#include "grep.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <regex>
+
+// Source-like text: identifiers, punctuation and a rare marker every ~64 KB
+static const std::string& sampleText() {
+    static std::string text;
+    if (text.empty()) {
+        const std::string line = "    for (size_t i = 0; i < tokens.size(); ++i) result.push_back(std::string(tokens[i]));\n";
+        while (text.size() < (4 << 20)) {
+            text += line;
+            if (text.size() % (64 << 10) < line.size()) text += "    // FIXME_RARO revisar este caso\n";
+        }
+    }
+    return text;
+}
+
+// `files` files of 1 MB spread over 10 directories
+static const fs::path& sourceTree(size_t files) {
+    static std::map<size_t, std::unique_ptr<ScopedTempDir>> cache;
+    auto& dir = cache[files];
+    if (!dir) {
+        dir = std::make_unique<ScopedTempDir>("grep" + std::to_string(files));
+        const std::string& text = sampleText();
+        for (size_t i = 0; i < files; ++i) {
+            fs::path sub = dir->path / ("m" + std::to_string(i % 10));
+            fs::create_directories(sub);
+            std::ofstream(sub / ("f" + std::to_string(i) + ".cpp"), std::ios::binary).write(text.data(), 1 << 20);
+        }
+    }
+    return dir->path;
+}
+
+static void BM_LiteralFinder(benchmark::State& state) {
+    const std::string& text = sampleText();
+    LiteralFinder finder("FIXME_RARO_NO", state.range(0) != 0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(finder.find(text.data(), text.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_LiteralFinder)->ArgName("icase")->Arg(0)->Arg(1);
+
+// Baseline for the filter above
+static void BM_LiteralStdSearch(benchmark::State& state) {
+    const std::string& text = sampleText();
+    const std::string needle = "FIXME_RARO_NO";
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(text.find(needle));
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_LiteralStdSearch);
+
+static void runTree(benchmark::State& state, const char* pattern, GrepOptions options) {
+    const fs::path& tree = sourceTree(state.range(0));
+    options.recursive = true;
+    GrepMatcher matcher(pattern, options);
+    GrepColors colors;
+    std::ostringstream out;
+    for (auto _ : state) {
+        out.str("");
+        runGrep(matcher, {tree.string()}, options, colors, out);
+    }
+    state.SetBytesProcessed(state.iterations() * (state.range(0) << 20));
+}
+
+static void BM_GrepTreeLiteral(benchmark::State& state) {
+    GrepOptions options;
+    options.fixed = true;
+    runTree(state, "FIXME_RARO", options);
+}
+BENCHMARK(BM_GrepTreeLiteral)->Arg(64)->Arg(512)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Regex with a required literal ("RARO"): the regex only runs on candidate lines
+static void BM_GrepTreeRegex(benchmark::State& state) {
+    GrepOptions options;
+    options.extended = true;
+    runTree(state, "FIX[A-Z]+_RARO [a-z]+", options);
+}
+BENCHMARK(BM_GrepTreeRegex)->Arg(64)->Arg(512)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// No required literal, so the regex runs on every line of the sample
+static const char* const LINE_PATTERN = "[a-z]+\\[[a-z]+\\]\\)+;$";
+
+static void BM_RegexEveryLine(benchmark::State& state) {
+    const std::string& text = sampleText();
+    LineRegex regex;
+    std::string error;
+    regex.compile(LINE_PATTERN, true, false, error);
+    for (auto _ : state) {
+        size_t hits = 0;
+        for (size_t pos = 0; pos < text.size();) {
+            size_t end = text.find('\n', pos);
+            hits += regex.matches(text.data() + pos, end - pos);
+            pos = end + 1;
+        }
+        benchmark::DoNotOptimize(hits);
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_RegexEveryLine)->Unit(benchmark::kMillisecond);
+
+// What grep used before: std::regex, which recurses once per input byte
+static void BM_RegexEveryLineStd(benchmark::State& state) {
+    const std::string& text = sampleText();
+    std::regex regex(LINE_PATTERN, std::regex::extended);
+    for (auto _ : state) {
+        size_t hits = 0;
+        for (size_t pos = 0; pos < text.size();) {
+            size_t end = text.find('\n', pos);
+            hits += std::regex_search(text.data() + pos, text.data() + end, regex);
+            pos = end + 1;
+        }
+        benchmark::DoNotOptimize(hits);
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_RegexEveryLineStd)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,119 @@
+#include "bench_util.h"
+
+#include <benchmark/benchmark.h>
+
+// --- splitCommand ---------------------------------------------------------
+
+static void BM_SplitCommandShort(benchmark::State& state) {
+    Terminal& term = benchTerminal();
+    const std::string line = "ls -l \"mis documentos\" src";
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(term.splitCommand(line).data());
+    }
+}
+BENCHMARK(BM_SplitCommandShort);
+
+// Pasted command lines of 1 KB .. 100 KB; allocs/iter should stay at 0
+// once the tokenizer buffers have grown
+static void runSplit(benchmark::State& state, const std::string& word) {
+    Terminal& term = benchTerminal();
+    std::string line;
+    while (line.size() < (size_t)state.range(0)) line += word;
+    term.splitCommand(line);
+
+    size_t before = heapAllocations();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(term.splitCommand(line).data());
+    }
+    state.counters["allocs/iter"] = benchmark::Counter((double)(heapAllocations() - before) / state.iterations());
+    state.SetBytesProcessed(state.iterations() * line.size());
+}
+
+static void BM_SplitCommandPastedPlain(benchmark::State& state) {
+    runSplit(state, "argumento --opcion=valor ruta/al/archivo.txt ");
+}
+BENCHMARK(BM_SplitCommandPastedPlain)->Arg(1 << 10)->Arg(100 << 10);
+
+static void BM_SplitCommandPastedQuoted(benchmark::State& state) {
+    runSplit(state, "\"con espacios\" 'literal $X' escapado\\ total $HOME/dir ");
+}
+BENCHMARK(BM_SplitCommandPastedQuoted)->Arg(1 << 10)->Arg(100 << 10);
+
+// --- Tab completion -------------------------------------------------------
+
+static void runCompletion(benchmark::State& state, const std::string& prefix) {
+    Terminal& term = benchTerminal();
+    ScopedCwd cwd(syntheticDirectory(state.range(0)));
+    NullOutput out;
+    for (auto _ : state) {
+        std::string line = "cat " + prefix;
+        size_t cursor = line.size();
+        term.handleTabCompletion(line, cursor);
+        benchmark::DoNotOptimize(line);
+    }
+    state.counters["bytes_out/iter"] = benchmark::Counter((double)out.bytes / state.iterations());
+}
+
+static void BM_TabCompletionUnique(benchmark::State& state) {
+    runCompletion(state, "file_0004242");
+}
+BENCHMARK(BM_TabCompletionUnique)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+// ~1% of the entries match and get listed
+static void BM_TabCompletionAmbiguous(benchmark::State& state) {
+    runCompletion(state, state.range(0) >= 100000 ? "file_00042" : "file_000042");
+}
+BENCHMARK(BM_TabCompletionAmbiguous)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+// --- Prompt ---------------------------------------------------------------
+
+// Prompt rendered N directories below the root of a git repository
+static void BM_ShowPromptDeepGitTree(benchmark::State& state) {
+    Terminal& term = benchTerminal();
+    ScopedTempDir repo("git");
+    fs::create_directories(repo.path / ".git" / "refs" / "heads");
+    std::ofstream(repo.path / ".git" / "HEAD") << "ref: refs/heads/main\n";
+
+    fs::path deep = repo.path;
+    for (int64_t i = 0; i < state.range(0); ++i) deep /= "nivel" + std::to_string(i);
+    fs::create_directories(deep);
+
+    ScopedCwd cwd(deep);
+    NullOutput out;
+    for (auto _ : state) {
+        term.refreshPromptInfo();
+        term.showPrompt();
+    }
+    state.counters["bytes_out/iter"] = benchmark::Counter((double)out.bytes / state.iterations());
+}
+BENCHMARK(BM_ShowPromptDeepGitTree)->Arg(1)->Arg(16)->Arg(64);
+
+// Redraw while typing: cached git segment, compiled template, one write
+static void BM_PromptRedraw(benchmark::State& state) {
+    Terminal& term = benchTerminal();
+    term.refreshPromptInfo();
+    NullOutput out;
+    size_t before = heapAllocations();
+    for (auto _ : state) term.showPrompt();
+    state.counters["allocs/iter"] = benchmark::Counter((double)(heapAllocations() - before) / state.iterations());
+    state.counters["bytes_out/iter"] = benchmark::Counter((double)out.bytes / state.iterations());
+}
+BENCHMARK(BM_PromptRedraw);
+
+// Template render alone: prebaked spans and slots appended into a reused buffer
+static void BM_PromptTemplateRender(benchmark::State& state) {
+    Theme theme{rgb(46, 204, 113), rgb(52, 152, 219), rgb(241, 196, 15)};
+    PromptTemplate prompt;
+    std::string error;
+    prompt.compile(PromptTemplate::DEFAULT, theme, error);
+    PromptTemplate::Slots slots = {"usuario", "maquina", "~/proyectos/myterm/src", " (main +1 ~2 ?3)", " [12ms]"};
+    std::string buffer;
+    size_t before = heapAllocations();
+    for (auto _ : state) {
+        buffer.clear();
+        prompt.render(slots, buffer);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.counters["allocs/iter"] = benchmark::Counter((double)(heapAllocations() - before) / state.iterations());
+}
+BENCHMARK(BM_PromptTemplateRender);
@@ -0,0 +1,117 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <streambuf>
+#include <string>
+
+#include "terminal.h"
+
+namespace fs = std::filesystem;
+
+// Directorio temporal que se borra al destruirse
+class ScopedTempDir {
+public:
+    explicit ScopedTempDir(const std::string& tag) {
+        path = fs::temp_directory_path() / ("myterm-bench-" + tag + "-" + std::to_string(std::rand()));
+        fs::create_directories(path);
+    }
+    ~ScopedTempDir() {
+        std::error_code ec;
+        fs::remove_all(path, ec);
+    }
+    ScopedTempDir(const ScopedTempDir&) = delete;
+    ScopedTempDir& operator=(const ScopedTempDir&) = delete;
+
+    fs::path path;
+};
+
+// Discards everything written to std::cout while alive, counting the bytes
+class NullOutput : public std::streambuf {
+public:
+    NullOutput() : previous(std::cout.rdbuf(this)) {}
+    ~NullOutput() override { std::cout.rdbuf(previous); }
+
+    size_t bytes = 0;
+
+protected:
+    int overflow(int c) override {
+        bytes++;
+        return c == EOF ? 0 : c;
+    }
+    std::streamsize xsputn(const char*, std::streamsize n) override {
+        bytes += n;
+        return n;
+    }
+
+private:
+    std::streambuf* previous;
+};
+
+// Restores the working directory on scope exit
+class ScopedCwd {
+public:
+    explicit ScopedCwd(const fs::path& dir) : previous(fs::current_path()) { fs::current_path(dir); }
+    ~ScopedCwd() { fs::current_path(previous); }
+
+private:
+    fs::path previous;
+};
+
+// Number of operator new calls so far (defined in bench_main.cpp)
+size_t heapAllocations();
+
+// One Terminal per process, as in the real shell
+inline Terminal& benchTerminal() {
+    static Terminal terminal;
+    return terminal;
+}
+
+// Directory with `count` empty files named file_0000000.txt ... plus 16
+// subdirectories. Built once per size and removed when the process exits.
+inline const fs::path& syntheticDirectory(size_t count) {
+    static std::map<size_t, std::unique_ptr<ScopedTempDir>> cache;
+    auto& dir = cache[count];
+    if (!dir) {
+        dir = std::make_unique<ScopedTempDir>("dir" + std::to_string(count));
+        char name[32];
+        for (size_t i = 0; i < count; ++i) {
+            snprintf(name, sizeof(name), "file_%07zu.txt", i);
+            std::ofstream(dir->path / name);
+        }
+        for (int i = 0; i < 16; ++i) fs::create_directory(dir->path / ("dir_" + std::to_string(i)));
+    }
+    return dir->path;
+}
+
+// Committed repository with `files` files in 100-file directories, one
+// modified file, one staged file and one untracked file. Needs git on PATH.
+inline const fs::path* gitRepository(size_t files) {
+    static std::map<size_t, std::unique_ptr<ScopedTempDir>> cache;
+    auto& dir = cache[files];
+    if (!dir) {
+        dir = std::make_unique<ScopedTempDir>("repo" + std::to_string(files));
+        for (size_t i = 0; i < files; ++i) {
+            fs::path sub = dir->path / ("d" + std::to_string(i / 100));
+            if (i % 100 == 0) fs::create_directories(sub);
+            std::ofstream(sub / ("f" + std::to_string(i) + ".txt")) << i << "\n";
+        }
+        std::string git = "git -C \"" + dir->path.string() + "\" -c user.name=bench -c user.email=bench@localhost ";
+        if (std::system((git + "init -q && " + git + "add -A && " + git + "commit -qm init && " +
+                         git + "status --porcelain > /dev/null").c_str()) != 0) {
+            return nullptr;
+        }
+        std::ofstream(dir->path / "d0" / "f0.txt") << "modificado\n";
+        std::ofstream(dir->path / "d1" / "f100.txt") << "preparado\n";
+        std::ofstream(dir->path / "nuevo.txt") << "sin seguimiento\n";
+        std::system((git + "add d1/f100.txt").c_str());
+    }
+    return &dir->path;
+}
+
+#endif // BENCH_UTIL_H
@@ -1 +1 @@
-g++ -std=c++17 -Iinclude -o myterm.exe src/main.cpp src/terminal.cpp src/commands.cpp src/ui.cpp src/utils.cpp
\ No newline at end of file
+g++ -std=c++17 -Iinclude -o myterm.exe src/main.cpp src/terminal.cpp src/commands.cpp src/ui.cpp src/utils.cpp src/stats.cpp src/trace.cpp src/tokenizer.cpp src/glob.cpp src/thread_pool.cpp src/git_objects.cpp src/git_index.cpp src/git_status.cpp src/line_regex.cpp src/grep.cpp src/pager.cpp src/frecency.cpp src/completion.cpp src/daemon.cpp src/config.cpp
\ No newline at end of file
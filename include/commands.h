@@ -3,19 +3,32 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
+
+#include "utils.h"
 
 class Terminal; // Forward declaration
 
-void listDirectory(Terminal& term, const std::vector<std::string>& tokens);
-void changeDirectory(Terminal& term, const std::string& path);
-void makeDirectory(const std::string& name);
-void removeDirectory(const std::string& name);
-void createFile(const std::string& name);
-void removeFile(const std::string& name);
-void showFileContent(const std::string& name);
+int listDirectory(Terminal& term, const std::vector<std::string_view>& tokens);
+int changeDirectory(Terminal& term, const std::string& path);
+int jumpDirectory(Terminal& term, const std::vector<std::string_view>& tokens);
+int pushDirectory(Terminal& term, const std::vector<std::string_view>& tokens);
+int popDirectory(Terminal& term);
+void showDirectoryStack(Terminal& term, const std::vector<std::string_view>& tokens);
+int makeDirectory(const std::string& name);
+int removeDirectory(const std::string& name);
+int createFile(const std::string& name);
+int removeFile(const std::string& name);
+int showFileContent(const std::string& name);
 void clearScreen();
-void executeGitCommand(const std::vector<std::string>& tokens);
-void changeTheme(Terminal& term, const std::string& themeName);
+int executeGitCommand(const std::vector<std::string_view>& tokens, ResourceUsage* usage);
+int changeTheme(Terminal& term, const std::string& themeName);
+int traceCommand(const std::vector<std::string_view>& tokens);
+int grepCommand(Terminal& term, const std::vector<std::string_view>& tokens);
+int pagerCommand(const std::vector<std::string_view>& tokens);
+int daemonCommand(Terminal& term, const std::vector<std::string_view>& tokens);
+int aliasCommand(Terminal& term, const std::vector<std::string_view>& tokens);
+int configCommand(Terminal& term, const std::vector<std::string_view>& tokens);
 
 
 #endif // COMMANDS_H
\ No newline at end of file
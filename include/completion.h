@@ -0,0 +1,39 @@
+#ifndef COMPLETION_H
+#define COMPLETION_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Tab completion candidates, shared by the session and the daemon
+struct CompletionEntry {
+    std::string name;
+    bool isDir; // symlinks to directories count as directories
+};
+
+// Entries of `dir` sorted by name; "" is the current directory
+std::vector<CompletionEntry> listCompletionEntries(const std::string& dir);
+
+// Executables found in the directories of a PATH value, sorted and without
+// duplicates. refresh() only rescans when PATH changed or one of its
+// directories was modified since the last scan.
+class ExecutableIndex {
+public:
+    // True if the names were rebuilt
+    bool refresh(const std::string& pathVar);
+    const std::vector<std::string>& names() const { return commands; }
+
+private:
+    std::string path;
+    std::vector<std::pair<std::string, int64_t>> dirs; // directory, mtime in ns
+    bool racy = true; // a directory changed too recently to trust its mtime
+    std::vector<std::string> commands;
+};
+
+// Directory mtimes have the granularity of the kernel clock tick, so a
+// listing taken within this window of the last change may miss a second
+// change that kept the same mtime; such listings are never reused.
+constexpr int64_t RACY_WINDOW_NS = 2000000000;
+
+#endif // COMPLETION_H
@@ -0,0 +1,97 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct Theme {
+    std::string user_host;
+    std::string directory;
+    std::string branch;
+};
+
+// Prompt layout, compiled once per config load or theme change into a flat
+// list of ops over one byte string: every literal, color code and theme
+// color between two slots is a single prebaked span, so drawing the prompt
+// is one pass of appends into a reused buffer and one write.
+//
+// Template syntax: {user} {host} {path} {git} {duration} are filled on each
+// draw; {user_color} {path_color} {git_color} are the theme colors;
+// {reset} {bold} {dim} {red} {green} {yellow} {blue} {magenta} {cyan}
+// {white} {gray} and {#rrggbb} are fixed colors; {if slot}...{end} is only
+// drawn when that slot is not empty; {{ is a literal '{'.
+class PromptTemplate {
+public:
+    enum Slot : uint8_t { USER, HOST, PATH, GIT, DURATION, SLOT_COUNT };
+    using Slots = std::array<std::string_view, SLOT_COUNT>;
+
+    static const char* const DEFAULT; // the classic user@host:path (git)$
+
+    PromptTemplate();
+
+    // On error the template is left unchanged
+    bool compile(std::string_view text, const Theme& theme, std::string& error);
+    // Appends the prompt to `out`
+    void render(const Slots& slots, std::string& out) const;
+
+private:
+    enum class OpType : uint8_t { Text, Slot, If };
+    struct Op {
+        OpType type;
+        uint8_t slot;
+        uint32_t offset; // Text: start in bytes
+        uint32_t length; // Text: span length; If: index of the op after {end}
+    };
+
+    std::string bytes;
+    std::vector<Op> ops;
+};
+
+// ~/.myterm.conf (or $MYTERM_CONFIG): one `key = value` per line, '#' for
+// comments, values in double quotes to keep spaces or use \e \n \" \\.
+//
+//   prompt = "{user_color}{user}{reset} {path_color}{path}{git_color}{git}{reset} > "
+//   theme = oceano
+//   theme oceano = #00aaff #1e90ff 255,215,0      (user, path, git colors)
+//   alias ll = ls -l
+//   history_size = 5000
+//   dir_max_age = 20000
+struct Config {
+    std::string prompt = PromptTemplate::DEFAULT;
+    std::string theme; // empty: keep the current one
+    std::map<std::string, Theme> themes;
+    std::map<std::string, std::string> aliases;
+    size_t historySize = 1000;
+    double dirMaxAge = 0; // 0: FrecencyIndex default
+    std::vector<std::string> errors; // "linea N: ..."
+};
+
+// False if the file does not exist (`out` keeps the defaults)
+bool loadConfig(const std::string& path, Config& out);
+
+// Tells when the config file was written, created, replaced or removed:
+// inotify on its directory where available, an mtime check otherwise.
+class ConfigWatcher {
+public:
+    ConfigWatcher() = default;
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    void watch(const std::string& path);
+    // True if the file changed since the previous call; never blocks
+    bool changed();
+
+private:
+    std::string path;
+    std::string name;
+    int fd = -1;
+    int64_t mtime = -1;
+};
+
+#endif // CONFIG_H
@@ -0,0 +1,110 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "completion.h"
+#include "git_status.h"
+
+// Optional per-user cache server (`myterm --daemon`, or the `daemon start`
+// builtin). It keeps what every new session would otherwise rebuild from
+// scratch: user and host names, PATH executables, directory listings for
+// Tab, git status per worktree and the shared history. Sessions connect to
+// it on startup and fall back to doing the work themselves, without any
+// message, whenever it is not running or stops answering.
+//
+// Protocol: every request and response is a 12-byte header followed by
+// `length` payload bytes. Integers are in host byte order (both ends run on
+// the same machine); strings are a u32 length and the bytes. Responses of
+// SHARED_MIN bytes or more travel in a sealed memfd passed with the header
+// (SCM_RIGHTS) instead of through the socket: the client maps it read-only,
+// and the daemon hands the same buffer to every client until the cached
+// data changes.
+namespace DaemonProtocol {
+    constexpr uint32_t MAGIC = 0x3144544d; // "MTD1"; bumped with any wire change
+    constexpr size_t SHARED_MIN = 4096;
+    constexpr size_t MAX_INLINE = 1 << 20;
+
+    enum Request : uint16_t {
+        HELLO = 1,       // -> u32 pid
+        USER_INFO,       // -> str user, str host
+        LIST_DIRECTORY,  // str dir -> u32 count, {u8 isDir, str name}...
+        PATH_COMMANDS,   // str PATH -> u32 count, str name...
+        GIT_STATUS,      // str dir -> u8 found [, status fields]
+        HISTORY_LOAD,    // u32 max -> u32 count, str line...
+        HISTORY_APPEND,  // str line -> nothing
+        STATS,           // -> DaemonStats fields
+        SHUTDOWN,        // -> nothing, then the daemon exits
+    };
+
+    enum Status : uint16_t { OK = 0, FAILED = 1 };
+    constexpr uint16_t FLAG_SHARED = 1; // payload is in the attached memfd
+
+    struct Header {
+        uint32_t magic;
+        uint16_t type;   // Request, or Status in responses
+        uint16_t flags;
+        uint32_t length;
+    };
+    static_assert(sizeof(Header) == 12, "wire header");
+}
+
+struct DaemonStats {
+    uint32_t pid = 0;
+    uint32_t clients = 0;
+    uint64_t uptimeSeconds = 0;
+    uint64_t requests = 0;
+    uint64_t hits = 0;     // answered from a cache
+    uint64_t misses = 0;   // had to read the disk
+    uint64_t sharedBytes = 0; // held in shared buffers
+};
+
+// Session side of the protocol. Every call returns false on any failure and
+// then disconnects, so the caller simply does the work locally.
+class DaemonClient {
+public:
+    DaemonClient() = default;
+    ~DaemonClient() { disconnect(); }
+
+    DaemonClient(const DaemonClient&) = delete;
+    DaemonClient& operator=(const DaemonClient&) = delete;
+
+    // Connects to socketPath(); false right away if no daemon is listening
+    bool connect();
+    void disconnect();
+    bool connected() const { return fd >= 0; }
+
+    bool hello(uint32_t& pid);
+    bool userInfo(std::string& user, std::string& host);
+    bool listDirectory(const std::string& dir, std::vector<CompletionEntry>& out);
+    bool pathCommands(const std::string& pathVar, std::vector<std::string>& out);
+    bool gitStatus(const std::string& dir, bool& found, GitStatus& out);
+    bool loadHistory(size_t max, std::vector<std::string>& out);
+    bool appendHistory(const std::string& line);
+    bool stats(DaemonStats& out);
+    bool shutdown();
+
+private:
+    class Reply;
+    bool call(uint16_t type, std::string_view payload, Reply& reply);
+
+    int fd = -1;
+};
+
+// $MYTERM_DAEMON_SOCKET, else $XDG_RUNTIME_DIR/myterm-daemon.sock, else
+// /tmp/myterm-<uid>/daemon.sock
+std::string daemonSocketPath();
+
+// Serves until SHUTDOWN, SIGTERM or an hour without clients; returns the
+// process exit status
+int runDaemon();
+
+// Starts `myterm --daemon` detached from this session and waits until it
+// accepts connections
+bool spawnDaemon(uint32_t& pid);
+
+#endif // DAEMON_H
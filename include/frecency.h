@@ -0,0 +1,117 @@
+#ifndef FRECENCY_H
+#define FRECENCY_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "utils.h"
+
+struct FrecencyMatch {
+    std::string path;
+    double score = 0;
+};
+
+// Directories visited with cd, ranked by frecency like zoxide: every visit
+// adds 1 to the rank, and the score weighs it by how recent the last visit
+// was (x4 within the hour, x2 the same day, /2 the same week, /4 older).
+//
+// The store is a flat binary file (header, fixed-size columns, path pool)
+// sorted by rank. load() only maps it; lookups read the mapping directly and stop
+// as soon as no remaining entry can beat the best score found (rank x4),
+// usually after a handful of entries. On the first change the entries are
+// copied into memory, grouped in power-of-two rank buckets that give the
+// same early exit while a visit, insert or removal stays O(1). Each record
+// also carries a bitmask of the characters in its last path component, so
+// entries that cannot match are skipped without touching their path.
+//
+// Aging is a global scale factor instead of a pass over every entry: when
+// the ranks add up to more than the maximum age the scale shrinks by 10% and
+// only the lowest buckets are searched for entries that fell below 1.
+// Directories that no longer exist are found a few at a time, round-robin,
+// on each visit.
+class FrecencyIndex {
+public:
+    static constexpr double DEFAULT_MAX_AGE = 10000; // as in zoxide; also bounds the entry count
+    static constexpr unsigned SAVE_EVERY = 16;      // visits between saves
+    static constexpr unsigned EXISTENCE_CHECKS = 2; // entries checked per visit
+
+    // Maps `path`; a missing or invalid file is an empty index
+    bool load(const std::string& path);
+    // Writes the index (temporary file + rename) if it changed, holding the
+    // file's flock. If another session saved it since load() or our last
+    // save, its file is loaded again and this session's visits and removals
+    // are replayed on top, so neither loses the other's.
+    bool save();
+
+    // Records a visit (in memory; see save())
+    void add(const std::string& dir, int64_t now);
+    bool remove(std::string_view dir);
+
+    // Best existing directory other than `exclude` whose path contains the
+    // keywords in order, case-insensitively, the last one within the last
+    // component. Entries found missing along the way are removed.
+    bool query(const std::vector<std::string_view>& keywords, std::string_view exclude, int64_t now, std::string& out);
+
+    // Highest scores first
+    std::vector<FrecencyMatch> top(size_t count, int64_t now) const;
+
+    size_t size() const { return loaded ? entries.size() : mappedCount; }
+    void setMaxAge(double value) { maxAge = value; }
+    unsigned pendingChanges() const { return changes; }
+
+private:
+    struct Entry {
+        std::string path;
+        double rank; // times the current scale
+        int64_t lastAccess;
+        uint64_t mask; // characters of the last component
+        uint32_t bucket;
+        uint32_t slot; // position in buckets[bucket]
+    };
+
+    std::string_view pathAt(size_t i) const;
+    double rankAt(size_t i) const;
+    int64_t lastAccessAt(size_t i) const;
+    uint64_t maskAt(size_t i) const;
+    void materialize();
+    void removeAt(size_t i);
+    void place(size_t i);
+    void unplace(size_t i);
+    void age();
+    void checkExistence();
+    bool write();
+
+    std::string file;
+    MappedFile mapped;
+    size_t mappedCount = 0;
+    const char* records = nullptr;
+    const char* pool = nullptr;
+
+    bool loaded = false; // entries hold the data, the mapping is no longer used
+    std::vector<Entry> entries;
+    std::unordered_map<std::string, size_t> positions;
+    struct BucketItem {
+        uint64_t mask;
+        uint32_t index;
+    };
+    std::vector<BucketItem> buckets[64]; // by floor(log2(rank))
+    double maxAge = DEFAULT_MAX_AGE;
+    double scale = 1;
+    double total = 0; // sum of effective ranks
+    size_t checkCursor = 0;
+    unsigned changes = 0;
+
+    // Visits (time >= 0) and removals (time -1) not saved yet
+    struct Change {
+        std::string dir;
+        int64_t time;
+    };
+    std::vector<Change> journal;
+    int64_t fileTime = -1; // the file as last loaded or written
+    uint64_t fileSize = 0;
+};
+
+#endif // FRECENCY_H
@@ -0,0 +1,89 @@
+#ifndef GIT_INDEX_H
+#define GIT_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "git_objects.h"
+
+// Stat fields as git stores them (32-bit, truncated)
+struct GitStatData {
+    uint32_t ctimeSec = 0, ctimeNsec = 0;
+    uint32_t mtimeSec = 0, mtimeNsec = 0;
+    uint32_t dev = 0, ino = 0;
+    uint32_t uid = 0, gid = 0;
+    uint32_t size = 0;
+};
+
+struct GitIndexEntry {
+    GitStatData stat;
+    uint32_t mode = 0;
+    GitOid oid;
+    uint16_t stage = 0;
+    bool skipWorktree = false;
+    bool intentToAdd = false;
+    std::string path;
+};
+
+// TREE extension: directory -> tree id, valid only when entryCount >= 0
+struct GitCacheTreeNode {
+    int entryCount = -1;
+    GitOid oid;
+};
+
+// UNTR extension, one block per directory in depth-first order
+struct GitUntrackedDir {
+    std::string path;            // "" for the root, "src/foo/" otherwise
+    std::vector<std::string> untracked;
+    std::vector<size_t> children; // indexes into GitUntrackedCache::dirs
+    bool valid = false;
+    bool checkOnly = false;
+    bool hasStat = false;
+    GitStatData stat;             // the directory itself
+    bool hasExcludeOid = false;
+    GitOid excludeOid;            // its .gitignore blob
+};
+
+struct GitUntrackedCache {
+    std::string ident;
+    GitStatData infoExcludeStat;
+    GitStatData excludesFileStat;
+    uint32_t dirFlags = 0;
+    GitOid infoExcludeOid;
+    GitOid excludesFileOid;
+    std::string excludePerDir;
+    std::vector<GitUntrackedDir> dirs;
+};
+
+// lstat() (statx on Linux when available) in git's representation;
+// mode receives st_mode
+bool gitLstat(const char* path, GitStatData& out, uint32_t& mode);
+
+// Reader for .git/index versions 2 to 4
+class GitIndex {
+public:
+    bool load(const std::string& path);
+
+    std::vector<GitIndexEntry> entries; // sorted by path, then stage
+    std::unordered_map<std::string, GitCacheTreeNode> cacheTree; // "" is the root
+    bool hasUntrackedCache = false;
+    GitUntrackedCache untrackedCache;
+    uint32_t version = 0;
+
+    // Index file mtime, to detect "racily clean" entries
+    uint32_t mtimeSec = 0;
+    uint32_t mtimeNsec = 0;
+
+    // Entries in [first, last) whose path starts with `prefix`
+    std::pair<size_t, size_t> range(std::string_view prefix) const;
+    const GitIndexEntry* find(std::string_view path) const;
+
+private:
+    bool parseCacheTree(const uint8_t* p, const uint8_t* end);
+    bool parseUntracked(const uint8_t* p, const uint8_t* end);
+};
+
+#endif // GIT_INDEX_H
@@ -0,0 +1,78 @@
+#ifndef GIT_OBJECTS_H
+#define GIT_OBJECTS_H
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "utils.h"
+
+struct GitOid {
+    uint8_t bytes[20] = {};
+
+    bool operator==(const GitOid& other) const { return std::memcmp(bytes, other.bytes, 20) == 0; }
+    bool operator!=(const GitOid& other) const { return !(*this == other); }
+    bool isNull() const;
+    std::string hex() const;
+
+    static bool fromHex(std::string_view hex, GitOid& out);
+    static GitOid fromRaw(const void* raw);
+};
+
+struct GitOidHash {
+    size_t operator()(const GitOid& oid) const {
+        size_t h;
+        std::memcpy(&h, oid.bytes, sizeof(h));
+        return h;
+    }
+};
+
+// Incremental SHA-1, only used to hash blobs for racy or touched files
+class Sha1 {
+public:
+    Sha1();
+    void update(const void* data, size_t len);
+    GitOid finish();
+
+private:
+    void block(const uint8_t* chunk);
+
+    uint32_t state[5];
+    uint64_t total = 0;
+    uint8_t buffer[64];
+    size_t buffered = 0;
+};
+
+// Object id git would give to `data` stored as a blob
+GitOid hashBlob(const char* data, size_t len);
+
+enum class GitObjectType { None = 0, Commit = 1, Tree = 2, Blob = 3, Tag = 4 };
+
+// Reads loose and packed objects (pack .idx v2, ofs/ref deltas; ofs delta
+// bases are cached for the whole process, keyed by pack and offset). Requires
+// zlib; without it available() is false and every read fails.
+class GitObjectStore {
+public:
+    explicit GitObjectStore(const std::string& objectsDir);
+    ~GitObjectStore();
+
+    static bool available();
+    bool read(const GitOid& oid, GitObjectType& type, std::string& data);
+
+private:
+    struct Pack;
+
+    bool readLoose(const GitOid& oid, GitObjectType& type, std::string& data);
+    bool readPacked(const GitOid& oid, GitObjectType& type, std::string& data, int depth = 0);
+    bool readPackEntry(Pack& pack, uint64_t offset, GitObjectType& type, std::string& data, int depth);
+    void loadPacks();
+
+    std::string objectsDir;
+    std::vector<std::unique_ptr<Pack>> packs;
+    bool packsLoaded = false;
+};
+
+#endif // GIT_OBJECTS_H
@@ -0,0 +1,57 @@
+#ifndef GIT_STATUS_H
+#define GIT_STATUS_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// Repository state for the prompt, read straight from .git without
+// spawning git
+struct GitStatus {
+    std::string branch;      // short name, or abbreviated id when detached
+    std::string state;       // "REBASE", "MERGE" or ""
+    bool hasCounts = false;  // the index could be read
+    size_t staged = 0;       // HEAD tree vs index (needs zlib)
+    size_t modified = 0;     // index vs working tree
+    size_t untracked = 0;
+    bool truncated = false;  // stopped after maxChanges
+    bool hasUpstream = false;
+    int ahead = 0;
+    int behind = 0;
+    bool aheadBehindApprox = false; // the history walk hit its commit limit
+};
+
+struct GitRepository {
+    std::string worktree;  // without trailing slash
+    std::string gitDir;    // HEAD, index, rebase/merge markers
+    std::string commonDir; // refs, objects, config (differs for linked worktrees)
+};
+
+// Walks up from `start` looking for .git (directory or "gitdir:" file)
+bool findGitRepository(const std::string& start, GitRepository& repo);
+
+// Branch and state only: a couple of small reads, safe for every prompt
+bool readGitHead(const GitRepository& repo, GitStatus& out);
+
+// Branch, counts and ahead/behind. Counting stops once staged + modified +
+// untracked reaches maxChanges.
+bool readGitStatus(const GitRepository& repo, GitStatus& out, size_t maxChanges = 100);
+
+// Which worktree directories can change what readGitStatus reports: all but
+// the ignored ones (.gitignore, info/exclude, core.excludesFile) that hold
+// no tracked file. Rules and the tracked paths are read at construction,
+// .gitignore files as the directories below them are asked about.
+class GitDirectoryFilter {
+public:
+    explicit GitDirectoryFilter(const GitRepository& repo);
+    ~GitDirectoryFilter();
+
+    // `rel` is "dir/", relative to the worktree
+    bool wanted(const std::string& rel);
+
+private:
+    struct Rules;
+    std::unique_ptr<Rules> rules;
+};
+
+#endif // GIT_STATUS_H
\ No newline at end of file
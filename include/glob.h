@@ -0,0 +1,71 @@
+#ifndef GLOB_H
+#define GLOB_H
+
+#include <bitset>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Pattern for a single path component (no '/'): *, ?, [abc], [a-z], [!x]
+// and \x for a literal character. Compiled once into a flat op list with the
+// literal prefix/suffix pulled out, so most non-matching names are rejected
+// by a memcmp before the matcher runs. Wildcards skip dotfiles unless the
+// pattern starts with '.' or `dotfiles` is set (gitignore semantics).
+class GlobSegment {
+public:
+    explicit GlobSegment(std::string_view pattern, bool dotfiles = false);
+
+    bool matches(std::string_view name) const;
+    bool isLiteral() const { return literal; }
+    const std::string& text() const { return prefix; } // the name itself when isLiteral()
+
+private:
+    enum class OpType { Char, Any, Star, Class };
+    struct Op {
+        OpType type;
+        char c;
+        int classIndex;
+    };
+
+    bool matchOps(std::string_view name) const;
+
+    std::vector<Op> ops;
+    std::vector<std::bitset<256>> classes;
+    std::string prefix;
+    std::string suffix;
+    bool literal = true;
+    bool matchesDotfiles = false;
+};
+
+// Whole path pattern such as "src/**/*.cpp" or "/var/log/*.log"
+class GlobPattern {
+public:
+    explicit GlobPattern(std::string_view pattern);
+
+    // Matching paths, sorted. Recursive "**" walks run on ThreadPool::shared().
+    std::vector<std::string> expand() const;
+
+private:
+    struct Part {
+        bool recursive; // "**"
+        GlobSegment segment;
+    };
+
+    void expandFrom(const std::string& display, size_t part, std::vector<std::string>& out,
+                    std::vector<std::vector<std::string>>* perWorker) const;
+    void walkRecursive(const std::string& display, size_t part, std::vector<std::vector<std::string>>& perWorker) const;
+    void emit(const std::string& display, bool isDir, std::vector<std::string>& out) const;
+
+    std::vector<Part> parts;
+    std::string root; // literal leading directories: "", "/", "src/foo/"
+    bool hasRecursive = false;
+    bool directoriesOnly = false; // pattern ended in '/'
+};
+
+// True if the word has an unescaped *, ? or [
+bool hasGlobMeta(std::string_view word);
+
+// Removes the backslashes the tokenizer left in front of quoted metacharacters
+std::string unescapeGlob(std::string_view word);
+
+#endif // GLOB_H
@@ -0,0 +1,89 @@
+#ifndef GREP_H
+#define GREP_H
+
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "line_regex.h"
+
+struct GrepOptions {
+    bool recursive = false;   // -r
+    bool ignoreCase = false;  // -i
+    bool lineNumbers = false; // -n
+    bool fixed = false;       // -F: the pattern is a literal string
+    bool extended = false;    // -E: ERE instead of BRE
+    bool invert = false;      // -v
+    bool filesOnly = false;   // -l
+    bool countOnly = false;   // -c
+};
+
+// Case-(in)sensitive substring search built around two "rare" bytes of the
+// needle (by a fixed frequency ranking for source code and prose). It skips
+// ahead with memchr on the rarest one while hits are sparse, and switches to
+// an SSE2 filter that tests 16 positions at once for both bytes when memchr
+// keeps stopping on false positives; only positions where both agree get a
+// full comparison.
+class LiteralFinder {
+public:
+    LiteralFinder() = default;
+    LiteralFinder(std::string_view needle, bool ignoreCase);
+
+    // Offset of the first occurrence in [data, data + size), or npos
+    size_t find(const char* data, size_t size) const;
+    size_t length() const { return needle.size(); }
+    bool empty() const { return needle.empty(); }
+
+private:
+    bool equalsAt(const char* p) const;
+    size_t findVector(const char* data, size_t from, size_t lastStart) const;
+
+    std::string needle; // lowercased when ignoreCase
+    bool ignoreCase = false;
+    size_t rareOffset1 = 0, rareOffset2 = 0;
+    unsigned char rare1Lower = 0, rare1Upper = 0;
+    unsigned char rare2Lower = 0, rare2Upper = 0;
+};
+
+// One compiled pattern. Regular expressions run on a LineRegex, but only on
+// the lines that contain the literal every match needs (e.g. "error" in
+// "error [0-9]+:"), found with a LiteralFinder first.
+class GrepMatcher {
+public:
+    GrepMatcher(std::string_view pattern, const GrepOptions& options);
+
+    bool valid() const { return error.empty(); }
+    const std::string& errorMessage() const { return error; }
+
+    // Start of the first line at or after `from` that may match, or npos.
+    // Lines before it are known not to match.
+    size_t nextCandidate(const char* data, size_t size, size_t from) const;
+
+    // Match spans [start, end) within one line (no trailing '\n')
+    bool matchLine(const char* line, size_t length, std::vector<std::pair<size_t, size_t>>* spans) const;
+
+private:
+    LiteralFinder literal; // the whole pattern with -F, the required literal otherwise
+    LineRegex regex;
+    bool useRegex = false;
+    std::string error;
+};
+
+struct GrepColors {
+    std::string path;
+    std::string lineNumber;
+    std::string match;
+    std::string separator;
+    std::string reset;
+};
+
+// Searches files and directories (recursively with -r, hidden entries and
+// symlinks skipped) on ThreadPool::shared(). Output keeps argument order and
+// sorted walk order regardless of which worker finished first, and is written
+// as soon as the files before it are done.
+// Returns 0 if something matched, 1 if nothing did, 2 on errors.
+int runGrep(const GrepMatcher& matcher, const std::vector<std::string>& paths, const GrepOptions& options,
+            const GrepColors& colors, std::ostream& out);
+
+#endif // GREP_H
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef LINE_REGEX_H
+#define LINE_REGEX_H
+
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// POSIX basic or extended regular expression for one line of text, with the
+// GNU additions grep users expect: \+ \? \| in basic syntax, \w \W \s \S,
+// and the \b \B \< \> word assertions. Back-references are not supported.
+//
+// Compiled into a Thompson NFA and run as a Pike VM: every live state
+// advances one byte at a time, so matching is O(line length x program size)
+// with no backtracking and no recursion, whatever the pattern or the line.
+// Matches are leftmost-longest, as POSIX asks. matches() only needs a yes or
+// no, so it walks a DFA built lazily from the same program, one table
+// lookup per byte; patterns with word assertions stay on the VM.
+class LineRegex {
+public:
+    // On error the regex matches nothing and `error` says why
+    bool compile(std::string_view pattern, bool extended, bool ignoreCase, std::string& error);
+
+    // First match starting at or after `from`: [start, end). The whole line
+    // is still seen by ^ and the word assertions.
+    bool search(const char* line, size_t length, size_t from, size_t& start, size_t& end) const;
+    // Whether anything matches; stops at the first match found
+    bool matches(const char* line, size_t length) const;
+
+private:
+    enum class OpType : uint8_t { Char, Set, Split, Jump, Assert, Match };
+    enum Assertion : uint8_t { LINE_START, LINE_END, WORD_BOUNDARY, NOT_WORD_BOUNDARY, WORD_START, WORD_END };
+    struct Op {
+        OpType type;
+        uint8_t arg; // Char: the byte; Assert: the assertion
+        int32_t x;   // Set: index in sets; Split/Jump: target
+        int32_t y;   // Split: second target
+    };
+
+    bool run(const char* line, size_t length, size_t from, bool firstOnly, size_t& start, size_t& end) const;
+    // -1 when the DFA grew too large for this line
+    int runDfa(const char* line, size_t length) const;
+
+    std::vector<Op> program;
+    std::vector<std::bitset<256>> sets;
+    uint64_t id = 0;         // tells the per-thread DFA caches apart
+    bool dfaSafe = false;    // no word assertions
+
+    friend class LineRegexCompiler;
+};
+
+#endif // LINE_REGEX_H
@@ -0,0 +1,142 @@
+#ifndef PAGER_H
+#define PAGER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils.h"
+
+class GrepMatcher;
+
+// Sparse newline index over a mapped file, built by a background thread in
+// fixed-size chunks. Only the start of every STRIDE-th line is stored, so
+// memory grows with lines / STRIDE rather than with the file; any other line
+// is found by scanning forward from the nearest checkpoint.
+class LineIndex {
+public:
+    static constexpr size_t STRIDE = 256;
+    static constexpr size_t CHUNK = 8 << 20;
+
+    LineIndex() = default;
+    ~LineIndex() { stop(); }
+
+    LineIndex(const LineIndex&) = delete;
+    LineIndex& operator=(const LineIndex&) = delete;
+
+    // Scans [indexedBytes(), size) in the background. Calling it again after
+    // stop() with a longer mapping of the same file resumes where it left off.
+    void start(const char* data, size_t size);
+    void stop();
+    void reset(); // forget everything (the file was truncated)
+
+    bool complete() const { return done.load(std::memory_order_acquire); }
+    size_t indexedBytes() const { return scanned.load(std::memory_order_acquire); }
+    // Newlines found in [0, indexedBytes())
+    size_t newlines() const { return lines.load(std::memory_order_acquire); }
+    // Lines in the file, once complete (a last line without '\n' counts)
+    size_t lineCount() const;
+
+    // 0-based line containing `offset`, if that part is indexed
+    bool lineOf(size_t offset, size_t& line) const;
+    // Start of 0-based `line`, if that part is indexed
+    bool offsetOf(size_t line, size_t& offset) const;
+
+    size_t memoryBytes() const;
+
+private:
+    void run();
+    void scan(size_t begin, size_t end, size_t& count, std::vector<uint64_t>& found) const;
+
+    const char* data = nullptr;
+    size_t size = 0;
+    mutable std::mutex mutex;
+    std::vector<uint64_t> checkpoints{0}; // start of lines 0, STRIDE, 2 * STRIDE...
+    std::atomic<size_t> scanned{0};
+    std::atomic<size_t> lines{0};
+    std::atomic<bool> done{false};
+    std::atomic<bool> stopping{false};
+    std::thread worker;
+};
+
+// less-style viewer. The file is mapped, never read into memory (until
+// follow mode, see reload()); the screen is rendered from the byte offset of
+// its first line, so opening a file and paging around its beginning, end or
+// a percentage never waits for the index, which is only needed for line
+// numbers and "go to line".
+class Pager {
+public:
+    explicit Pager(std::string path);
+    ~Pager();
+
+    bool open();
+    // Interactive loop on the controlling terminal; returns the exit status
+    int run();
+
+    void setSize(int rows, int cols);
+    // Whole screen (text rows and status line) as terminal output
+    void render(std::string& out) const;
+
+    void lineDown(size_t count);
+    void lineUp(size_t count);
+    void goTop() { top = 0; }
+    void goBottom() { top = bottomTop(); }
+    void goToLine(size_t line); // 1-based; waits for the index if needed
+    void goToPercent(size_t percent);
+
+    // Moves the first line that matches to the top of the screen
+    bool search(const std::string& pattern, bool forward);
+    bool searchAgain(bool reverse);
+
+    // Picks up data appended to the file; true if it changed
+    bool reload();
+
+    const LineIndex& lineIndex() const { return index; }
+    size_t topOffset() const { return top; }
+    size_t fileSize() const { return textSize(); }
+
+private:
+    const char* text() const { return copied ? copy.data() : file.data(); }
+    size_t textSize() const { return copied ? copy.size() : file.size(); }
+    bool readCopy(size_t from);
+    size_t lineStart(size_t offset) const;
+    size_t nextLine(size_t offset) const;
+    size_t bottomTop() const;
+    size_t screenEnd() const;
+    bool runSearch(bool forward);
+    bool findForward(size_t from, size_t& found);
+    bool findBackward(size_t before, size_t& found);
+    bool interrupted();
+    void renderLine(std::string& out, size_t begin, size_t end, int width) const;
+    void renderStatus(std::string& out, size_t end, bool numbered, size_t firstLine, size_t shown) const;
+
+    #ifndef _WIN32
+        int readKey(int timeoutMs);
+        bool readPrompt(const std::string& prefix, std::string& text);
+        void draw();
+        void follow();
+    #endif
+
+    std::string path;
+    MappedFile file;
+    std::string copy; // replaces the mapping once following
+    bool copied = false;
+    LineIndex index;
+    size_t top = 0;
+    int rows = 24;
+    int cols = 80;
+
+    std::unique_ptr<GrepMatcher> matcher;
+    bool lastForward = true;
+    size_t lastMatch = SIZE_MAX;
+    std::string message;
+    std::string pending; // numeric prefix being typed
+    bool following = false;
+    bool interactive = false;
+};
+
+#endif // PAGER_H
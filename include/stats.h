@@ -0,0 +1,107 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "utils.h"
+
+// Datos de un comando ya ejecutado
+struct CommandRecord {
+    char name[24];
+    int64_t wallNanos;
+    int64_t userMicros;
+    int64_t sysMicros;
+    int64_t maxRssKb; // peak of the spawned process; -1 for builtins
+    int exitStatus;
+};
+
+// Resumen por nombre de comando para el builtin `stats`
+struct CommandSummary {
+    std::string name;
+    size_t count = 0;
+    size_t failures = 0;
+    int64_t p50Nanos = 0;
+    int64_t p90Nanos = 0;
+    int64_t p99Nanos = 0;
+    int64_t maxNanos = 0;
+    int64_t totalNanos = 0;
+    int64_t avgUserMicros = 0;
+    int64_t avgSysMicros = 0;
+    int64_t maxRssKb = -1;
+};
+
+// Fixed-size ring buffer with a single writer (the command loop). The writer
+// fills the slot first and then publishes it by bumping `head` with release
+// semantics, so recording never locks nor allocates.
+template <typename T, size_t N>
+class RingBuffer {
+    static_assert((N & (N - 1)) == 0, "RingBuffer size must be a power of two");
+
+public:
+    void push(const T& value) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        slots[h & (N - 1)] = value;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    // Oldest to newest
+    std::vector<T> snapshot() const {
+        uint64_t h = head.load(std::memory_order_acquire);
+        uint64_t first = h > N ? h - N : 0;
+        std::vector<T> out;
+        out.reserve(h - first);
+        for (uint64_t i = first; i < h; ++i) out.push_back(slots[i & (N - 1)]);
+        return out;
+    }
+
+    const T* last() const {
+        uint64_t h = head.load(std::memory_order_acquire);
+        return h == 0 ? nullptr : &slots[(h - 1) & (N - 1)];
+    }
+
+    uint64_t total() const { return head.load(std::memory_order_acquire); }
+
+private:
+    std::array<T, N> slots{};
+    std::atomic<uint64_t> head{0};
+};
+
+// Captures wall clock and CPU counters at construction; finish() turns them
+// into a record. Builtins are measured with the shell's own rusage, spawned
+// processes add the child usage returned by wait4(). The shell's peak RSS
+// covers its whole lifetime, so only a child's peak is recorded.
+class CommandTimer {
+public:
+    CommandTimer();
+    CommandRecord finish(std::string_view name, int exitStatus, const ResourceUsage& childUsage) const;
+
+private:
+    std::chrono::steady_clock::time_point start;
+    ResourceUsage selfStart;
+};
+
+class CommandStats {
+public:
+    static constexpr size_t CAPACITY = 4096;
+
+    void record(const CommandRecord& rec) { records.push(rec); }
+    const CommandRecord* last() const { return records.last(); }
+    uint64_t total() const { return records.total(); }
+
+    // Percentiles by command name, sorted by total wall time
+    std::vector<CommandSummary> summarize() const;
+
+private:
+    RingBuffer<CommandRecord, CAPACITY> records;
+};
+
+// "850us", "12.3ms", "2.41s", "3m05s"
+std::string formatDuration(int64_t nanos);
+
+#endif // STATS_H
@@ -2,15 +2,18 @@
 #define TERMINAL_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <csignal>
+#include <ctime>
 
-struct Theme {
-    std::string user_host;
-    std::string directory;
-    std::string branch;
-};
+#include "completion.h"
+#include "config.h"
+#include "daemon.h"
+#include "frecency.h"
+#include "stats.h"
+#include "tokenizer.h"
 
 class Terminal {
 private:
@@ -19,32 +22,69 @@ private:
     std::string previousPath;
     std::string computerName;
     bool showGitBranch;
+    std::string gitSegment; // cached by refreshPromptInfo()
 
     std::map<std::string, Theme> themes;
     Theme currentTheme;
+    bool themeFromConfig = false; // currentTheme is the one the file names
+
+    std::string configFile; // ~/.myterm.conf or $MYTERM_CONFIG
+    Config config;
+    ConfigWatcher configWatcher;
+    PromptTemplate prompt;
+    std::string promptBuffer;
+    std::map<std::string, std::string> sessionAliases; // defined with `alias`, win over the file
 
     std::vector<std::string> commandHistory;
     int historyIndex = -1;
+    std::string historyFile; // ~/.myterm_history, used when there is no daemon
+    std::vector<std::string> unsavedHistory;
+
+    Tokenizer tokenizer;
+    std::vector<std::string> globStorage;
+    std::vector<std::string_view> expandedTokens;
+    CommandStats stats;
+    bool showLastDuration = false;
+
+    FrecencyIndex dirIndex; // ~/.myterm_dirs
+    std::vector<std::string> dirStack; // pushd/popd, top at the back
+
+    DaemonClient daemonClient;
+    std::time_t lastDaemonAttempt = 0;
+    ExecutableIndex executables; // PATH commands for Tab without the daemon
 
     static Terminal* instance;
     static void signalHandler(int signum);
 
     void getUserInfo();
+    void loadHistory();
+    void addToHistory(const std::string& line);
+    void saveHistory();
     std::string getRelativePath();
     std::string getGitBranch();
     
     void initializeThemes();
+    void applyConfig();
+    void compilePrompt();
+    std::string expandAlias(const std::string& input) const;
 
-    std::vector<std::string> splitCommand(const std::string& command);
-    void executeCommand(const std::vector<std::string>& tokens, const std::string& originalCommand);
+    void executeCommand(const std::vector<std::string_view>& tokens, const std::string& originalCommand);
+    int dispatchCommand(const std::vector<std::string_view>& tokens, const std::string& originalCommand, ResourceUsage& childUsage);
+    void handleStatsCommand(const std::vector<std::string_view>& tokens);
 
-    void handleTabCompletion(std::string& line, size_t& cursorPos);
     std::string getLineAdvanced();
 
 public:
+    static constexpr size_t HISTORY_SAVE_EVERY = 16; // commands between writes, as with the dir index
+
     Terminal();
     void run();
 
+    // Editor/parser entry points, also driven by the benchmark suite
+    const std::vector<std::string_view>& splitCommand(std::string_view command);
+    const std::vector<std::string_view>& expandGlobs(const std::vector<std::string_view>& tokens);
+    void handleTabCompletion(std::string& line, size_t& cursorPos);
+
     // Public accessors needed by other components
     const std::string& getCurrentPath() const { return currentPath; }
     const std::string& getUserName() const { return userName; }
@@ -54,10 +94,25 @@ public:
     // Public mutators
     void setCurrentPath(const std::string& path) { currentPath = path; }
     void setPreviousPath(const std::string& path) { previousPath = path; }
-    void setCurrentTheme(const Theme& theme) { currentTheme = theme; }
+    void setCurrentTheme(const Theme& theme);
     const std::string& getPreviousPath() const { return previousPath; }
     const std::map<std::string, Theme>& getThemes() const { return themes; }
+    const CommandStats& getStats() const { return stats; }
+    FrecencyIndex& getDirIndex() { return dirIndex; }
+    std::vector<std::string>& getDirStack() { return dirStack; }
+    DaemonClient& getDaemon() { return daemonClient; }
+    const std::string& getConfigFile() const { return configFile; }
+    const Config& getConfig() const { return config; }
+    std::map<std::string, std::string> getAliases() const;
+    void setAlias(const std::string& name, const std::string& value) { sessionAliases[name] = value; }
+
+    // Rereads the config file (also done when it changes, before a prompt)
+    void reloadConfig();
+
+    // Called after every successful cd
+    void recordDirectory(const std::string& path);
 
+    void refreshPromptInfo();
     void showPrompt();
 };
 
@@ -0,0 +1,60 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool. Each worker pops its own deque from the back (LIFO,
+// keeps recursive directory walks cache-friendly) and steals from the front
+// of the others when it runs dry. Tasks may submit more tasks; wait() returns
+// once everything submitted so far, including nested tasks, has finished.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+    void wait();
+
+    size_t size() const { return queues.size(); }
+
+    // Index of the calling worker in [0, size()), or size() outside the pool.
+    // Handy for per-worker result buffers.
+    size_t workerIndex() const;
+
+    // Process-wide pool sized to the machine, created on first use
+    static ThreadPool& shared();
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool popLocal(size_t index, std::function<void()>& task);
+    bool steal(size_t index, std::function<void()>& task);
+    void workerLoop(size_t index);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::atomic<size_t> queued{0};   // tasks sitting in queues
+    std::atomic<size_t> pending{0};  // submitted and not yet finished
+    std::atomic<size_t> nextQueue{0};
+    bool stopping = false;
+
+    std::mutex sleepMutex;
+    std::condition_variable sleepCv;
+    std::condition_variable doneCv;
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,55 @@
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Command line lexer with POSIX-style quoting:
+//   'texto'   literal, no escapes
+//   "texto"   \ escapes $ ` " \ and newline; $VAR and ${VAR} expand
+//   \x        literal x outside quotes
+//   $VAR      expands (no field splitting)
+//   ~ ~/...   $HOME at the start of a word; ~user is that user's home
+//   # ...     comment, when unquoted at the start of a word
+//
+// Unquoted *, ? and [ mark a word as a glob; quoted metacharacters inside
+// such a word are kept backslash-escaped so the glob matcher treats them
+// literally. Unquoted | & ; < > ( ), command substitution and special
+// parameters ($? $$ $! $# $* $@ $- $0-$9) mark the line as needing the
+// system shell.
+//
+// Words that need no rewriting are returned as views into the input line;
+// the rest are built in an arena that is reused between calls, so once the
+// buffers have grown tokenizing does not touch the heap.
+class Tokenizer {
+public:
+    // Views stay valid until the next call and while `line` is alive
+    const std::vector<std::string_view>& tokenize(std::string_view line);
+
+    bool isGlob(size_t index) const { return spans[index].glob; }
+    bool hasGlobs() const { return anyGlob; }
+    bool needsShell() const { return shellSyntax; }
+
+private:
+    struct Span {
+        uint32_t offset;
+        uint32_t length;
+        bool inArena;
+        bool glob;
+    };
+
+    void appendLiteral(char c);
+    void appendLiteral(const char* s);
+    void appendVariable(std::string_view line, size_t& i);
+
+    std::string arena;
+    std::vector<Span> spans;
+    std::vector<std::string_view> tokens;
+    bool escaped = false;     // current word holds escaped metacharacters
+    bool anyGlob = false;
+    bool shellSyntax = false;
+};
+
+#endif // TOKENIZER_H
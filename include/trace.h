@@ -0,0 +1,56 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Trazas internas de las rutas calientes. Se compilan por defecto; definir
+// MYTERM_DISABLE_TRACING elimina por completo los TRACE_SCOPE del binario.
+#ifndef MYTERM_DISABLE_TRACING
+    #define MYTERM_TRACING 1
+#endif
+
+namespace Trace {
+    extern std::atomic<bool> enabled;
+
+    int64_t nowNanos();
+    void record(const char* name, int64_t startNanos, int64_t endNanos);
+
+    void start();
+    void stop();
+    size_t eventCount();
+
+    // Chrome trace_event JSON (chrome://tracing, Perfetto)
+    bool dumpChrome(const std::string& path);
+    // One marker per line: "<CLOCK_MONOTONIC ns> <tid> <dur ns> <name>",
+    // aligned with `perf record -k CLOCK_MONOTONIC` timestamps
+    bool dumpPerf(const std::string& path);
+
+    // RAII span; costs a relaxed load when tracing is stopped
+    class Span {
+    public:
+        explicit Span(const char* name)
+            : name(name), startNanos(enabled.load(std::memory_order_relaxed) ? nowNanos() : 0) {}
+        ~Span() {
+            if (startNanos) record(name, startNanos, nowNanos());
+        }
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        const char* name;
+        int64_t startNanos;
+    };
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef MYTERM_TRACING
+    #define TRACE_SCOPE(name) Trace::Span TRACE_CONCAT(traceSpan_, __LINE__)(name)
+#else
+    #define TRACE_SCOPE(name) ((void)0)
+#endif
+
+#endif // TRACE_H
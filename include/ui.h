@@ -3,10 +3,14 @@
 
 #include <string>
 
+#include "config.h"
+
 class Terminal; // Forward declaration
 
 void showHelp();
 void showThemes(Terminal& term);
-void showPrompt(Terminal& term, const std::string& relativePath, const std::string& gitBranch);
+void showStats(Terminal& term);
+// Renders the compiled prompt into `buffer` and writes it at once
+void showPrompt(const PromptTemplate& prompt, const PromptTemplate::Slots& slots, std::string& buffer);
 
 #endif // UI_H
\ No newline at end of file
@@ -2,9 +2,13 @@
 #define UTILS_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <algorithm>
 #include <cctype>
+#include <cstdint>
+#include <functional>
+#include <utility>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -42,8 +46,81 @@ std::string toLower(std::string s);
 // Helper para obtener el ancho de la terminal
 int getTerminalWidth();
 
+// Helper para obtener el alto de la terminal (filas)
+int getTerminalHeight();
+
+// Directorio personal (HOME o USERPROFILE), "" si no esta definido
+std::string getHomeDirectory();
+
 // Helper para inicializar la terminal (colores, UTF-8)
 void initializeTerminal();
 
+// Consumo de recursos de un proceso (tiempos en microsegundos)
+struct ResourceUsage {
+    int64_t userMicros = 0;
+    int64_t sysMicros = 0;
+    int64_t maxRssKb = 0;
+};
+
+// Helper para leer el consumo del propio proceso
+ResourceUsage getSelfUsage();
+
+// Ejecuta un comando con el shell del sistema y devuelve su codigo de salida.
+// Si usage no es nulo, recibe el consumo del proceso hijo.
+int runShellCommand(const std::string& command, ResourceUsage* usage);
+
+// Ejecuta args[0] directamente con la lista de argumentos ya expandida
+int runProcess(const std::vector<std::string_view>& args, const std::string& originalCommand, ResourceUsage* usage);
+
+// Entrecomilla un argumento para el shell del sistema
+std::string quoteShellArgument(std::string_view arg);
+
+// Llama a fn(name, isDir, isSymlink) por cada entrada de `dir` salvo "." y "..".
+// `dir` es "" o termina en '/'.
+void forEachDirectoryEntry(const std::string& dir, const std::function<void(const char*, bool, bool)>& fn);
+
+// Fecha de modificacion en nanosegundos, o -1 si `path` no existe
+int64_t modificationTime(const std::string& path);
+
+// Historial de comandos, una linea por comando. Lee las ultimas `max` lineas.
+void readHistoryFile(const std::string& path, size_t max, std::vector<std::string>& out);
+bool appendHistoryFile(const std::string& path, const std::vector<std::string>& lines);
+// Si el archivo supera 2 * `max` lineas, lo reescribe solo con las ultimas
+// `max`. Bloquea el archivo (flock) igual que appendHistoryFile.
+void compactHistoryFile(const std::string& path, size_t max);
+
+#ifndef _WIN32
+// Abre `path` con `flags` y toma su flock exclusivo; -1 si no se pudo abrir.
+// Si otro proceso lo reemplazo mientras se esperaba, abre el nuevo.
+int lockFile(const std::string& path, int flags);
+#endif
+
+// Archivo proyectado en memoria, solo lectura
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path) { open(path); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return ptr != nullptr; }
+    const char* data() const { return ptr; }
+    size_t size() const { return length; }
+
+private:
+    const char* ptr = nullptr;
+    size_t length = 0;
+    #ifdef _WIN32
+        HANDLE mapping = nullptr;
+    #endif
+};
+
 
 #endif // UTILS_H
\ No newline at end of file
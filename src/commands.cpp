@@ -1,17 +1,23 @@
 #include "commands.h"
 #include "terminal.h"
 #include "utils.h"
+#include "trace.h"
+#include "grep.h"
+#include "pager.h"
+#include "daemon.h"
 
 #include <iostream>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <chrono>
+#include <ctime>
 #include <vector>
 
 namespace fs = std::filesystem;
 
-void listDirectory(Terminal& term, const std::vector<std::string>& tokens) {
+int listDirectory(Terminal& term, const std::vector<std::string_view>& tokens) {
+    TRACE_SCOPE("listDirectory");
     std::string path = ".";
     bool long_listing = false;
 
@@ -19,7 +25,7 @@ void listDirectory(Terminal& term, const std::vector<std::string>& tokens) {
         if (tokens[i] == "-l") {
             long_listing = true;
         } else {
-            path = tokens[i];
+            path = std::string(tokens[i]);
         }
     }
     try {
@@ -56,7 +62,7 @@ void listDirectory(Terminal& term, const std::vector<std::string>& tokens) {
                 max_len = std::max(max_len, entry.path().filename().string().length());
             }
 
-            if (entries.empty()) return;
+            if (entries.empty()) return 0;
 
             int term_width = getTerminalWidth();
             int col_width = max_len + 2;
@@ -92,10 +98,12 @@ void listDirectory(Terminal& term, const std::vector<std::string>& tokens) {
         }
     } catch (const fs::filesystem_error& e) {
         std::cout << Colors::RED << "Error: No se pudo acceder al directorio " << path << Colors::RESET << std::endl;
+        return 1;
     }
+    return 0;
 }
 
-void changeDirectory(Terminal& term, const std::string& path) {
+int changeDirectory(Terminal& term, const std::string& path) {
     std::string newPath = path;
     
     if (path == "~") {
@@ -110,7 +118,7 @@ void changeDirectory(Terminal& term, const std::string& path) {
             newPath = term.getPreviousPath();
         } else {
             std::cout << Colors::RED << "Error: No hay directorio anterior para volver." << Colors::RESET << std::endl;
-            return;
+            return 1;
         }
     }
     
@@ -120,65 +128,162 @@ void changeDirectory(Terminal& term, const std::string& path) {
             targetPath = fs::current_path() / targetPath;
         }
 
+        std::string match;
         if (fs::is_directory(targetPath)) {
             term.setPreviousPath(term.getCurrentPath());
             fs::current_path(targetPath);
             term.setCurrentPath(fs::current_path().string());
+            term.recordDirectory(term.getCurrentPath());
+            return 0;
+        } else if (path.find_first_of("/\\") == std::string::npos &&
+                   term.getDirIndex().query({path}, term.getCurrentPath(), (int64_t)std::time(nullptr), match)) {
+            // Not a directory here: best remembered match, as with "j"
+            return changeDirectory(term, match);
         } else {
             std::cout << Colors::RED << "Error: El directorio '" << path << "' no existe o no es un directorio." << Colors::RESET << std::endl;
         }
     } catch (const fs::filesystem_error& e) {
         std::cout << Colors::RED << "Error al cambiar de directorio a '" << path << "': " << e.what() << Colors::RESET << std::endl;
     }
+    return 1;
 }
 
-void makeDirectory(const std::string& name) {
+int jumpDirectory(Terminal& term, const std::vector<std::string_view>& tokens) {
+    FrecencyIndex& index = term.getDirIndex();
+    int64_t now = (int64_t)std::time(nullptr);
+    if (tokens.size() < 2) {
+        std::vector<FrecencyMatch> best = index.top(10, now);
+        if (best.empty()) {
+            std::cout << Colors::YELLOW << "Aun no hay directorios recordados (se aprenden con cd)." << Colors::RESET << std::endl;
+            return 1;
+        }
+        for (const FrecencyMatch& m : best) {
+            std::cout << Colors::BRIGHT_BLACK << std::fixed << std::setprecision(1) << std::setw(8) << m.score << "  "
+                      << Colors::BRIGHT_BLUE << m.path << Colors::RESET << std::endl;
+        }
+        std::cout.unsetf(std::ios::fixed);
+        return 0;
+    }
+
+    std::vector<std::string_view> keywords(tokens.begin() + 1, tokens.end());
+    std::string match;
+    if (!index.query(keywords, term.getCurrentPath(), now, match)) {
+        std::string words;
+        for (std::string_view k : keywords) words += (words.empty() ? "" : " ") + std::string(k);
+        std::cout << Colors::RED << "Error: Ningun directorio recordado coincide con '" << words << "'" << Colors::RESET << std::endl;
+        return 1;
+    }
+    return changeDirectory(term, match);
+}
+
+static std::string abbreviateHome(const std::string& path) {
+    std::string home = getHomeDirectory();
+    if (!home.empty() && path.compare(0, home.size(), home) == 0 &&
+        (path.size() == home.size() || path[home.size()] == '/' || path[home.size()] == '\\')) {
+        return "~" + path.substr(home.size());
+    }
+    return path;
+}
+
+void showDirectoryStack(Terminal& term, const std::vector<std::string_view>& tokens) {
+    std::vector<std::string>& stack = term.getDirStack();
+    if (tokens.size() > 1 && tokens[1] == "-c") {
+        stack.clear();
+        return;
+    }
+    std::cout << Colors::BRIGHT_BLUE << abbreviateHome(term.getCurrentPath());
+    for (auto it = stack.rbegin(); it != stack.rend(); ++it) std::cout << " " << abbreviateHome(*it);
+    std::cout << Colors::RESET << std::endl;
+}
+
+int pushDirectory(Terminal& term, const std::vector<std::string_view>& tokens) {
+    std::vector<std::string>& stack = term.getDirStack();
+    std::string previous = term.getCurrentPath();
+    if (tokens.size() < 2) {
+        // Without arguments: swap the current directory with the top of the stack
+        if (stack.empty()) {
+            std::cout << Colors::RED << "Error: No hay otro directorio en la pila" << Colors::RESET << std::endl;
+            return 1;
+        }
+        if (changeDirectory(term, stack.back()) != 0) return 1;
+        stack.back() = previous;
+    } else {
+        int status = tokens.size() > 2 ? jumpDirectory(term, tokens) : changeDirectory(term, std::string(tokens[1]));
+        if (status != 0) return 1;
+        stack.push_back(previous);
+    }
+    showDirectoryStack(term, {});
+    return 0;
+}
+
+int popDirectory(Terminal& term) {
+    std::vector<std::string>& stack = term.getDirStack();
+    if (stack.empty()) {
+        std::cout << Colors::RED << "Error: La pila de directorios esta vacia" << Colors::RESET << std::endl;
+        return 1;
+    }
+    std::string target = stack.back();
+    stack.pop_back();
+    if (changeDirectory(term, target) != 0) return 1;
+    showDirectoryStack(term, {});
+    return 0;
+}
+
+int makeDirectory(const std::string& name) {
     try {
         if (fs::create_directory(name)) {
             std::cout << Colors::BRIGHT_GREEN << "Directorio creado: " << name << Colors::RESET << std::endl;
+            return 0;
         } else {
             std::cout << Colors::YELLOW << "Advertencia: El directorio '" << name << "' ya existe." << Colors::RESET << std::endl;
         }
     } catch (const fs::filesystem_error& e) {
         std::cout << Colors::RED << "Error al crear el directorio '" << name << "': " << e.what() << Colors::RESET << std::endl;
     }
+    return 1;
 }
 
-void removeDirectory(const std::string& name) {
+int removeDirectory(const std::string& name) {
     try {
         if (fs::remove_all(name) > 0) {
             std::cout << Colors::BRIGHT_GREEN << "Directorio eliminado: " << name << Colors::RESET << std::endl;
+            return 0;
         } else {
             std::cout << Colors::YELLOW << "Advertencia: El directorio '" << name << "' no existe." << Colors::RESET << std::endl;
         }
     } catch (const fs::filesystem_error& e) {
         std::cout << Colors::RED << "Error al eliminar el directorio '" << name << "': " << e.what() << Colors::RESET << std::endl;
     }
+    return 1;
 }
 
-void createFile(const std::string& name) {
+int createFile(const std::string& name) {
     std::ofstream file(name);
     if (file.is_open()) {
         file.close();
         std::cout << Colors::BRIGHT_GREEN << "Archivo creado: " << name << Colors::RESET << std::endl;
+        return 0;
     } else {
         std::cout << Colors::RED << "Error: No se pudo crear el archivo " << name << Colors::RESET << std::endl;
+        return 1;
     }
 }
 
-void removeFile(const std::string& name) {
+int removeFile(const std::string& name) {
     try {
         if (fs::remove(name)) {
             std::cout << Colors::BRIGHT_GREEN << "Archivo eliminado: " << name << Colors::RESET << std::endl;
+            return 0;
         } else {
             std::cout << Colors::YELLOW << "Advertencia: El archivo '" << name << "' no existe." << Colors::RESET << std::endl;
         }
     } catch (const fs::filesystem_error& e) {
         std::cout << Colors::RED << "Error al eliminar el archivo '" << name << "': " << e.what() << Colors::RESET << std::endl;
     }
+    return 1;
 }
 
-void showFileContent(const std::string& name) {
+int showFileContent(const std::string& name) {
     std::ifstream file(name);
     if (file.is_open()) {
         std::cout << Colors::BRIGHT_CYAN << "Contenido de " << name << ":" << Colors::RESET << std::endl;
@@ -189,10 +294,10 @@ void showFileContent(const std::string& name) {
             std::cout << Colors::BRIGHT_BLACK << std::setw(3) << lineNum++ << " | " << Colors::RESET << line << std::endl;
         }
         std::cout << Colors::BRIGHT_BLACK << "-------------------------------------" << Colors::RESET << std::endl;
-        file.close();
-    } else {
-        std::cout << Colors::RED << "Error: No se pudo leer el archivo " << name << Colors::RESET << std::endl;
+        return 0;
     }
+    std::cout << Colors::RED << "Error: No se pudo leer el archivo " << name << Colors::RESET << std::endl;
+    return 1;
 }
 
 void clearScreen() {
@@ -203,20 +308,233 @@ void clearScreen() {
     #endif
 }
 
-void executeGitCommand(const std::vector<std::string>& tokens) {
+int executeGitCommand(const std::vector<std::string_view>& tokens, ResourceUsage* usage) {
+    // Tokens are already unquoted and expanded; the shell fallback needs them quoted again
     std::string gitCmd = "git";
     for (size_t i = 1; i < tokens.size(); ++i) {
-        gitCmd += " " + tokens[i];
+        gitCmd += " " + quoteShellArgument(tokens[i]);
     }
-    system(gitCmd.c_str());
+    return runProcess(tokens, gitCmd, usage);
 }
 
-void changeTheme(Terminal& term, const std::string& themeName) {
+int changeTheme(Terminal& term, const std::string& themeName) {
     const auto& themes = term.getThemes();
     if (themes.count(themeName)) {
         term.setCurrentTheme(themes.at(themeName));
         std::cout << Colors::BRIGHT_GREEN << "Tema cambiado a: " << themeName << Colors::RESET << std::endl;
-    } else {
-        std::cout << Colors::RED << "Error: El tema '" << themeName << "' no existe." << Colors::RESET << std::endl;
+        return 0;
+    }
+    std::cout << Colors::RED << "Error: El tema '" << themeName << "' no existe." << Colors::RESET << std::endl;
+    return 1;
+}
+
+int traceCommand(const std::vector<std::string_view>& tokens) {
+    #ifdef MYTERM_TRACING
+        std::string action = tokens.size() > 1 ? std::string(tokens[1]) : "status";
+        if (action == "start") {
+            Trace::start();
+            std::cout << Colors::BRIGHT_GREEN << "Trazado iniciado." << Colors::RESET << std::endl;
+        } else if (action == "stop") {
+            Trace::stop();
+            std::cout << Colors::BRIGHT_GREEN << "Trazado detenido (" << Trace::eventCount() << " eventos)." << Colors::RESET << std::endl;
+        } else if (action == "dump") {
+            bool perf = false;
+            std::string path;
+            for (size_t i = 2; i < tokens.size(); ++i) {
+                if (tokens[i] == "--perf") perf = true;
+                else path = std::string(tokens[i]);
+            }
+            if (path.empty()) path = perf ? "myterm-trace.perf" : "myterm-trace.json";
+            if (perf ? Trace::dumpPerf(path) : Trace::dumpChrome(path)) {
+                std::cout << Colors::BRIGHT_GREEN << "Traza guardada en " << path << " (" << Trace::eventCount() << " eventos)" << Colors::RESET << std::endl;
+            } else {
+                std::cout << Colors::RED << "Error: No se pudo escribir " << path << Colors::RESET << std::endl;
+                return 1;
+            }
+        } else if (action == "status") {
+            std::cout << Colors::BRIGHT_CYAN << "Trazado " << (Trace::enabled ? "activo" : "inactivo") << ", "
+                      << Trace::eventCount() << " eventos en memoria" << Colors::RESET << std::endl;
+        } else {
+            std::cout << Colors::RED << "Uso: trace start|stop|status|dump [--perf] [archivo]" << Colors::RESET << std::endl;
+            return 1;
+        }
+        return 0;
+    #else
+        (void)tokens;
+        std::cout << Colors::YELLOW << "El trazado no esta compilado (MYTERM_DISABLE_TRACING)." << Colors::RESET << std::endl;
+        return 1;
+    #endif
+}
+
+int grepCommand(Terminal& term, const std::vector<std::string_view>& tokens) {
+    GrepOptions options;
+    std::string pattern;
+    bool havePattern = false;
+    std::vector<std::string> paths;
+    bool endOfOptions = false;
+    for (size_t i = 1; i < tokens.size(); ++i) {
+        std::string_view arg = tokens[i];
+        if (!endOfOptions && arg == "--") {
+            endOfOptions = true;
+        } else if (!endOfOptions && arg.size() > 1 && arg[0] == '-') {
+            for (char flag : arg.substr(1)) {
+                switch (flag) {
+                    case 'r': case 'R': options.recursive = true; break;
+                    case 'i': options.ignoreCase = true; break;
+                    case 'n': options.lineNumbers = true; break;
+                    case 'F': options.fixed = true; break;
+                    case 'E': options.extended = true; break;
+                    case 'v': options.invert = true; break;
+                    case 'l': options.filesOnly = true; break;
+                    case 'c': options.countOnly = true; break;
+                    default:
+                        std::cout << Colors::RED << "Error: Opcion desconocida -" << flag << Colors::RESET << std::endl;
+                        return 2;
+                }
+            }
+        } else if (!havePattern) {
+            pattern = std::string(arg);
+            havePattern = true;
+        } else {
+            paths.push_back(std::string(arg));
+        }
     }
-}
\ No newline at end of file
+
+    if (!havePattern || (paths.empty() && !options.recursive)) {
+        std::cout << Colors::RED << "Uso: grep [-rinFEvlc] <patron> <archivo...>" << Colors::RESET << std::endl;
+        return 2;
+    }
+    if (paths.empty()) paths.push_back(""); // -r sin ruta: directorio actual
+
+    GrepMatcher matcher(pattern, options);
+    if (!matcher.valid()) {
+        std::cout << Colors::RED << "Error: Patron invalido: " << matcher.errorMessage() << Colors::RESET << std::endl;
+        return 2;
+    }
+
+    const Theme& theme = term.getCurrentTheme();
+    GrepColors colors{theme.directory, theme.user_host, Colors::BOLD + theme.branch, Colors::BRIGHT_BLACK, Colors::RESET};
+    return runGrep(matcher, paths, options, colors, std::cout);
+}
+
+int pagerCommand(const std::vector<std::string_view>& tokens) {
+    if (tokens.size() < 2) {
+        std::cout << Colors::RED << "Uso: less <archivo>" << Colors::RESET << std::endl;
+        return 2;
+    }
+    std::string name(tokens[1]);
+    std::error_code ec;
+    if (fs::is_directory(name, ec)) {
+        std::cout << Colors::RED << "Error: " << name << " es un directorio" << Colors::RESET << std::endl;
+        return 1;
+    }
+    #ifdef _WIN32
+        // Sin modo raw de consola: se muestra entero
+        showFileContent(name);
+        return 0;
+    #else
+        Pager pager(name);
+        if (!pager.open()) {
+            std::cout << Colors::RED << "Error: No se pudo leer el archivo " << name << Colors::RESET << std::endl;
+            return 1;
+        }
+        return pager.run();
+    #endif
+}
+
+int daemonCommand(Terminal& term, const std::vector<std::string_view>& tokens) {
+    std::string_view action = tokens.size() > 1 ? tokens[1] : "status";
+    DaemonClient& daemon = term.getDaemon();
+    #ifdef _WIN32
+        (void)daemon;
+        std::cout << Colors::RED << "Error: El daemon no esta disponible en Windows" << Colors::RESET << std::endl;
+        return 1;
+    #else
+        if (action == "start") {
+            uint32_t pid = 0;
+            if (daemon.connected() || daemon.connect()) {
+                std::cout << Colors::YELLOW << "El daemon ya esta en ejecucion" << Colors::RESET << std::endl;
+                return 0;
+            }
+            if (!spawnDaemon(pid) || !daemon.connect()) {
+                std::cout << Colors::RED << "Error: No se pudo iniciar el daemon" << Colors::RESET << std::endl;
+                return 1;
+            }
+            std::cout << Colors::BRIGHT_GREEN << "Daemon iniciado (pid " << pid << ")" << Colors::RESET << std::endl;
+            return 0;
+        }
+        if (action == "stop") {
+            if (!daemon.connected() && !daemon.connect()) {
+                std::cout << Colors::RED << "Error: El daemon no esta en ejecucion" << Colors::RESET << std::endl;
+                return 1;
+            }
+            daemon.shutdown();
+            std::cout << Colors::BRIGHT_GREEN << "Daemon detenido" << Colors::RESET << std::endl;
+            return 0;
+        }
+        if (action == "status") {
+            DaemonStats stats;
+            if ((!daemon.connected() && !daemon.connect()) || !daemon.stats(stats)) {
+                std::cout << Colors::YELLOW << "Daemon inactivo: la sesion funciona por su cuenta" << Colors::RESET << std::endl;
+                return 1;
+            }
+            std::cout << Colors::BRIGHT_GREEN << "Daemon activo (pid " << stats.pid << ")" << Colors::RESET
+                      << " en " << daemonSocketPath() << std::endl;
+            std::cout << "  Sesiones conectadas: " << stats.clients << std::endl;
+            std::cout << "  Tiempo activo: " << stats.uptimeSeconds << " s" << std::endl;
+            std::cout << "  Peticiones: " << stats.requests << " (cache: " << stats.hits << " aciertos, "
+                      << stats.misses << " fallos)" << std::endl;
+            std::cout << "  Memoria compartida: " << (stats.sharedBytes + 1023) / 1024 << " KB" << std::endl;
+            return 0;
+        }
+        std::cout << Colors::RED << "Uso: daemon [start|stop|status]" << Colors::RESET << std::endl;
+        return 2;
+    #endif
+}
+
+int aliasCommand(Terminal& term, const std::vector<std::string_view>& tokens) {
+    std::map<std::string, std::string> aliases = term.getAliases();
+    if (tokens.size() == 1) {
+        for (const auto& [name, value] : aliases) {
+            std::cout << Colors::BRIGHT_GREEN << name << Colors::RESET << "='" << value << "'" << std::endl;
+        }
+        return 0;
+    }
+    int status = 0;
+    for (size_t i = 1; i < tokens.size(); ++i) {
+        std::string_view token = tokens[i];
+        size_t eq = token.find('=');
+        if (eq != std::string_view::npos && eq > 0) {
+            term.setAlias(std::string(token.substr(0, eq)), std::string(token.substr(eq + 1)));
+            continue;
+        }
+        auto it = aliases.find(std::string(token));
+        if (it != aliases.end()) {
+            std::cout << Colors::BRIGHT_GREEN << it->first << Colors::RESET << "='" << it->second << "'" << std::endl;
+        } else {
+            std::cout << Colors::RED << "Error: No existe el alias '" << token << "'" << Colors::RESET << std::endl;
+            status = 1;
+        }
+    }
+    return status;
+}
+
+int configCommand(Terminal& term, const std::vector<std::string_view>& tokens) {
+    if (tokens.size() > 1 && tokens[1] == "reload") {
+        term.reloadConfig();
+        return term.getConfig().errors.empty() ? 0 : 1;
+    }
+    const Config& config = term.getConfig();
+    std::error_code ec;
+    bool exists = !term.getConfigFile().empty() && fs::exists(term.getConfigFile(), ec);
+    std::cout << Colors::BRIGHT_CYAN << "Archivo: " << Colors::RESET << term.getConfigFile()
+              << (exists ? "" : " (no existe, valores por defecto)") << std::endl;
+    std::cout << "  prompt = \"" << config.prompt << "\"" << std::endl;
+    std::cout << "  Temas: " << term.getThemes().size() << " (" << config.themes.size() << " del archivo)" << std::endl;
+    std::cout << "  Alias: " << config.aliases.size() << std::endl;
+    std::cout << "  Historial: " << config.historySize << " comandos" << std::endl;
+    for (const std::string& error : config.errors) {
+        std::cout << Colors::YELLOW << "  " << error << Colors::RESET << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include "completion.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+
+#ifndef _WIN32
+    #include <dirent.h>
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static int64_t wallClockNanos() {
+    return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::vector<CompletionEntry> listCompletionEntries(const std::string& dir) {
+    std::vector<CompletionEntry> entries;
+    std::string prefix = dir;
+    if (!prefix.empty() && prefix.back() != '/') prefix += '/';
+    forEachDirectoryEntry(prefix, [&](const char* name, bool isDir, bool isLink) {
+        if (isLink) {
+            std::error_code ec;
+            isDir = fs::is_directory(prefix + name, ec);
+        }
+        entries.push_back({name, isDir});
+    });
+    std::sort(entries.begin(), entries.end(), [](const CompletionEntry& a, const CompletionEntry& b) {
+        return a.name < b.name;
+    });
+    return entries;
+}
+
+static void scanExecutables(const std::string& dir, std::vector<std::string>& out) {
+    #ifdef _WIN32
+        std::error_code ec;
+        for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+            std::string ext = toLower(it->path().extension().string());
+            if (ext == ".exe" || ext == ".bat" || ext == ".cmd") out.push_back(it->path().filename().string());
+        }
+    #else
+        int dirFd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dirFd < 0) return;
+        DIR* d = fdopendir(dirFd);
+        if (!d) {
+            close(dirFd);
+            return;
+        }
+        while (struct dirent* e = readdir(d)) {
+            if (e->d_name[0] == '.') continue;
+            if (e->d_type != DT_REG && e->d_type != DT_LNK && e->d_type != DT_UNKNOWN) continue;
+            struct stat st;
+            if (fstatat(dirFd, e->d_name, &st, 0) != 0) continue;
+            if (S_ISREG(st.st_mode) && (st.st_mode & 0111)) out.push_back(e->d_name);
+        }
+        closedir(d);
+    #endif
+}
+
+bool ExecutableIndex::refresh(const std::string& pathVar) {
+    if (pathVar == path && !racy) {
+        bool changed = false;
+        for (const auto& [dir, mtime] : dirs) {
+            if (modificationTime(dir) != mtime) {
+                changed = true;
+                break;
+            }
+        }
+        if (!changed) return false;
+    }
+
+    #ifdef _WIN32
+        const char separator = ';';
+    #else
+        const char separator = ':';
+    #endif
+    path = pathVar;
+    dirs.clear();
+    commands.clear();
+    int64_t now = wallClockNanos();
+    racy = false;
+    size_t start = 0;
+    while (start <= pathVar.size()) {
+        size_t end = pathVar.find(separator, start);
+        if (end == std::string::npos) end = pathVar.size();
+        std::string dir = pathVar.substr(start, end - start);
+        start = end + 1;
+        if (dir.empty()) continue;
+        if (std::any_of(dirs.begin(), dirs.end(), [&](const auto& d) { return d.first == dir; })) continue;
+        // The mtime is taken before scanning, so a change during the scan is noticed next time
+        int64_t mtime = modificationTime(dir);
+        dirs.emplace_back(dir, mtime);
+        if (mtime < 0) continue;
+        if (now - mtime < RACY_WINDOW_NS) racy = true;
+        scanExecutables(dir, commands);
+    }
+    std::sort(commands.begin(), commands.end());
+    commands.erase(std::unique(commands.begin(), commands.end()), commands.end());
+    return true;
+}
@@ -0,0 +1,319 @@
+#include "config.h"
+#include "utils.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
+#ifdef __linux__
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+const char* const PromptTemplate::DEFAULT =
+    "{user_color}{user}@{host}{reset}:{path_color}{path}{git_color}{git}{reset}{if duration}{gray}{duration}{reset}{end}$ ";
+
+static std::string_view trim(std::string_view s) {
+    size_t begin = s.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos) return {};
+    size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(begin, end - begin + 1);
+}
+
+static int slotIndex(std::string_view name) {
+    static const std::string_view names[PromptTemplate::SLOT_COUNT] = {"user", "host", "path", "git", "duration"};
+    for (int i = 0; i < PromptTemplate::SLOT_COUNT; ++i) {
+        if (names[i] == name) return i;
+    }
+    return -1;
+}
+
+// "#rrggbb", "r,g,b" or an ANSI color name
+static bool parseColor(std::string_view text, std::string& out) {
+    static const std::pair<std::string_view, const std::string*> named[] = {
+        {"reset", &Colors::RESET}, {"bold", &Colors::BOLD}, {"dim", &Colors::DIM},
+        {"red", &Colors::BRIGHT_RED}, {"green", &Colors::BRIGHT_GREEN}, {"yellow", &Colors::BRIGHT_YELLOW},
+        {"blue", &Colors::BRIGHT_BLUE}, {"magenta", &Colors::BRIGHT_MAGENTA}, {"cyan", &Colors::BRIGHT_CYAN},
+        {"white", &Colors::BRIGHT_WHITE}, {"gray", &Colors::BRIGHT_BLACK},
+    };
+    for (const auto& [name, code] : named) {
+        if (text == name) {
+            out = *code;
+            return true;
+        }
+    }
+
+    int rgbValues[3];
+    if (text.size() == 7 && text[0] == '#') {
+        for (int i = 0; i < 3; ++i) {
+            char digits[3] = {text[1 + 2 * i], text[2 + 2 * i], '\0'};
+            char* end;
+            rgbValues[i] = (int)std::strtol(digits, &end, 16);
+            if (*end) return false;
+        }
+    } else {
+        std::string copy(text);
+        const char* p = copy.c_str();
+        for (int i = 0; i < 3; ++i) {
+            char* end;
+            long value = std::strtol(p, &end, 10);
+            if (end == p || value < 0 || value > 255 || *end != (i < 2 ? ',' : '\0')) return false;
+            rgbValues[i] = (int)value;
+            p = end + 1;
+        }
+    }
+    out = rgb(rgbValues[0], rgbValues[1], rgbValues[2]);
+    return true;
+}
+
+PromptTemplate::PromptTemplate() {
+    std::string error;
+    compile(DEFAULT, Theme(), error);
+}
+
+bool PromptTemplate::compile(std::string_view text, const Theme& theme, std::string& error) {
+    std::string newBytes;
+    std::vector<Op> newOps;
+    size_t openIf = SIZE_MAX;
+    size_t mergeFrom = 0; // text never merges back across an {if} or {end}
+
+    auto appendText = [&](std::string_view s) {
+        if (s.empty()) return;
+        if (newOps.size() > mergeFrom && newOps.back().type == OpType::Text) {
+            newOps.back().length += (uint32_t)s.size();
+        } else {
+            newOps.push_back({OpType::Text, 0, (uint32_t)newBytes.size(), (uint32_t)s.size()});
+        }
+        newBytes.append(s);
+    };
+
+    for (size_t i = 0; i < text.size();) {
+        if (text[i] != '{') {
+            size_t next = std::min(text.find('{', i), text.size());
+            appendText(text.substr(i, next - i));
+            i = next;
+            continue;
+        }
+        if (i + 1 < text.size() && text[i + 1] == '{') {
+            appendText("{");
+            i += 2;
+            continue;
+        }
+        size_t close = text.find('}', i);
+        if (close == std::string_view::npos) {
+            error = "falta '}'";
+            return false;
+        }
+        std::string_view name = text.substr(i + 1, close - i - 1);
+        i = close + 1;
+
+        int slot = slotIndex(name);
+        std::string color;
+        if (slot >= 0) {
+            newOps.push_back({OpType::Slot, (uint8_t)slot, 0, 0});
+        } else if (name.substr(0, 3) == "if ") {
+            slot = slotIndex(trim(name.substr(3)));
+            if (slot < 0 || openIf != SIZE_MAX) {
+                error = slot < 0 ? "{" + std::string(name) + "} desconocido" : "{if} dentro de otro {if}";
+                return false;
+            }
+            openIf = newOps.size();
+            newOps.push_back({OpType::If, (uint8_t)slot, 0, 0});
+            mergeFrom = newOps.size();
+        } else if (name == "end") {
+            if (openIf == SIZE_MAX) {
+                error = "{end} sin {if}";
+                return false;
+            }
+            newOps[openIf].length = (uint32_t)newOps.size();
+            openIf = SIZE_MAX;
+            mergeFrom = newOps.size();
+        } else if (name == "user_color") {
+            appendText(theme.user_host);
+        } else if (name == "path_color") {
+            appendText(theme.directory);
+        } else if (name == "git_color") {
+            appendText(theme.branch);
+        } else if (parseColor(name, color)) {
+            appendText(color);
+        } else {
+            error = "{" + std::string(name) + "} desconocido";
+            return false;
+        }
+    }
+    if (openIf != SIZE_MAX) {
+        error = "falta {end}";
+        return false;
+    }
+    bytes = std::move(newBytes);
+    ops = std::move(newOps);
+    return true;
+}
+
+void PromptTemplate::render(const Slots& slots, std::string& out) const {
+    size_t size = bytes.size();
+    for (const std::string_view& slot : slots) size += slot.size();
+    out.reserve(out.size() + size);
+
+    const char* base = bytes.data();
+    for (size_t i = 0; i < ops.size();) {
+        const Op& op = ops[i];
+        switch (op.type) {
+            case OpType::Text:
+                out.append(base + op.offset, op.length);
+                break;
+            case OpType::Slot:
+                out.append(slots[op.slot]);
+                break;
+            case OpType::If:
+                if (slots[op.slot].empty()) {
+                    i = op.length;
+                    continue;
+                }
+                break;
+        }
+        ++i;
+    }
+}
+
+// Unquotes a value; false if a quote is left open
+static bool parseValue(std::string_view text, std::string& out) {
+    out.clear();
+    if (text.empty() || text[0] != '"') {
+        out = text;
+        return true;
+    }
+    for (size_t i = 1; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '"') return true;
+        if (c == '\\' && i + 1 < text.size()) {
+            switch (text[++i]) {
+                case 'e': out += '\033'; break;
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                default: out += text[i]; break;
+            }
+        } else {
+            out += c;
+        }
+    }
+    return false;
+}
+
+static bool parseNumber(std::string_view text, double min, double max, double& out) {
+    std::string copy(text);
+    char* end;
+    double value = std::strtod(copy.c_str(), &end);
+    if (copy.empty() || *end || value < min || value > max) return false;
+    out = value;
+    return true;
+}
+
+bool loadConfig(const std::string& path, Config& out) {
+    std::ifstream in(path);
+    if (!in) return false;
+
+    std::string line;
+    size_t number = 0;
+    while (std::getline(in, line)) {
+        ++number;
+        auto fail = [&](const std::string& message) {
+            out.errors.push_back("linea " + std::to_string(number) + ": " + message);
+        };
+        std::string_view text = trim(line);
+        if (text.empty() || text[0] == '#') continue;
+        size_t eq = text.find('=');
+        if (eq == std::string_view::npos) {
+            fail("falta '='");
+            continue;
+        }
+        std::string value;
+        if (!parseValue(trim(text.substr(eq + 1)), value)) {
+            fail("comillas sin cerrar");
+            continue;
+        }
+        // "key = value" or "key name = value"
+        std::string_view left = trim(text.substr(0, eq));
+        size_t space = left.find_first_of(" \t");
+        std::string_view key = left.substr(0, space);
+        std::string name(space == std::string_view::npos ? std::string_view() : trim(left.substr(space)));
+
+        double numeric;
+        if (key == "prompt" && name.empty()) {
+            out.prompt = value;
+        } else if (key == "theme" && name.empty()) {
+            out.theme = value;
+        } else if (key == "theme") {
+            std::string colors[3];
+            size_t count = 0;
+            size_t pos = 0;
+            bool ok = true;
+            while (ok && (pos = value.find_first_not_of(" \t", pos)) != std::string::npos) {
+                size_t end = std::min(value.find_first_of(" \t", pos), value.size());
+                ok = count < 3 && parseColor(std::string_view(value).substr(pos, end - pos), colors[count++]);
+                pos = end;
+            }
+            if (!ok || count != 3) fail("el tema '" + name + "' necesita tres colores (usuario, ruta, git)");
+            else out.themes[name] = {colors[0], colors[1], colors[2]};
+        } else if (key == "alias" && !name.empty() && !value.empty()) {
+            out.aliases[name] = value;
+        } else if (key == "history_size" && name.empty()) {
+            if (parseNumber(value, 1, 1000000, numeric)) out.historySize = (size_t)numeric;
+            else fail("history_size debe estar entre 1 y 1000000");
+        } else if (key == "dir_max_age" && name.empty()) {
+            if (parseNumber(value, 10, 1e9, numeric)) out.dirMaxAge = numeric;
+            else fail("dir_max_age debe estar entre 10 y 1000000000");
+        } else {
+            fail("clave desconocida '" + std::string(left) + "'");
+        }
+    }
+    return true;
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    #ifdef __linux__
+        if (fd >= 0) close(fd);
+    #endif
+}
+
+void ConfigWatcher::watch(const std::string& file) {
+    path = file;
+    name = fs::path(file).filename().string();
+    mtime = modificationTime(path);
+    #ifdef __linux__
+        if (fd >= 0) close(fd);
+        // The directory, not the file: editors save by writing a new file and renaming it
+        std::string dir = fs::path(file).parent_path().string();
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd >= 0 && inotify_add_watch(fd, dir.empty() ? "." : dir.c_str(),
+                                         IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_ONLYDIR) < 0) {
+            close(fd);
+            fd = -1;
+        }
+    #endif
+}
+
+bool ConfigWatcher::changed() {
+    if (path.empty()) return false;
+    if (fd < 0) {
+        int64_t current = modificationTime(path);
+        if (current == mtime) return false;
+        mtime = current;
+        return true;
+    }
+    bool hit = false;
+    #ifdef __linux__
+        alignas(inotify_event) char buffer[4096];
+        ssize_t n;
+        while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+            for (char* p = buffer; p < buffer + n;) {
+                const inotify_event* event = (const inotify_event*)p;
+                p += sizeof(inotify_event) + event->len;
+                if ((event->mask & IN_Q_OVERFLOW) || (event->len && name == event->name)) hit = true;
+            }
+        }
+    #endif
+    return hit;
+}
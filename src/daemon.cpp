@@ -0,0 +1,1291 @@
+#include "daemon.h"
+#include "utils.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#ifndef _WIN32
+    #include <cerrno>
+    #include <csignal>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <pwd.h>
+    #include <sys/file.h>
+    #include <sys/mman.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+    #ifdef __linux__
+        #include <sys/inotify.h>
+    #endif
+#endif
+
+#ifndef MSG_NOSIGNAL
+    #define MSG_NOSIGNAL 0 // macOS: SO_NOSIGPIPE is set on the socket instead
+#endif
+
+using namespace DaemonProtocol;
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+class PayloadWriter {
+public:
+    void u8(uint8_t v) { data.push_back((char)v); }
+    void u32(uint32_t v) { data.append((const char*)&v, sizeof(v)); }
+    void u64(uint64_t v) { data.append((const char*)&v, sizeof(v)); }
+    void str(std::string_view s) {
+        u32((uint32_t)s.size());
+        data.append(s);
+    }
+
+    std::string data;
+};
+
+class PayloadReader {
+public:
+    PayloadReader(const char* p, size_t n) : p(p), end(p + n) {}
+
+    bool u8(uint8_t& v) { return take(&v, sizeof(v)); }
+    bool u32(uint32_t& v) { return take(&v, sizeof(v)); }
+    bool u64(uint64_t& v) { return take(&v, sizeof(v)); }
+    bool str(std::string_view& s) {
+        uint32_t n;
+        if (!u32(n) || (size_t)(end - p) < n) return false;
+        s = std::string_view(p, n);
+        p += n;
+        return true;
+    }
+
+private:
+    bool take(void* v, size_t n) {
+        if ((size_t)(end - p) < n) return false;
+        memcpy(v, p, n);
+        p += n;
+        return true;
+    }
+
+    const char* p;
+    const char* end;
+};
+
+void encodeGitStatus(PayloadWriter& w, const GitStatus& s) {
+    w.str(s.branch);
+    w.str(s.state);
+    w.u8((s.hasCounts ? 1 : 0) | (s.truncated ? 2 : 0) | (s.hasUpstream ? 4 : 0) | (s.aheadBehindApprox ? 8 : 0));
+    w.u64(s.staged);
+    w.u64(s.modified);
+    w.u64(s.untracked);
+    w.u32((uint32_t)s.ahead);
+    w.u32((uint32_t)s.behind);
+}
+
+bool decodeGitStatus(PayloadReader& r, GitStatus& s) {
+    std::string_view branch, state;
+    uint8_t flags;
+    uint64_t staged, modified, untracked;
+    uint32_t ahead, behind;
+    if (!r.str(branch) || !r.str(state) || !r.u8(flags) || !r.u64(staged) || !r.u64(modified) ||
+        !r.u64(untracked) || !r.u32(ahead) || !r.u32(behind)) {
+        return false;
+    }
+    s.branch = branch;
+    s.state = state;
+    s.hasCounts = flags & 1;
+    s.truncated = flags & 2;
+    s.hasUpstream = flags & 4;
+    s.aheadBehindApprox = flags & 8;
+    s.staged = staged;
+    s.modified = modified;
+    s.untracked = untracked;
+    s.ahead = (int)ahead;
+    s.behind = (int)behind;
+    return true;
+}
+
+} // namespace
+
+std::string daemonSocketPath() {
+    const char* path = getenv("MYTERM_DAEMON_SOCKET");
+    if (path && *path) return path;
+    #ifdef _WIN32
+        return "";
+    #else
+        const char* runtime = getenv("XDG_RUNTIME_DIR");
+        if (runtime && *runtime) return std::string(runtime) + "/myterm-daemon.sock";
+        return "/tmp/myterm-" + std::to_string(getuid()) + "/daemon.sock";
+    #endif
+}
+
+#ifdef _WIN32
+
+class DaemonClient::Reply {};
+
+bool DaemonClient::connect() { return false; }
+void DaemonClient::disconnect() {}
+bool DaemonClient::call(uint16_t, std::string_view, Reply&) { return false; }
+bool DaemonClient::hello(uint32_t&) { return false; }
+bool DaemonClient::userInfo(std::string&, std::string&) { return false; }
+bool DaemonClient::listDirectory(const std::string&, std::vector<CompletionEntry>&) { return false; }
+bool DaemonClient::pathCommands(const std::string&, std::vector<std::string>&) { return false; }
+bool DaemonClient::gitStatus(const std::string&, bool&, GitStatus&) { return false; }
+bool DaemonClient::loadHistory(size_t, std::vector<std::string>&) { return false; }
+bool DaemonClient::appendHistory(const std::string&) { return false; }
+bool DaemonClient::stats(DaemonStats&) { return false; }
+bool DaemonClient::shutdown() { return false; }
+
+int runDaemon() {
+    std::cout << Colors::RED << "Error: El daemon no esta disponible en Windows" << Colors::RESET << std::endl;
+    return 1;
+}
+
+bool spawnDaemon(uint32_t&) { return false; }
+
+#else
+
+// Sends `header` and `payload` as one message, with `passFd` attached to the
+// first byte. A full socket buffer (non-blocking daemon side) is waited out
+// for up to a second.
+static bool sendFrame(int fd, const Header& header, std::string_view payload, int passFd = -1) {
+    size_t total = sizeof(header) + payload.size();
+    size_t sent = 0;
+    while (sent < total) {
+        iovec iov[2];
+        int count = 0;
+        if (sent < sizeof(header)) {
+            iov[count++] = {(char*)&header + sent, sizeof(header) - sent};
+            if (!payload.empty()) iov[count++] = {(void*)payload.data(), payload.size()};
+        } else {
+            size_t offset = sent - sizeof(header);
+            iov[count++] = {(void*)(payload.data() + offset), payload.size() - offset};
+        }
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+        if (passFd >= 0 && sent == 0) {
+            memset(control, 0, sizeof(control));
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+            memcpy(CMSG_DATA(cmsg), &passFd, sizeof(int));
+        }
+        ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            struct pollfd pfd = {fd, POLLOUT, 0};
+            if (poll(&pfd, 1, 1000) <= 0) return false;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool receiveAll(int fd, void* buffer, size_t size) {
+    char* p = (char*)buffer;
+    while (size) {
+        ssize_t n = recv(fd, p, size, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+// Reads a response header and the descriptor that may come with it
+static bool receiveHeader(int fd, Header& header, int& passedFd) {
+    passedFd = -1;
+    iovec iov = {&header, sizeof(header)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    #ifdef MSG_CMSG_CLOEXEC
+        const int flags = MSG_CMSG_CLOEXEC;
+    #else
+        const int flags = 0;
+    #endif
+    ssize_t n;
+    do n = recvmsg(fd, &msg, flags);
+    while (n < 0 && errno == EINTR);
+    if (n <= 0) return false;
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) memcpy(&passedFd, CMSG_DATA(cmsg), sizeof(int));
+    }
+    return receiveAll(fd, (char*)&header + n, sizeof(header) - (size_t)n);
+}
+
+static bool peerIsSelf(int fd) {
+    #if defined(__linux__)
+        struct ucred cred;
+        socklen_t len = sizeof(cred);
+        return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 && cred.uid == getuid();
+    #else
+        uid_t uid;
+        gid_t gid;
+        return getpeereid(fd, &uid, &gid) == 0 && uid == getuid();
+    #endif
+}
+
+// Response payload: socket bytes, or a read-only mapping of the shared buffer
+class DaemonClient::Reply {
+public:
+    ~Reply() {
+        if (mapping) munmap(mapping, length);
+    }
+
+    const char* data() const { return mapping ? (const char*)mapping : inlineData.data(); }
+    size_t size() const { return mapping ? length : inlineData.size(); }
+    PayloadReader reader() const { return PayloadReader(data(), size()); }
+
+    std::string inlineData;
+    void* mapping = nullptr;
+    size_t length = 0;
+};
+
+bool DaemonClient::connect() {
+    disconnect();
+    std::string path = daemonSocketPath();
+    sockaddr_un addr{};
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) return false;
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    int s = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (s < 0) return false;
+    fcntl(s, F_SETFD, FD_CLOEXEC);
+    // A missing or stale socket fails right here, without any wait
+    if (::connect(s, (sockaddr*)&addr, sizeof(addr)) != 0 || !peerIsSelf(s)) {
+        close(s);
+        return false;
+    }
+    // A daemon that stops answering costs one short wait, then the session is standalone
+    timeval timeout = {2, 0};
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    #ifdef SO_NOSIGPIPE
+        int one = 1;
+        setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+    #endif
+    fd = s;
+    uint32_t pid;
+    return hello(pid);
+}
+
+void DaemonClient::disconnect() {
+    if (fd >= 0) close(fd);
+    fd = -1;
+}
+
+bool DaemonClient::call(uint16_t type, std::string_view payload, Reply& reply) {
+    if (fd < 0) return false;
+    Header request = {MAGIC, type, 0, (uint32_t)payload.size()};
+    Header response;
+    int shared = -1;
+    if (!sendFrame(fd, request, payload) || !receiveHeader(fd, response, shared) || response.magic != MAGIC) {
+        if (shared >= 0) close(shared);
+        disconnect();
+        return false;
+    }
+
+    bool ok = true;
+    if (response.flags & FLAG_SHARED) {
+        struct stat st;
+        ok = shared >= 0 && fstat(shared, &st) == 0 && (uint64_t)st.st_size >= response.length && response.length > 0;
+        #ifdef F_GET_SEALS
+            // Sealed against writes and shrinking: the mapping cannot change or fault under us
+            ok = ok && (fcntl(shared, F_GET_SEALS) & (F_SEAL_SHRINK | F_SEAL_WRITE)) == (F_SEAL_SHRINK | F_SEAL_WRITE);
+        #endif
+        if (ok) {
+            reply.mapping = mmap(nullptr, response.length, PROT_READ, MAP_SHARED, shared, 0);
+            reply.length = response.length;
+            if (reply.mapping == MAP_FAILED) {
+                reply.mapping = nullptr;
+                ok = false;
+            }
+        }
+    } else if (response.length > MAX_INLINE) {
+        ok = false;
+    } else {
+        reply.inlineData.resize(response.length);
+        ok = receiveAll(fd, reply.inlineData.data(), response.length);
+    }
+    if (shared >= 0) close(shared);
+    if (!ok) {
+        disconnect();
+        return false;
+    }
+    return response.type == OK;
+}
+
+bool DaemonClient::hello(uint32_t& pid) {
+    Reply reply;
+    return call(HELLO, {}, reply) && reply.reader().u32(pid);
+}
+
+bool DaemonClient::userInfo(std::string& user, std::string& host) {
+    Reply reply;
+    if (!call(USER_INFO, {}, reply)) return false;
+    PayloadReader r = reply.reader();
+    std::string_view u, h;
+    if (!r.str(u) || !r.str(h)) return false;
+    user = u;
+    host = h;
+    return true;
+}
+
+bool DaemonClient::listDirectory(const std::string& dir, std::vector<CompletionEntry>& out) {
+    PayloadWriter w;
+    w.str(dir);
+    Reply reply;
+    if (!call(LIST_DIRECTORY, w.data, reply)) return false;
+    PayloadReader r = reply.reader();
+    uint32_t count;
+    if (!r.u32(count)) return false;
+    out.clear();
+    out.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint8_t isDir;
+        std::string_view name;
+        if (!r.u8(isDir) || !r.str(name)) return false;
+        out.push_back({std::string(name), isDir != 0});
+    }
+    return true;
+}
+
+bool DaemonClient::pathCommands(const std::string& pathVar, std::vector<std::string>& out) {
+    PayloadWriter w;
+    w.str(pathVar);
+    Reply reply;
+    if (!call(PATH_COMMANDS, w.data, reply)) return false;
+    PayloadReader r = reply.reader();
+    uint32_t count;
+    if (!r.u32(count)) return false;
+    out.clear();
+    out.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string_view name;
+        if (!r.str(name)) return false;
+        out.emplace_back(name);
+    }
+    return true;
+}
+
+bool DaemonClient::gitStatus(const std::string& dir, bool& found, GitStatus& out) {
+    PayloadWriter w;
+    w.str(dir);
+    Reply reply;
+    if (!call(GIT_STATUS, w.data, reply)) return false;
+    PayloadReader r = reply.reader();
+    uint8_t present;
+    if (!r.u8(present)) return false;
+    found = present != 0;
+    return !found || decodeGitStatus(r, out);
+}
+
+bool DaemonClient::loadHistory(size_t max, std::vector<std::string>& out) {
+    PayloadWriter w;
+    w.u32((uint32_t)max);
+    Reply reply;
+    if (!call(HISTORY_LOAD, w.data, reply)) return false;
+    PayloadReader r = reply.reader();
+    uint32_t count;
+    if (!r.u32(count)) return false;
+    out.clear();
+    out.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string_view line;
+        if (!r.str(line)) return false;
+        out.emplace_back(line);
+    }
+    return true;
+}
+
+bool DaemonClient::appendHistory(const std::string& line) {
+    PayloadWriter w;
+    w.str(line);
+    Reply reply;
+    return call(HISTORY_APPEND, w.data, reply);
+}
+
+bool DaemonClient::stats(DaemonStats& out) {
+    Reply reply;
+    if (!call(STATS, {}, reply)) return false;
+    PayloadReader r = reply.reader();
+    return r.u32(out.pid) && r.u32(out.clients) && r.u64(out.uptimeSeconds) && r.u64(out.requests) &&
+           r.u64(out.hits) && r.u64(out.misses) && r.u64(out.sharedBytes);
+}
+
+bool DaemonClient::shutdown() {
+    Reply reply;
+    bool ok = call(SHUTDOWN, {}, reply);
+    disconnect();
+    return ok;
+}
+
+namespace {
+
+// Response bytes, moved into a sealed memfd when large enough to be worth
+// passing by descriptor. Cached entries keep theirs until the data changes,
+// so every client maps the same pages.
+class SharedBlob {
+public:
+    explicit SharedBlob(std::string bytes) : bytes(std::move(bytes)) {
+        #ifdef MFD_ALLOW_SEALING
+            if (this->bytes.size() < SHARED_MIN) return;
+            int memfd = memfd_create("myterm-daemon", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+            if (memfd < 0) return;
+            size_t written = 0;
+            while (written < this->bytes.size()) {
+                ssize_t n = write(memfd, this->bytes.data() + written, this->bytes.size() - written);
+                if (n <= 0) break;
+                written += (size_t)n;
+            }
+            if (written != this->bytes.size() ||
+                fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+                close(memfd);
+                return;
+            }
+            fd = memfd;
+            length = this->bytes.size();
+            this->bytes = std::string();
+        #endif
+    }
+    ~SharedBlob() {
+        if (fd >= 0) close(fd);
+    }
+
+    SharedBlob(const SharedBlob&) = delete;
+    SharedBlob& operator=(const SharedBlob&) = delete;
+
+    int fd = -1;       // sealed memfd, or -1 when the bytes are kept here
+    size_t length = 0; // memfd size
+    std::string bytes;
+};
+
+using BlobPtr = std::shared_ptr<SharedBlob>;
+
+volatile sig_atomic_t stopSignal = 0;
+
+void onStopSignal(int) {
+    stopSignal = 1;
+}
+
+class DaemonServer {
+public:
+    static constexpr size_t MAX_CLIENTS = 256;
+    static constexpr size_t MAX_REQUEST = 1 << 20;
+    static constexpr size_t MAX_DIRECTORIES = 256;
+    static constexpr size_t MAX_PATHS = 8;
+    static constexpr size_t MAX_REPOSITORIES = 16;
+    static constexpr size_t MAX_WATCHES = 8192; // per repository; beyond that, GIT_TTL
+    static constexpr size_t WATCH_STEP = 256;   // directories watched per loop turn
+    static constexpr auto GIT_TTL = std::chrono::seconds(1);
+    static constexpr auto IDLE_EXIT = std::chrono::hours(1);
+    static constexpr size_t HISTORY_SAVE_EVERY = 16;
+
+    ~DaemonServer();
+    int run();
+
+private:
+    struct Client {
+        int fd;
+        std::string input;
+    };
+
+    struct DirectoryEntry {
+        int64_t mtime;
+        bool racy;
+        BlobPtr blob;
+        uint64_t lastUse;
+    };
+
+    struct PathEntry {
+        ExecutableIndex index;
+        BlobPtr blob;
+        uint64_t lastUse;
+    };
+
+    struct PendingWatch {
+        std::string path;
+        bool recursive;
+        bool filtered; // subdirectories go through the GitDirectoryFilter
+    };
+
+    // Git status of one worktree. With inotify, every directory of the
+    // worktree that can matter (see GitDirectoryFilter) plus .git and its
+    // refs are watched and any event clears `valid`. The watches are added
+    // WATCH_STEP at a time between client requests, and only then is the
+    // status read, on the reader thread; a read that saw events come in is
+    // not trusted. Without inotify (or over MAX_WATCHES directories) the
+    // status is reused for GIT_TTL.
+    struct RepoEntry {
+        GitRepository repo;
+        GitStatus status;
+        bool found = false;
+        bool valid = false;
+        bool watched = false;     // every directory is watched
+        bool unwatchable = false;
+        bool reading = false;     // queued or running on the reader thread
+        uint64_t changes = 0;     // inotify events seen
+        uint64_t changesAtRead = 0;
+        uint64_t readTicket = 0;  // tells this entry's read from older ones
+        Clock::time_point filled;
+        std::vector<int> watches;
+        std::vector<PendingWatch> walk; // still to watch
+        std::unique_ptr<GitDirectoryFilter> filter;
+        uint64_t lastUse = 0;
+    };
+
+    struct Watch {
+        std::string path;
+        bool recursive;
+        bool filtered;
+        std::vector<std::string> repos; // worktrees sharing this directory
+    };
+
+    struct GitRead {
+        std::string worktree;
+        GitRepository repo;
+        uint64_t ticket;
+        Clock::time_point started;
+        bool found = false;
+        GitStatus status;
+    };
+
+    bool listen();
+    void acceptClients();
+    bool serviceClient(Client& client);
+    bool handle(int fd, uint16_t type, PayloadReader payload);
+    bool reply(int fd, const SharedBlob& blob);
+    bool reply(int fd, uint16_t status, std::string_view payload = {});
+
+    bool listDirectory(int fd, const std::string& dir);
+    bool pathCommands(int fd, const std::string& pathVar);
+    bool gitStatus(int fd, const std::string& dir);
+    bool loadHistory(int fd, uint32_t max);
+    bool appendHistory(int fd, std::string_view line);
+    void saveHistory();
+    bool stats(int fd);
+
+    void watchRepository(RepoEntry& entry);
+    bool watchStep();
+    bool addWatches(const std::string& worktree, RepoEntry& entry, size_t& budget);
+    void unwatchRepository(const std::string& worktree, RepoEntry& entry);
+    void drainEvents();
+    void startRead(const std::string& worktree, RepoEntry& entry);
+    void readerLoop();
+    void collectReads();
+
+    template <class Map>
+    void evictOldest(Map& map, size_t limit);
+
+    std::string socketPath;
+    int listenFd = -1;
+    int lockFd = -1;
+    ino_t socketInode = 0;
+    int inotifyFd = -1;
+    std::vector<Client> clients;
+    bool stopping = false;
+    Clock::time_point started = Clock::now();
+    uint64_t useCounter = 0;
+
+    std::string userInfo;
+    std::unordered_map<std::string, DirectoryEntry> directories;
+    std::unordered_map<std::string, PathEntry> paths;
+    std::unordered_map<std::string, RepoEntry> repos;
+    std::unordered_map<int, Watch> watches;
+
+    std::thread reader; // started with the first read
+    std::mutex readerMutex;
+    std::condition_variable readerCv;
+    std::deque<GitRead> readQueue;
+    std::vector<GitRead> readsDone;
+    bool readerStopping = false;
+    int readerPipe[2] = {-1, -1}; // wakes poll() when a read is done
+
+    std::string historyPath;
+    std::vector<std::string> history;    // what HISTORY_LOAD returns, unsaved lines included
+    std::vector<std::string> unsavedHistory;
+    int64_t historySize = -1; // file size `history` was read at, -1 to reload
+    uint32_t historyMax = 0;
+    BlobPtr historyBlob;
+
+    uint64_t requests = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
+
+DaemonServer::~DaemonServer() {
+    if (reader.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(readerMutex);
+            readerStopping = true;
+        }
+        readerCv.notify_one();
+        reader.join();
+    }
+    if (readerPipe[0] >= 0) close(readerPipe[0]);
+    if (readerPipe[1] >= 0) close(readerPipe[1]);
+    if (!historyPath.empty()) saveHistory();
+    for (Client& client : clients) close(client.fd);
+    if (listenFd >= 0) {
+        close(listenFd);
+        // Only remove the socket if it is still ours
+        struct stat st;
+        if (lstat(socketPath.c_str(), &st) == 0 && st.st_ino == socketInode) unlink(socketPath.c_str());
+    }
+    if (inotifyFd >= 0) close(inotifyFd);
+    if (lockFd >= 0) close(lockFd);
+}
+
+bool DaemonServer::listen() {
+    socketPath = daemonSocketPath();
+    sockaddr_un addr{};
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        std::cout << Colors::RED << "Error: Ruta de socket demasiado larga: " << socketPath << Colors::RESET << std::endl;
+        return false;
+    }
+
+    // The directory must belong to this user and not be writable by others,
+    // or someone else could replace the socket
+    std::string dir = fs::path(socketPath).parent_path().string();
+    if (dir.empty()) dir = ".";
+    mkdir(dir.c_str(), 0700);
+    struct stat st;
+    if (lstat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode) || st.st_uid != getuid() || (st.st_mode & 022)) {
+        std::cout << Colors::RED << "Error: El directorio del socket no es privado: " << dir << Colors::RESET << std::endl;
+        return false;
+    }
+
+    // One daemon per socket: the lock lives as long as the process
+    std::string lockPath = socketPath + ".lock";
+    lockFd = open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (lockFd < 0 || flock(lockFd, LOCK_EX | LOCK_NB) != 0) {
+        std::cout << Colors::YELLOW << "El daemon ya esta en ejecucion" << Colors::RESET << std::endl;
+        return false;
+    }
+    unlink(socketPath.c_str()); // left behind by a daemon that did not exit cleanly
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    if (listenFd < 0 || bind(listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || chmod(socketPath.c_str(), 0600) != 0 ||
+        ::listen(listenFd, 64) != 0) {
+        std::cout << Colors::RED << "Error: No se pudo crear el socket " << socketPath << ": " << strerror(errno) << Colors::RESET << std::endl;
+        return false;
+    }
+    fcntl(listenFd, F_SETFD, FD_CLOEXEC);
+    fcntl(listenFd, F_SETFL, O_NONBLOCK);
+    if (lstat(socketPath.c_str(), &st) == 0) socketInode = st.st_ino;
+    return true;
+}
+
+int DaemonServer::run() {
+    if (!listen()) return 1;
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGHUP, SIG_IGN);
+    signal(SIGTERM, onStopSignal);
+    signal(SIGINT, onStopSignal);
+
+    #ifdef __linux__
+        inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    #endif
+    if (pipe(readerPipe) != 0) return 1;
+    for (int end : readerPipe) {
+        fcntl(end, F_SETFD, FD_CLOEXEC);
+        fcntl(end, F_SETFL, O_NONBLOCK);
+    }
+
+    // Same lookups as Terminal::getUserInfo(), done once for every session
+    struct passwd* pw = getpwuid(getuid());
+    char hostname[256] = "";
+    gethostname(hostname, sizeof(hostname) - 1);
+    PayloadWriter info;
+    info.str(pw ? pw->pw_name : "usuario");
+    info.str(hostname);
+    userInfo = std::move(info.data);
+
+    std::string home = getHomeDirectory();
+    if (!home.empty()) historyPath = (fs::path(home) / ".myterm_history").string();
+
+    Clock::time_point lastClient = Clock::now();
+    std::vector<pollfd> fds;
+    bool walking = false;
+    while (!stopping && !stopSignal) {
+        fds.clear();
+        fds.push_back({listenFd, POLLIN, 0});
+        fds.push_back({inotifyFd, POLLIN, 0}); // ignored by poll() when -1
+        fds.push_back({readerPipe[0], POLLIN, 0});
+        for (const Client& client : clients) fds.push_back({client.fd, POLLIN, 0});
+        // Watches still to add: only check for requests in between
+        if (poll(fds.data(), fds.size(), walking ? 0 : 1000) < 0 && errno != EINTR) break;
+
+        if (fds[1].revents & POLLIN) drainEvents();
+        if (fds[2].revents & POLLIN) collectReads();
+        // Backwards, so erasing does not shift the clients still to visit
+        for (size_t i = clients.size(); i-- > 0;) {
+            if (!fds[i + 3].revents) continue;
+            if (!serviceClient(clients[i])) {
+                close(clients[i].fd);
+                clients.erase(clients.begin() + i);
+            }
+        }
+        if (fds[0].revents & POLLIN) acceptClients();
+        walking = watchStep();
+
+        Clock::time_point now = Clock::now();
+        if (!clients.empty()) lastClient = now;
+        else if (now - lastClient > IDLE_EXIT) break;
+    }
+    return 0;
+}
+
+void DaemonServer::acceptClients() {
+    while (true) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) return;
+        if (clients.size() >= MAX_CLIENTS || !peerIsSelf(fd)) {
+            close(fd);
+            continue;
+        }
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        #ifdef SO_NOSIGPIPE
+            int one = 1;
+            setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+        #endif
+        clients.push_back({fd, std::string()});
+    }
+}
+
+// Reads what the client sent and answers every complete request; false to
+// drop the client
+bool DaemonServer::serviceClient(Client& client) {
+    char buffer[65536];
+    while (true) {
+        ssize_t n = recv(client.fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            client.input.append(buffer, n);
+            if (client.input.size() > MAX_REQUEST + sizeof(Header)) return false;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        return false; // closed or failed
+    }
+
+    size_t consumed = 0;
+    while (client.input.size() - consumed >= sizeof(Header)) {
+        Header header;
+        memcpy(&header, client.input.data() + consumed, sizeof(header));
+        if (header.magic != MAGIC || header.length > MAX_REQUEST) return false;
+        if (client.input.size() - consumed - sizeof(header) < header.length) break;
+        PayloadReader payload(client.input.data() + consumed + sizeof(header), header.length);
+        if (!handle(client.fd, header.type, payload)) return false;
+        consumed += sizeof(header) + header.length;
+    }
+    client.input.erase(0, consumed);
+    return true;
+}
+
+bool DaemonServer::reply(int fd, uint16_t status, std::string_view payload) {
+    Header header = {MAGIC, status, 0, (uint32_t)payload.size()};
+    return sendFrame(fd, header, payload);
+}
+
+bool DaemonServer::reply(int fd, const SharedBlob& blob) {
+    if (blob.fd < 0) return reply(fd, OK, blob.bytes);
+    Header header = {MAGIC, OK, FLAG_SHARED, (uint32_t)blob.length};
+    return sendFrame(fd, header, {}, blob.fd);
+}
+
+bool DaemonServer::handle(int fd, uint16_t type, PayloadReader payload) {
+    ++requests;
+    std::string_view text;
+    uint32_t number;
+    switch (type) {
+        case HELLO: {
+            PayloadWriter w;
+            w.u32((uint32_t)getpid());
+            return reply(fd, OK, w.data);
+        }
+        case USER_INFO:
+            ++hits;
+            return reply(fd, OK, userInfo);
+        case LIST_DIRECTORY:
+            if (!payload.str(text)) return false;
+            return listDirectory(fd, std::string(text));
+        case PATH_COMMANDS:
+            if (!payload.str(text)) return false;
+            return pathCommands(fd, std::string(text));
+        case GIT_STATUS:
+            if (!payload.str(text)) return false;
+            return gitStatus(fd, std::string(text));
+        case HISTORY_LOAD:
+            if (!payload.u32(number)) return false;
+            return loadHistory(fd, number);
+        case HISTORY_APPEND:
+            if (!payload.str(text)) return false;
+            return appendHistory(fd, text);
+        case STATS:
+            return stats(fd);
+        case SHUTDOWN:
+            stopping = true;
+            return reply(fd, OK);
+        default:
+            return reply(fd, FAILED);
+    }
+}
+
+template <class Map>
+void DaemonServer::evictOldest(Map& map, size_t limit) {
+    while (map.size() > limit) {
+        auto oldest = map.begin();
+        for (auto it = map.begin(); it != map.end(); ++it) {
+            if (it->second.lastUse < oldest->second.lastUse) oldest = it;
+        }
+        if constexpr (std::is_same_v<typename Map::mapped_type, RepoEntry>) unwatchRepository(oldest->first, oldest->second);
+        map.erase(oldest);
+    }
+}
+
+static int64_t fileSize(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? (int64_t)st.st_size : 0;
+}
+
+static int64_t wallClockNanos() {
+    return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// A listing is reused while the directory mtime is unchanged (entries added,
+// removed or renamed all update it)
+bool DaemonServer::listDirectory(int fd, const std::string& dir) {
+    int64_t mtime = modificationTime(dir);
+    if (mtime < 0) return reply(fd, FAILED);
+    DirectoryEntry& entry = directories[dir];
+    entry.lastUse = ++useCounter;
+    if (entry.blob && !entry.racy && entry.mtime == mtime) {
+        ++hits;
+        return reply(fd, *entry.blob);
+    }
+
+    ++misses;
+    int64_t now = wallClockNanos();
+    std::vector<CompletionEntry> list = listCompletionEntries(dir);
+    PayloadWriter w;
+    w.u32((uint32_t)list.size());
+    for (const CompletionEntry& e : list) {
+        w.u8(e.isDir ? 1 : 0);
+        w.str(e.name);
+    }
+    entry.mtime = mtime;
+    entry.racy = now - mtime < RACY_WINDOW_NS;
+    entry.blob = std::make_shared<SharedBlob>(std::move(w.data));
+    BlobPtr blob = entry.blob;
+    evictOldest(directories, MAX_DIRECTORIES);
+    return reply(fd, *blob);
+}
+
+bool DaemonServer::pathCommands(int fd, const std::string& pathVar) {
+    PathEntry& entry = paths[pathVar];
+    entry.lastUse = ++useCounter;
+    if (entry.index.refresh(pathVar) || !entry.blob) {
+        ++misses;
+        const std::vector<std::string>& names = entry.index.names();
+        PayloadWriter w;
+        w.u32((uint32_t)names.size());
+        for (const std::string& name : names) w.str(name);
+        entry.blob = std::make_shared<SharedBlob>(std::move(w.data));
+    } else {
+        ++hits;
+    }
+    BlobPtr blob = entry.blob;
+    evictOldest(paths, MAX_PATHS);
+    return reply(fd, *blob);
+}
+
+// Only cache hits are answered with a status. Otherwise the entry starts
+// filling off the poll loop and the session is told FAILED, so it reads the
+// status itself this time instead of waiting.
+bool DaemonServer::gitStatus(int fd, const std::string& dir) {
+    GitRepository repo;
+    if (!findGitRepository(dir, repo)) return reply(fd, OK, std::string_view("\0", 1));
+
+    drainEvents();
+    RepoEntry& entry = repos[repo.worktree];
+    entry.lastUse = ++useCounter;
+    if (entry.valid && (entry.watched || Clock::now() - entry.filled < GIT_TTL)) {
+        ++hits;
+        PayloadWriter w;
+        w.u8(entry.found ? 1 : 0);
+        if (entry.found) encodeGitStatus(w, entry.status);
+        evictOldest(repos, MAX_REPOSITORIES);
+        return reply(fd, OK, w.data);
+    }
+
+    ++misses;
+    entry.repo = repo;
+    if (!entry.watched && !entry.unwatchable && entry.walk.empty()) watchRepository(entry);
+    if (entry.walk.empty()) startRead(repo.worktree, entry);
+    evictOldest(repos, MAX_REPOSITORIES);
+    return reply(fd, FAILED);
+}
+
+// Queues the worktree, .git and its refs for watchStep()
+void DaemonServer::watchRepository(RepoEntry& entry) {
+    if (inotifyFd < 0) {
+        entry.unwatchable = true;
+        return;
+    }
+    const GitRepository& repo = entry.repo;
+    entry.filter = std::make_unique<GitDirectoryFilter>(repo);
+    // info/ for exclude, which decides what the filter skips
+    entry.walk = {{repo.commonDir + "/refs", true, false},
+                  {repo.commonDir + "/info", false, false},
+                  {repo.commonDir, false, false},
+                  {repo.gitDir, false, false},
+                  {repo.worktree, true, true}};
+}
+
+// Adds up to WATCH_STEP watches for the repositories being walked and reads
+// the status of those that are done; true while any walk is left
+bool DaemonServer::watchStep() {
+    size_t budget = WATCH_STEP;
+    bool left = false;
+    for (auto& [worktree, entry] : repos) {
+        if (entry.walk.empty()) continue;
+        if (!addWatches(worktree, entry, budget)) {
+            unwatchRepository(worktree, entry);
+            entry.unwatchable = true;
+        }
+        if (!entry.walk.empty()) {
+            left = true;
+            continue;
+        }
+        entry.watched = !entry.unwatchable;
+        startRead(worktree, entry);
+    }
+    return left;
+}
+
+// Watches directories from entry.walk, and queues the subdirectories of the
+// recursive ones, on behalf of `worktree`; stops when `budget` runs out.
+// False once MAX_WATCHES is exceeded or the kernel has no watches left.
+bool DaemonServer::addWatches(const std::string& worktree, RepoEntry& entry, size_t& budget) {
+    #ifdef __linux__
+        const uint32_t mask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO |
+                              IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+        while (!entry.walk.empty() && budget > 0) {
+            PendingWatch dir = std::move(entry.walk.back());
+            entry.walk.pop_back();
+            budget--;
+            if (entry.watches.size() >= MAX_WATCHES) return false;
+            int wd = inotify_add_watch(inotifyFd, dir.path.c_str(), mask);
+            if (wd < 0) {
+                if (errno == ENOENT || errno == ENOTDIR || errno == EACCES) continue; // gone or private
+                return false; // out of watches
+            }
+            Watch& watch = watches[wd];
+            if (watch.repos.empty()) {
+                watch.path = dir.path;
+                watch.recursive = dir.recursive;
+                watch.filtered = dir.filtered;
+            }
+            if (std::find(watch.repos.begin(), watch.repos.end(), worktree) == watch.repos.end()) {
+                watch.repos.push_back(worktree);
+                entry.watches.push_back(wd);
+            }
+            if (!dir.recursive) continue;
+            forEachDirectoryEntry(dir.path + "/", [&](const char* name, bool isDir, bool isLink) {
+                if (!isDir || isLink || strcmp(name, ".git") == 0) return;
+                std::string path = dir.path + "/" + name;
+                if (dir.filtered && !entry.filter->wanted(path.substr(worktree.size() + 1) + "/")) return;
+                entry.walk.push_back({std::move(path), true, dir.filtered});
+            });
+        }
+        return true;
+    #else
+        (void)worktree, (void)entry, (void)budget;
+        return false;
+    #endif
+}
+
+void DaemonServer::unwatchRepository(const std::string& worktree, RepoEntry& entry) {
+    #ifdef __linux__
+        for (int wd : entry.watches) {
+            auto it = watches.find(wd);
+            if (it == watches.end()) continue;
+            auto& owners = it->second.repos;
+            owners.erase(std::remove(owners.begin(), owners.end(), worktree), owners.end());
+            if (owners.empty()) {
+                inotify_rm_watch(inotifyFd, wd);
+                watches.erase(it);
+            }
+        }
+    #endif
+    entry.watches.clear();
+    entry.walk.clear();
+    entry.filter.reset();
+    entry.watched = false;
+    entry.valid = false;
+}
+
+void DaemonServer::drainEvents() {
+    #ifdef __linux__
+        if (inotifyFd < 0) return;
+        alignas(inotify_event) char buffer[65536];
+        std::vector<std::string> rulesChanged;
+        while (true) {
+            ssize_t n = read(inotifyFd, buffer, sizeof(buffer));
+            if (n <= 0) break;
+            for (char* p = buffer; p < buffer + n;) {
+                const inotify_event* event = (const inotify_event*)p;
+                p += sizeof(inotify_event) + event->len;
+                if (event->mask & IN_Q_OVERFLOW) {
+                    for (auto& [worktree, entry] : repos) {
+                        entry.valid = false;
+                        entry.changes++;
+                    }
+                    continue;
+                }
+                auto it = watches.find(event->wd);
+                if (it == watches.end()) continue;
+                for (const std::string& worktree : it->second.repos) {
+                    auto repo = repos.find(worktree);
+                    if (repo == repos.end()) continue;
+                    repo->second.valid = false;
+                    repo->second.changes++;
+                }
+                if (event->mask & IN_IGNORED) {
+                    // Directory deleted: the kernel already dropped the watch
+                    for (const std::string& worktree : it->second.repos) {
+                        auto repo = repos.find(worktree);
+                        if (repo == repos.end()) continue;
+                        auto& list = repo->second.watches;
+                        list.erase(std::remove(list.begin(), list.end(), event->wd), list.end());
+                    }
+                    watches.erase(it);
+                    continue;
+                }
+                if (event->len && (strcmp(event->name, ".gitignore") == 0 || strcmp(event->name, "exclude") == 0)) {
+                    // Ignore rules changed, and with them what should be watched
+                    rulesChanged.insert(rulesChanged.end(), it->second.repos.begin(), it->second.repos.end());
+                    continue;
+                }
+                if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO)) && it->second.recursive &&
+                    event->len && strcmp(event->name, ".git") != 0) {
+                    // New directory: watch it (and what it may already contain) as well
+                    std::string path = it->second.path + "/" + event->name;
+                    for (const std::string& worktree : it->second.repos) {
+                        auto repo = repos.find(worktree);
+                        if (repo == repos.end()) continue;
+                        RepoEntry& entry = repo->second;
+                        if (!entry.watched && entry.walk.empty()) continue;
+                        bool filtered = it->second.filtered && entry.filter &&
+                                        path.compare(0, worktree.size() + 1, worktree + "/") == 0;
+                        if (filtered && !entry.filter->wanted(path.substr(worktree.size() + 1) + "/")) continue;
+                        entry.walk.push_back({path, true, filtered});
+                    }
+                }
+            }
+        }
+        // Walked again on the next request
+        for (const std::string& worktree : rulesChanged) {
+            auto repo = repos.find(worktree);
+            if (repo != repos.end()) unwatchRepository(worktree, repo->second);
+        }
+    #endif
+}
+
+// Events counted from here on make the result untrustworthy
+void DaemonServer::startRead(const std::string& worktree, RepoEntry& entry) {
+    if (entry.reading) return;
+    entry.reading = true;
+    entry.readTicket = ++useCounter;
+    entry.changesAtRead = entry.changes;
+    GitRead job;
+    job.worktree = worktree;
+    job.repo = entry.repo;
+    job.ticket = entry.readTicket;
+    job.started = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(readerMutex);
+        readQueue.push_back(std::move(job));
+    }
+    if (!reader.joinable()) reader = std::thread(&DaemonServer::readerLoop, this);
+    readerCv.notify_one();
+}
+
+// Reader thread: git status reads, one at a time, off the poll loop
+void DaemonServer::readerLoop() {
+    std::unique_lock<std::mutex> lock(readerMutex);
+    while (true) {
+        readerCv.wait(lock, [this] { return readerStopping || !readQueue.empty(); });
+        if (readerStopping) return;
+        GitRead read = std::move(readQueue.front());
+        readQueue.pop_front();
+        lock.unlock();
+        read.found = readGitStatus(read.repo, read.status);
+        lock.lock();
+        readsDone.push_back(std::move(read));
+        char wake = 0;
+        if (write(readerPipe[1], &wake, 1) < 0) {} // full pipe: a wakeup is pending anyway
+    }
+}
+
+void DaemonServer::collectReads() {
+    char buffer[256];
+    while (read(readerPipe[0], buffer, sizeof(buffer)) > 0) {}
+    std::vector<GitRead> done;
+    {
+        std::lock_guard<std::mutex> lock(readerMutex);
+        done.swap(readsDone);
+    }
+    drainEvents(); // anything that changed during the reads
+    for (GitRead& read : done) {
+        auto repo = repos.find(read.worktree);
+        if (repo == repos.end() || repo->second.readTicket != read.ticket) continue; // evicted meanwhile
+        RepoEntry& entry = repo->second;
+        entry.reading = false;
+        entry.found = read.found;
+        entry.status = std::move(read.status);
+        entry.valid = entry.changes == entry.changesAtRead;
+        entry.filled = read.started;
+    }
+}
+
+// Lines sent by sessions are written like a standalone session writes its
+// own: every HISTORY_SAVE_EVERY lines and on exit
+bool DaemonServer::loadHistory(int fd, uint32_t max) {
+    if (historyPath.empty()) return reply(fd, FAILED);
+    if (fileSize(historyPath) != historySize || max != historyMax || !historyBlob) {
+        // First load, another max, or lines appended by a standalone session
+        ++misses;
+        compactHistoryFile(historyPath, max);
+        readHistoryFile(historyPath, max, history);
+        historySize = fileSize(historyPath);
+        historyMax = max;
+        history.insert(history.end(), unsavedHistory.begin(), unsavedHistory.end());
+        if (history.size() > max) history.erase(history.begin(), history.end() - max);
+        historyBlob.reset();
+    } else {
+        ++hits;
+    }
+    if (!historyBlob) {
+        PayloadWriter w;
+        w.u32((uint32_t)history.size());
+        for (const std::string& line : history) w.str(line);
+        historyBlob = std::make_shared<SharedBlob>(std::move(w.data));
+    }
+    return reply(fd, *historyBlob);
+}
+
+bool DaemonServer::appendHistory(int fd, std::string_view line) {
+    if (historyPath.empty()) return reply(fd, FAILED);
+    unsavedHistory.emplace_back(line);
+    if (historyBlob) {
+        history.emplace_back(line);
+        if (history.size() > historyMax) history.erase(history.begin());
+        historyBlob.reset();
+    }
+    if (unsavedHistory.size() >= HISTORY_SAVE_EVERY) saveHistory();
+    return reply(fd, OK);
+}
+
+void DaemonServer::saveHistory() {
+    if (unsavedHistory.empty()) return;
+    int64_t before = fileSize(historyPath);
+    if (!appendHistoryFile(historyPath, unsavedHistory)) return;
+    // Still in sync unless someone else wrote in between
+    historySize = before == historySize ? fileSize(historyPath) : -1;
+    unsavedHistory.clear();
+}
+
+bool DaemonServer::stats(int fd) {
+    uint64_t shared = 0;
+    auto count = [&](const BlobPtr& blob) {
+        if (blob) shared += blob->length;
+    };
+    for (const auto& [dir, entry] : directories) count(entry.blob);
+    for (const auto& [path, entry] : paths) count(entry.blob);
+    count(historyBlob);
+
+    PayloadWriter w;
+    w.u32((uint32_t)getpid());
+    w.u32((uint32_t)clients.size());
+    w.u64((uint64_t)std::chrono::duration_cast<std::chrono::seconds>(Clock::now() - started).count());
+    w.u64(requests);
+    w.u64(hits);
+    w.u64(misses);
+    w.u64(shared);
+    return reply(fd, OK, w.data);
+}
+
+} // namespace
+
+int runDaemon() {
+    stopSignal = 0;
+    DaemonServer server;
+    return server.run();
+}
+
+bool spawnDaemon(uint32_t& pid) {
+    std::string exe = "myterm";
+    #ifdef __linux__
+        char buffer[4096];
+        ssize_t n = readlink("/proc/self/exe", buffer, sizeof(buffer) - 1);
+        if (n > 0) exe.assign(buffer, n);
+    #endif
+
+    pid_t child = fork();
+    if (child < 0) return false;
+    if (child == 0) {
+        // Detached: own session, no terminal, reparented to init by the second fork
+        setsid();
+        if (fork() != 0) _exit(0);
+        int devnull = open("/dev/null", O_RDWR);
+        if (devnull >= 0) {
+            dup2(devnull, STDIN_FILENO);
+            dup2(devnull, STDOUT_FILENO);
+            dup2(devnull, STDERR_FILENO);
+            if (devnull > STDERR_FILENO) close(devnull);
+        }
+        if (chdir("/") != 0) _exit(126);
+        execlp(exe.c_str(), exe.c_str(), "--daemon", (char*)nullptr);
+        _exit(127);
+    }
+    waitpid(child, nullptr, 0);
+
+    DaemonClient probe;
+    for (int attempt = 0; attempt < 200; ++attempt) {
+        if (probe.connect()) return probe.hello(pid);
+        usleep(10000);
+    }
+    return false;
+}
+
+#endif
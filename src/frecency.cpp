@@ -0,0 +1,412 @@
+#include "frecency.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// File layout, native endianness, columns so a scan only streams the masks:
+//   header  "MTDJ" | u32 version | u64 count | u64 pool size | u64 reserved
+//   f64 rank[count] | i64 last access[count] | u64 character mask[count] |
+//   u32 path offset[count] | u32 path length[count]
+//   pool    the paths, back to back
+static const char MAGIC[4] = {'M', 'T', 'D', 'J'};
+static const uint32_t VERSION = 1;
+static const size_t HEADER_SIZE = 32;
+static const size_t RECORD_SIZE = 32; // bytes per entry over all columns
+
+template <typename T>
+static T readAt(const char* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+template <typename T>
+static void append(std::string& out, T value) {
+    out.append((const char*)&value, sizeof(T));
+}
+
+static double frecency(double rank, int64_t lastAccess, int64_t now) {
+    int64_t age = now - lastAccess;
+    if (age < 3600) return rank * 4;
+    if (age < 86400) return rank * 2;
+    if (age < 604800) return rank / 2;
+    return rank / 4;
+}
+
+static inline char asciiLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c + 32) : c;
+}
+
+// `needle` is already lowercase
+static size_t findIgnoreCase(std::string_view haystack, std::string_view needle, size_t from) {
+    if (needle.size() > haystack.size()) return std::string_view::npos;
+    for (size_t i = from; i + needle.size() <= haystack.size(); ++i) {
+        size_t k = 0;
+        while (k < needle.size() && asciiLower(haystack[i + k]) == needle[k]) k++;
+        if (k == needle.size()) return i;
+    }
+    return std::string_view::npos;
+}
+
+// One bit per letter and digit (case-insensitive), the rest share 28 bits
+static inline uint64_t characterBit(char c) {
+    unsigned char u = (unsigned char)asciiLower(c);
+    if (u >= 'a' && u <= 'z') return 1ULL << (u - 'a');
+    if (u >= '0' && u <= '9') return 1ULL << (26 + u - '0');
+    return 1ULL << (36 + u % 28);
+}
+
+static uint64_t characterMask(std::string_view text) {
+    uint64_t mask = 0;
+    for (char c : text) mask |= characterBit(c);
+    return mask;
+}
+
+static uint64_t lastComponentMask(std::string_view path) {
+    size_t slash = path.find_last_of("/\\");
+    return characterMask(slash == std::string_view::npos ? path : path.substr(slash + 1));
+}
+
+// Keywords in order; the last one inside the last path component, which is
+// also the cheapest way to reject most entries
+static bool matchesKeywords(std::string_view path, const std::vector<std::string>& keywords) {
+    size_t slash = path.find_last_of("/\\");
+    size_t lastComponent = slash == std::string_view::npos ? 0 : slash + 1;
+    size_t lastHit = findIgnoreCase(path, keywords.back(), lastComponent);
+    if (lastHit == std::string_view::npos) return false;
+
+    size_t pos = 0;
+    for (size_t k = 0; k + 1 < keywords.size(); ++k) {
+        size_t hit = findIgnoreCase(path, keywords[k], pos);
+        if (hit == std::string_view::npos || hit + keywords[k].size() > lastHit) return false;
+        pos = hit + keywords[k].size();
+    }
+    return true;
+}
+
+bool FrecencyIndex::load(const std::string& path) {
+    file = path;
+    loaded = false;
+    entries.clear();
+    positions.clear();
+    for (auto& bucket : buckets) bucket.clear();
+    mappedCount = 0;
+    checkCursor = 0;
+    scale = 1;
+    total = 0;
+    changes = 0;
+    journal.clear();
+    std::error_code ec;
+    fileTime = modificationTime(path);
+    fileSize = fs::file_size(path, ec);
+    if (ec) fileSize = 0;
+
+    if (mapped.open(path) && mapped.size() >= HEADER_SIZE && std::memcmp(mapped.data(), MAGIC, 4) == 0 &&
+        readAt<uint32_t>(mapped.data() + 4) == VERSION) {
+        uint64_t count = readAt<uint64_t>(mapped.data() + 8);
+        uint64_t poolSize = readAt<uint64_t>(mapped.data() + 16);
+        if (count <= (mapped.size() - HEADER_SIZE) / RECORD_SIZE &&
+            poolSize == mapped.size() - HEADER_SIZE - count * RECORD_SIZE) {
+            mappedCount = (size_t)count;
+            records = mapped.data() + HEADER_SIZE;
+            pool = records + mappedCount * RECORD_SIZE;
+            return true;
+        }
+    }
+    mapped.close();
+    loaded = true; // nothing usable: start empty
+    return false;
+}
+
+std::string_view FrecencyIndex::pathAt(size_t i) const {
+    if (loaded) return entries[i].path;
+    uint32_t offset = readAt<uint32_t>(records + mappedCount * 24 + i * 4);
+    uint32_t length = readAt<uint32_t>(records + mappedCount * 28 + i * 4);
+    size_t poolSize = (size_t)(mapped.data() + mapped.size() - pool);
+    if ((size_t)offset + length > poolSize) return {};
+    return std::string_view(pool + offset, length);
+}
+
+double FrecencyIndex::rankAt(size_t i) const {
+    return loaded ? entries[i].rank * scale : readAt<double>(records + i * 8);
+}
+
+int64_t FrecencyIndex::lastAccessAt(size_t i) const {
+    return loaded ? entries[i].lastAccess : readAt<int64_t>(records + mappedCount * 8 + i * 8);
+}
+
+uint64_t FrecencyIndex::maskAt(size_t i) const {
+    return loaded ? entries[i].mask : readAt<uint64_t>(records + mappedCount * 16 + i * 8);
+}
+
+// First change: copy the mapped entries into memory and drop the mapping
+void FrecencyIndex::materialize() {
+    if (loaded) return;
+    TRACE_SCOPE("FrecencyIndex::materialize");
+    entries.reserve(mappedCount + 1);
+    positions.reserve(mappedCount + 1);
+    for (size_t i = 0; i < mappedCount; ++i) {
+        std::string_view path = pathAt(i);
+        if (path.empty() || positions.count(std::string(path))) continue;
+        positions.emplace(std::string(path), entries.size());
+        entries.push_back({std::string(path), rankAt(i), lastAccessAt(i), maskAt(i), 0, 0});
+        total += entries.back().rank;
+        place(entries.size() - 1);
+    }
+    loaded = true;
+    mapped.close();
+    records = pool = nullptr;
+    mappedCount = 0;
+}
+
+bool FrecencyIndex::save() {
+    if (!changes || file.empty()) return true;
+    TRACE_SCOPE("FrecencyIndex::save");
+    #ifndef _WIN32
+        int lock = lockFile(file, O_RDONLY | O_CREAT);
+        if (lock < 0) return false;
+    #endif
+    // Another session saved since we last read or wrote the file: start over
+    // from its copy and redo this session's changes on top
+    std::error_code ec;
+    uint64_t size = fs::file_size(file, ec);
+    if (modificationTime(file) != fileTime || (ec ? 0 : size) != fileSize) {
+        std::vector<Change> replay = std::move(journal);
+        load(std::string(file));
+        for (const Change& change : replay) {
+            if (change.time < 0) remove(change.dir);
+            else add(change.dir, change.time);
+        }
+    }
+    bool ok = write();
+    #ifndef _WIN32
+        close(lock);
+    #endif
+    return ok;
+}
+
+bool FrecencyIndex::write() {
+    materialize();
+
+    std::string data;
+    data.reserve(HEADER_SIZE + entries.size() * (RECORD_SIZE + 48));
+    data.append(MAGIC, 4);
+    append<uint32_t>(data, VERSION);
+    append<uint64_t>(data, entries.size());
+    append<uint64_t>(data, 0); // pool size, patched below
+    append<uint64_t>(data, 0);
+    // Highest rank first, so lookups on the mapped file can stop early
+    std::vector<uint32_t> order(entries.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = (uint32_t)i;
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return entries[a].rank > entries[b].rank; });
+
+    for (uint32_t i : order) append<double>(data, entries[i].rank * scale);
+    for (uint32_t i : order) append<int64_t>(data, entries[i].lastAccess);
+    for (uint32_t i : order) append<uint64_t>(data, entries[i].mask);
+    uint32_t offset = 0;
+    for (uint32_t i : order) {
+        append<uint32_t>(data, offset);
+        offset += (uint32_t)entries[i].path.size();
+    }
+    for (uint32_t i : order) append<uint32_t>(data, (uint32_t)entries[i].path.size());
+    uint64_t poolSize = offset;
+    std::memcpy(&data[16], &poolSize, sizeof(poolSize));
+    for (uint32_t i : order) data += entries[i].path;
+
+    std::string temp = file + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out.write(data.data(), (std::streamsize)data.size())) return false;
+    }
+    // Taken before the rename: once it is in place another session may lock it
+    int64_t written = modificationTime(temp);
+    std::error_code ec;
+    fs::rename(temp, file, ec);
+    if (ec) {
+        fs::remove(temp, ec);
+        return false;
+    }
+    fileTime = written;
+    fileSize = data.size();
+    journal.clear();
+    changes = 0;
+    return true;
+}
+
+static inline unsigned bucketOf(double rank) {
+    int exponent = rank >= 1 ? std::ilogb(rank) : 0;
+    return (unsigned)std::min(exponent, 63);
+}
+
+void FrecencyIndex::place(size_t i) {
+    Entry& e = entries[i];
+    e.bucket = bucketOf(e.rank);
+    e.slot = (uint32_t)buckets[e.bucket].size();
+    buckets[e.bucket].push_back({e.mask, (uint32_t)i});
+}
+
+void FrecencyIndex::unplace(size_t i) {
+    std::vector<BucketItem>& bucket = buckets[entries[i].bucket];
+    BucketItem moved = bucket.back();
+    bucket[entries[i].slot] = moved;
+    entries[moved.index].slot = entries[i].slot;
+    bucket.pop_back();
+}
+
+// Swap-and-pop: only the last entry changes position
+void FrecencyIndex::removeAt(size_t i) {
+    total -= entries[i].rank * scale;
+    unplace(i);
+    positions.erase(entries[i].path);
+    size_t last = entries.size() - 1;
+    if (i != last) {
+        entries[i] = std::move(entries[last]);
+        positions[entries[i].path] = i;
+        buckets[entries[i].bucket][entries[i].slot].index = (uint32_t)i;
+    }
+    entries.pop_back();
+    changes++;
+}
+
+bool FrecencyIndex::remove(std::string_view dir) {
+    materialize();
+    journal.push_back({std::string(dir), -1});
+    auto it = positions.find(std::string(dir));
+    if (it == positions.end()) return false;
+    removeAt(it->second);
+    return true;
+}
+
+void FrecencyIndex::age() {
+    double factor = 0.9 * maxAge / total;
+    scale *= factor;
+    total *= factor;
+    // Entries now below 1 can only sit in the buckets under 1 / scale
+    double threshold = 1 / scale;
+    std::vector<uint32_t> expired;
+    for (unsigned b = 0; b < 64 && std::ldexp(1.0, (int)b) < threshold; ++b) {
+        for (const BucketItem& item : buckets[b]) {
+            if (entries[item.index].rank < threshold) expired.push_back(item.index);
+        }
+    }
+    std::sort(expired.rbegin(), expired.rend());
+    for (uint32_t i : expired) removeAt(i);
+    // Fold the scale back in long before doubles lose precision
+    if (scale < 1e-6) {
+        for (auto& bucket : buckets) bucket.clear();
+        for (size_t i = 0; i < entries.size(); ++i) {
+            entries[i].rank *= scale;
+            place(i);
+        }
+        scale = 1;
+    }
+}
+
+void FrecencyIndex::checkExistence() {
+    for (unsigned n = 0; n < EXISTENCE_CHECKS && !entries.empty(); ++n) {
+        if (checkCursor >= entries.size()) checkCursor = 0;
+        std::error_code ec;
+        // A removed entry's slot receives the last one, which is checked next
+        if (!fs::is_directory(entries[checkCursor].path, ec)) removeAt(checkCursor);
+        else checkCursor++;
+    }
+}
+
+void FrecencyIndex::add(const std::string& dir, int64_t now) {
+    TRACE_SCOPE("FrecencyIndex::add");
+    materialize();
+    journal.push_back({dir, now});
+    auto it = positions.find(dir);
+    if (it != positions.end()) {
+        size_t i = it->second;
+        unplace(i);
+        entries[i].rank += 1 / scale;
+        entries[i].lastAccess = now;
+        place(i);
+    } else {
+        positions.emplace(dir, entries.size());
+        entries.push_back({dir, 1 / scale, now, lastComponentMask(dir), 0, 0});
+        place(entries.size() - 1);
+    }
+    total += 1;
+    changes++;
+    if (total > maxAge) age();
+    checkExistence();
+}
+
+bool FrecencyIndex::query(const std::vector<std::string_view>& keywords, std::string_view exclude, int64_t now, std::string& out) {
+    TRACE_SCOPE("FrecencyIndex::query");
+    std::vector<std::string> lowered;
+    for (std::string_view k : keywords) {
+        std::string word;
+        for (char c : k) word += asciiLower(c);
+        while (word.size() > 1 && (word.back() == '/' || word.back() == '\\')) word.pop_back();
+        if (!word.empty()) lowered.push_back(std::move(word));
+    }
+    if (lowered.empty()) return false;
+    uint64_t required = characterMask(lowered.back());
+
+    while (true) {
+        size_t best = SIZE_MAX;
+        double bestScore = 0;
+        auto consider = [&](size_t i) {
+            std::string_view path = pathAt(i);
+            if (path == exclude || !matchesKeywords(path, lowered)) return;
+            double score = frecency(rankAt(i), lastAccessAt(i), now);
+            if (score > bestScore) {
+                bestScore = score;
+                best = i;
+            }
+        };
+        // Nothing can score more than 4x its rank: stop at the first entry
+        // (or bucket) whose rank bound can't beat the best so far
+        if (loaded) {
+            for (unsigned b = 64; b-- > 0;) {
+                if (buckets[b].empty()) continue;
+                if (std::ldexp(scale, (int)b + 1) * 4 <= bestScore) break;
+                for (const BucketItem& item : buckets[b]) {
+                    if ((item.mask & required) == required) consider(item.index);
+                }
+            }
+        } else {
+            const char* masks = records + mappedCount * 16;
+            for (size_t i = 0; i < mappedCount; ++i) {
+                if ((readAt<uint64_t>(masks + i * 8) & required) != required) continue;
+                if (rankAt(i) * 4 <= bestScore) break; // sorted by rank
+                consider(i);
+            }
+        }
+        if (best == SIZE_MAX) return false;
+
+        std::string path(pathAt(best));
+        std::error_code ec;
+        if (fs::is_directory(path, ec)) {
+            out = std::move(path);
+            return true;
+        }
+        remove(path);
+    }
+}
+
+std::vector<FrecencyMatch> FrecencyIndex::top(size_t count, int64_t now) const {
+    std::vector<FrecencyMatch> all;
+    all.reserve(size());
+    for (size_t i = 0, n = size(); i < n; ++i) {
+        all.push_back({std::string(pathAt(i)), frecency(rankAt(i), lastAccessAt(i), now)});
+    }
+    count = std::min(count, all.size());
+    std::partial_sort(all.begin(), all.begin() + count, all.end(),
+                      [](const FrecencyMatch& a, const FrecencyMatch& b) { return a.score > b.score; });
+    all.resize(count);
+    return all;
+}
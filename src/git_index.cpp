@@ -0,0 +1,335 @@
+#include "git_index.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <sys/stat.h>
+#if defined(__linux__)
+    #include <fcntl.h>
+    #include <sys/sysmacros.h>
+#endif
+
+static inline uint32_t be32(const uint8_t* p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static inline uint16_t be16(const uint8_t* p) {
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+// git's "offset" varint (index v4 paths, untracked cache)
+static bool decodeVarint(const uint8_t*& p, const uint8_t* end, uint64_t& value) {
+    if (p >= end) return false;
+    uint8_t c = *p++;
+    value = c & 127;
+    while (c & 128) {
+        if (p >= end) return false;
+        c = *p++;
+        value = ((value + 1) << 7) | (c & 127);
+    }
+    return true;
+}
+
+static const uint8_t* readStatData(const uint8_t* p, GitStatData& st) {
+    st.ctimeSec = be32(p);
+    st.ctimeNsec = be32(p + 4);
+    st.mtimeSec = be32(p + 8);
+    st.mtimeNsec = be32(p + 12);
+    st.dev = be32(p + 16);
+    st.ino = be32(p + 20);
+    st.uid = be32(p + 24);
+    st.gid = be32(p + 28);
+    st.size = be32(p + 32);
+    return p + 36;
+}
+
+bool gitLstat(const char* path, GitStatData& out, uint32_t& mode) {
+    #if defined(__linux__) && defined(STATX_BASIC_STATS)
+        struct statx sx;
+        if (statx(AT_FDCWD, path, AT_SYMLINK_NOFOLLOW, STATX_BASIC_STATS, &sx) != 0) return false;
+        out.ctimeSec = (uint32_t)sx.stx_ctime.tv_sec;
+        out.ctimeNsec = sx.stx_ctime.tv_nsec;
+        out.mtimeSec = (uint32_t)sx.stx_mtime.tv_sec;
+        out.mtimeNsec = sx.stx_mtime.tv_nsec;
+        out.dev = (uint32_t)makedev(sx.stx_dev_major, sx.stx_dev_minor);
+        out.ino = (uint32_t)sx.stx_ino;
+        out.uid = sx.stx_uid;
+        out.gid = sx.stx_gid;
+        out.size = (uint32_t)sx.stx_size;
+        mode = sx.stx_mode;
+        return true;
+    #else
+        struct stat st;
+        #ifdef _WIN32
+            if (stat(path, &st) != 0) return false;
+        #else
+            if (lstat(path, &st) != 0) return false;
+        #endif
+        out.ctimeSec = (uint32_t)st.st_ctime;
+        out.mtimeSec = (uint32_t)st.st_mtime;
+        #if defined(__APPLE__)
+            out.ctimeNsec = st.st_ctimespec.tv_nsec;
+            out.mtimeNsec = st.st_mtimespec.tv_nsec;
+        #elif !defined(_WIN32)
+            out.ctimeNsec = st.st_ctim.tv_nsec;
+            out.mtimeNsec = st.st_mtim.tv_nsec;
+        #endif
+        out.dev = (uint32_t)st.st_dev;
+        out.ino = (uint32_t)st.st_ino;
+        out.uid = st.st_uid;
+        out.gid = st.st_gid;
+        out.size = (uint32_t)st.st_size;
+        mode = st.st_mode;
+        return true;
+    #endif
+}
+
+bool GitIndex::load(const std::string& path) {
+    MappedFile file(path);
+    if (!file.isOpen() || file.size() < 12 + 20) return false;
+
+    GitStatData indexStat;
+    uint32_t indexMode;
+    if (gitLstat(path.c_str(), indexStat, indexMode)) {
+        mtimeSec = indexStat.mtimeSec;
+        mtimeNsec = indexStat.mtimeNsec;
+    }
+
+    const uint8_t* p = (const uint8_t*)file.data();
+    const uint8_t* end = p + file.size() - 20; // trailing checksum
+    if (std::memcmp(p, "DIRC", 4) != 0) return false;
+    version = be32(p + 4);
+    if (version < 2 || version > 4) return false;
+    uint32_t count = be32(p + 8);
+    p += 12;
+
+    entries.clear();
+    entries.reserve(count);
+    std::string previous;
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint8_t* start = p;
+        if (end - p < 62) return false;
+
+        // Same fields as the untracked cache stat data, with mode after ino
+        GitIndexEntry entry;
+        readStatData(p, entry.stat);
+        entry.mode = be32(p + 24);
+        entry.stat.uid = be32(p + 28);
+        entry.stat.gid = be32(p + 32);
+        entry.stat.size = be32(p + 36);
+        p += 40;
+        entry.oid = GitOid::fromRaw(p);
+        p += 20;
+        uint16_t flags = be16(p);
+        p += 2;
+        entry.stage = (flags >> 12) & 3;
+        if (version >= 3 && (flags & 0x4000)) {
+            if (end - p < 2) return false;
+            uint16_t extended = be16(p);
+            p += 2;
+            entry.skipWorktree = extended & 0x4000;
+            entry.intentToAdd = extended & 0x2000;
+        }
+
+        if (version == 4) {
+            uint64_t strip;
+            if (!decodeVarint(p, end, strip) || strip > previous.size()) return false;
+            const uint8_t* nul = (const uint8_t*)std::memchr(p, 0, end - p);
+            if (!nul) return false;
+            entry.path.assign(previous, 0, previous.size() - strip);
+            entry.path.append((const char*)p, nul - p);
+            p = nul + 1;
+            previous = entry.path;
+        } else {
+            const uint8_t* nul = (const uint8_t*)std::memchr(p, 0, end - p);
+            if (!nul) return false;
+            entry.path.assign((const char*)p, nul - p);
+            size_t fixed = p - start;
+            p = start + ((fixed + entry.path.size() + 8) & ~(size_t)7);
+            if (p > end) return false;
+        }
+        entries.push_back(std::move(entry));
+    }
+
+    // Extensions until the checksum
+    while (end - p >= 8) {
+        uint32_t size = be32(p + 4);
+        const uint8_t* data = p + 8;
+        if ((size_t)(end - data) < size) return false;
+        if (std::memcmp(p, "TREE", 4) == 0) {
+            parseCacheTree(data, data + size);
+        } else if (std::memcmp(p, "UNTR", 4) == 0) {
+            hasUntrackedCache = parseUntracked(data, data + size);
+        } else if (std::memcmp(p, "link", 4) == 0) {
+            return false; // split index: entries live in a shared file we don't read
+        }
+        p = data + size;
+    }
+    return true;
+}
+
+// --- TREE -----------------------------------------------------------------
+
+bool GitIndex::parseCacheTree(const uint8_t* p, const uint8_t* end) {
+    struct Frame {
+        std::string prefix;
+        int remaining;
+    };
+    std::vector<Frame> stack;
+    while (p < end) {
+        const uint8_t* nul = (const uint8_t*)std::memchr(p, 0, end - p);
+        if (!nul) return false;
+        std::string name((const char*)p, nul - p);
+        p = nul + 1;
+
+        char* after;
+        long entryCount = strtol((const char*)p, &after, 10);
+        long subtrees = strtol(after, &after, 10);
+        if (*after != '\n') return false;
+        p = (const uint8_t*)after + 1;
+
+        std::string prefix = stack.empty() ? "" : stack.back().prefix + name + "/";
+        if (!stack.empty()) stack.back().remaining--;
+
+        GitCacheTreeNode node;
+        node.entryCount = (int)entryCount;
+        if (entryCount >= 0) {
+            if (end - p < 20) return false;
+            node.oid = GitOid::fromRaw(p);
+            p += 20;
+        }
+        cacheTree[prefix] = node;
+
+        stack.push_back({prefix, (int)subtrees});
+        while (!stack.empty() && stack.back().remaining == 0) stack.pop_back();
+    }
+    return true;
+}
+
+// --- UNTR -----------------------------------------------------------------
+
+// EWAH bitmap as serialized by git; returns the set bit positions
+static bool readEwah(const uint8_t*& p, const uint8_t* end, std::vector<size_t>& bits) {
+    if (end - p < 8) return false;
+    uint32_t words = be32(p + 4);
+    p += 8;
+    if ((size_t)(end - p) < (size_t)words * 8 + 4) return false;
+
+    auto word = [&](uint32_t i) {
+        const uint8_t* w = p + (size_t)i * 8;
+        return (uint64_t)be32(w) << 32 | be32(w + 4);
+    };
+    size_t bit = 0;
+    for (uint32_t i = 0; i < words;) {
+        uint64_t rlw = word(i++);
+        bool running = rlw & 1;
+        uint64_t runLength = (rlw >> 1) & 0xffffffffu;
+        uint64_t literals = rlw >> 33;
+        if (running) {
+            for (uint64_t k = 0; k < runLength * 64; ++k) bits.push_back(bit + k);
+        }
+        bit += runLength * 64;
+        for (uint64_t l = 0; l < literals && i < words; ++l) {
+            uint64_t lit = word(i++);
+            for (int k = 0; k < 64; ++k) {
+                if (lit & ((uint64_t)1 << k)) bits.push_back(bit + k);
+            }
+            bit += 64;
+        }
+    }
+    p += (size_t)words * 8 + 4; // words + position of the last RLW
+    return true;
+}
+
+bool GitIndex::parseUntracked(const uint8_t* p, const uint8_t* end) {
+    GitUntrackedCache& uc = untrackedCache;
+    uint64_t identLen;
+    if (!decodeVarint(p, end, identLen) || (uint64_t)(end - p) < identLen) return false;
+    uc.ident.assign((const char*)p, identLen);
+    p += identLen;
+
+    if (end - p < 36 * 2 + 4 + 40) return false;
+    p = readStatData(p, uc.infoExcludeStat);
+    p = readStatData(p, uc.excludesFileStat);
+    uc.dirFlags = be32(p);
+    p += 4;
+    uc.infoExcludeOid = GitOid::fromRaw(p);
+    uc.excludesFileOid = GitOid::fromRaw(p + 20);
+    p += 40;
+    const uint8_t* nul = (const uint8_t*)std::memchr(p, 0, end - p);
+    if (!nul) return false;
+    uc.excludePerDir.assign((const char*)p, nul - p);
+    p = nul + 1;
+
+    uint64_t dirCount;
+    if (!decodeVarint(p, end, dirCount)) return false;
+    if (dirCount == 0) return true;
+
+    // Directory blocks, depth first
+    struct Frame {
+        size_t index;
+        uint64_t remaining;
+    };
+    std::vector<Frame> stack;
+    uc.dirs.reserve(dirCount);
+    for (uint64_t d = 0; d < dirCount; ++d) {
+        uint64_t untrackedCount, subdirs;
+        if (!decodeVarint(p, end, untrackedCount) || !decodeVarint(p, end, subdirs)) return false;
+        nul = (const uint8_t*)std::memchr(p, 0, end - p);
+        if (!nul) return false;
+
+        GitUntrackedDir dir;
+        std::string name((const char*)p, nul - p);
+        p = nul + 1;
+        if (!stack.empty()) {
+            dir.path = uc.dirs[stack.back().index].path + name + "/";
+            uc.dirs[stack.back().index].children.push_back(uc.dirs.size());
+            stack.back().remaining--;
+        }
+        for (uint64_t u = 0; u < untrackedCount; ++u) {
+            nul = (const uint8_t*)std::memchr(p, 0, end - p);
+            if (!nul) return false;
+            dir.untracked.emplace_back((const char*)p, nul - p);
+            p = nul + 1;
+        }
+        uc.dirs.push_back(std::move(dir));
+        stack.push_back({uc.dirs.size() - 1, subdirs});
+        while (!stack.empty() && stack.back().remaining == 0) stack.pop_back();
+    }
+
+    std::vector<size_t> valid, checkOnly, hashValid;
+    if (!readEwah(p, end, valid) || !readEwah(p, end, checkOnly) || !readEwah(p, end, hashValid)) return false;
+    for (size_t bit : checkOnly) {
+        if (bit < uc.dirs.size()) uc.dirs[bit].checkOnly = true;
+    }
+    for (size_t bit : valid) {
+        if (bit >= uc.dirs.size() || end - p < 36) return false;
+        uc.dirs[bit].valid = true;
+        uc.dirs[bit].hasStat = true;
+        p = readStatData(p, uc.dirs[bit].stat);
+    }
+    for (size_t bit : hashValid) {
+        if (bit >= uc.dirs.size() || end - p < 20) return false;
+        uc.dirs[bit].hasExcludeOid = true;
+        uc.dirs[bit].excludeOid = GitOid::fromRaw(p);
+        p += 20;
+    }
+    return true;
+}
+
+// --- Lookup ---------------------------------------------------------------
+
+std::pair<size_t, size_t> GitIndex::range(std::string_view prefix) const {
+    auto first = std::lower_bound(entries.begin(), entries.end(), prefix,
+                                  [](const GitIndexEntry& e, std::string_view key) { return std::string_view(e.path) < key; });
+    auto last = std::partition_point(first, entries.end(), [&](const GitIndexEntry& e) {
+        return std::string_view(e.path).substr(0, prefix.size()) == prefix;
+    });
+    return {(size_t)(first - entries.begin()), (size_t)(last - entries.begin())};
+}
+
+const GitIndexEntry* GitIndex::find(std::string_view path) const {
+    auto it = std::lower_bound(entries.begin(), entries.end(), path,
+                               [](const GitIndexEntry& e, std::string_view key) { return std::string_view(e.path) < key; });
+    return it != entries.end() && it->path == path ? &*it : nullptr;
+}
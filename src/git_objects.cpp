@@ -0,0 +1,420 @@
+#include "git_objects.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <mutex>
+
+#ifdef MYTERM_HAVE_ZLIB
+    #include <zlib.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// --- GitOid ---------------------------------------------------------------
+
+bool GitOid::isNull() const {
+    for (uint8_t b : bytes) {
+        if (b) return false;
+    }
+    return true;
+}
+
+std::string GitOid::hex() const {
+    static const char digits[] = "0123456789abcdef";
+    std::string out(40, '0');
+    for (int i = 0; i < 20; ++i) {
+        out[2 * i] = digits[bytes[i] >> 4];
+        out[2 * i + 1] = digits[bytes[i] & 15];
+    }
+    return out;
+}
+
+bool GitOid::fromHex(std::string_view hex, GitOid& out) {
+    if (hex.size() < 40) return false;
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    for (int i = 0; i < 20; ++i) {
+        int hi = nibble(hex[2 * i]), lo = nibble(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out.bytes[i] = (uint8_t)(hi << 4 | lo);
+    }
+    return true;
+}
+
+GitOid GitOid::fromRaw(const void* raw) {
+    GitOid oid;
+    std::memcpy(oid.bytes, raw, 20);
+    return oid;
+}
+
+// --- SHA-1 ----------------------------------------------------------------
+
+static inline uint32_t rol(uint32_t v, int n) {
+    return (v << n) | (v >> (32 - n));
+}
+
+Sha1::Sha1() : state{0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0} {}
+
+void Sha1::block(const uint8_t* chunk) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = (uint32_t)chunk[4 * i] << 24 | (uint32_t)chunk[4 * i + 1] << 16 | (uint32_t)chunk[4 * i + 2] << 8 | chunk[4 * i + 3];
+    }
+    for (int i = 16; i < 80; ++i) w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+    for (int i = 0; i < 80; ++i) {
+        uint32_t f, k;
+        if (i < 20) { f = (b & c) | (~b & d); k = 0x5A827999; }
+        else if (i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1; }
+        else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+        else { f = b ^ c ^ d; k = 0xCA62C1D6; }
+        uint32_t t = rol(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rol(b, 30);
+        b = a;
+        a = t;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
+
+void Sha1::update(const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    total += len;
+    if (buffered) {
+        size_t take = std::min(len, sizeof(buffer) - buffered);
+        std::memcpy(buffer + buffered, p, take);
+        buffered += take;
+        p += take;
+        len -= take;
+        if (buffered < sizeof(buffer)) return;
+        block(buffer);
+        buffered = 0;
+    }
+    for (; len >= 64; p += 64, len -= 64) block(p);
+    std::memcpy(buffer, p, len);
+    buffered = len;
+}
+
+GitOid Sha1::finish() {
+    uint64_t bits = total * 8;
+    uint8_t pad = 0x80;
+    update(&pad, 1);
+    uint8_t zero = 0;
+    while (buffered != 56) update(&zero, 1);
+    uint8_t length[8];
+    for (int i = 0; i < 8; ++i) length[i] = (uint8_t)(bits >> (56 - 8 * i));
+    update(length, 8);
+
+    GitOid oid;
+    for (int i = 0; i < 5; ++i) {
+        oid.bytes[4 * i] = (uint8_t)(state[i] >> 24);
+        oid.bytes[4 * i + 1] = (uint8_t)(state[i] >> 16);
+        oid.bytes[4 * i + 2] = (uint8_t)(state[i] >> 8);
+        oid.bytes[4 * i + 3] = (uint8_t)state[i];
+    }
+    return oid;
+}
+
+GitOid hashBlob(const char* data, size_t len) {
+    Sha1 sha;
+    std::string header = "blob " + std::to_string(len);
+    sha.update(header.c_str(), header.size() + 1); // includes the NUL
+    sha.update(data, len);
+    return sha.finish();
+}
+
+// --- Object store ---------------------------------------------------------
+
+struct GitObjectStore::Pack {
+    MappedFile idx;
+    MappedFile data;
+    uint32_t count = 0;
+    const uint8_t* fanout = nullptr;
+    const uint8_t* oids = nullptr;
+    const uint8_t* offsets = nullptr;
+    const uint8_t* largeOffsets = nullptr;
+    GitOid checksum; // pack trailer, names the pack's contents
+};
+
+static inline uint32_t be32(const uint8_t* p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+GitObjectStore::GitObjectStore(const std::string& objectsDir) : objectsDir(objectsDir) {}
+
+GitObjectStore::~GitObjectStore() = default;
+
+bool GitObjectStore::available() {
+    #ifdef MYTERM_HAVE_ZLIB
+        return true;
+    #else
+        return false;
+    #endif
+}
+
+bool GitObjectStore::read(const GitOid& oid, GitObjectType& type, std::string& data) {
+    if (!available()) return false;
+    return readPacked(oid, type, data) || readLoose(oid, type, data);
+}
+
+#ifdef MYTERM_HAVE_ZLIB
+// Inflates exactly `expected` bytes, or everything when expected is npos
+static bool inflateData(const uint8_t* src, size_t srcLen, std::string& out, size_t expected) {
+    z_stream zs{};
+    if (inflateInit(&zs) != Z_OK) return false;
+    zs.next_in = (Bytef*)src;
+    zs.avail_in = (uInt)std::min<size_t>(srcLen, UINT32_MAX);
+
+    bool known = expected != std::string::npos;
+    out.resize(known ? expected : std::max<size_t>(srcLen * 2, 256));
+    int ret;
+    do {
+        if (zs.total_out == out.size()) {
+            if (known) break;
+            out.resize(out.size() * 2);
+        }
+        zs.next_out = (Bytef*)&out[zs.total_out];
+        zs.avail_out = (uInt)(out.size() - zs.total_out);
+        ret = inflate(&zs, Z_NO_FLUSH);
+    } while (ret == Z_OK);
+    size_t produced = zs.total_out;
+    inflateEnd(&zs);
+
+    if (known) return produced == expected;
+    out.resize(produced);
+    return ret == Z_STREAM_END;
+}
+
+// A truncated or corrupt delta fails the read instead of running past it
+static bool applyDelta(const std::string& base, const std::string& delta, std::string& out) {
+    const uint8_t* p = (const uint8_t*)delta.data();
+    const uint8_t* end = p + delta.size();
+    auto varint = [&](uint64_t& v) {
+        v = 0;
+        for (int shift = 0; p < end && shift < 64; shift += 7) {
+            uint8_t c = *p++;
+            v |= (uint64_t)(c & 0x7f) << shift;
+            if (!(c & 0x80)) return true;
+        }
+        return false;
+    };
+    uint64_t baseSize, resultSize;
+    if (!varint(baseSize) || baseSize != base.size() || !varint(resultSize)) return false;
+    out.resize(resultSize);
+
+    size_t o = 0;
+    while (p < end) {
+        uint8_t c = *p++;
+        if (c & 0x80) {
+            uint64_t off = 0, size = 0;
+            for (int i = 0; i < 4; ++i) {
+                if (!(c & (1 << i))) continue;
+                if (p >= end) return false;
+                off |= (uint64_t)*p++ << (8 * i);
+            }
+            for (int i = 0; i < 3; ++i) {
+                if (!(c & (0x10 << i))) continue;
+                if (p >= end) return false;
+                size |= (uint64_t)*p++ << (8 * i);
+            }
+            if (size == 0) size = 0x10000;
+            if (off + size > base.size() || o + size > out.size()) return false;
+            std::memcpy(&out[o], base.data() + off, size);
+            o += size;
+        } else if (c) {
+            if (o + c > out.size() || p + c > end) return false;
+            std::memcpy(&out[o], p, c);
+            p += c;
+            o += c;
+        } else {
+            return false;
+        }
+    }
+    return o == out.size();
+}
+
+// Objects that other entries are deltas against, shared by every store:
+// packs never change once written, so an entry keyed by pack checksum and
+// offset stays valid for the life of the process. Direct-mapped, and large
+// objects are left out to bound the memory.
+class DeltaBaseCache {
+public:
+    bool get(const GitOid& pack, uint64_t offset, GitObjectType& type, std::string& data) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const Entry& entry = slots[slotFor(pack, offset)];
+        if (entry.offset != offset || entry.pack != pack) return false;
+        type = entry.type;
+        data = entry.data;
+        return true;
+    }
+
+    void put(const GitOid& pack, uint64_t offset, GitObjectType type, const std::string& data) {
+        if (data.size() > MAX_OBJECT) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry& entry = slots[slotFor(pack, offset)];
+        entry.pack = pack;
+        entry.offset = offset;
+        entry.type = type;
+        entry.data = data;
+    }
+
+private:
+    static constexpr size_t SLOTS = 256;
+    static constexpr size_t MAX_OBJECT = 64 * 1024;
+
+    struct Entry {
+        GitOid pack;
+        uint64_t offset = UINT64_MAX;
+        GitObjectType type = GitObjectType::None;
+        std::string data;
+    };
+
+    static size_t slotFor(const GitOid& pack, uint64_t offset) {
+        return (GitOidHash()(pack) ^ (offset * 0x9e3779b97f4a7c15ull)) >> 32 & (SLOTS - 1);
+    }
+
+    std::mutex mutex;
+    Entry slots[SLOTS];
+};
+
+static DeltaBaseCache deltaBases;
+#endif
+
+bool GitObjectStore::readLoose(const GitOid& oid, GitObjectType& type, std::string& data) {
+    #ifdef MYTERM_HAVE_ZLIB
+        std::string hex = oid.hex();
+        MappedFile file(objectsDir + "/" + hex.substr(0, 2) + "/" + hex.substr(2));
+        if (!file.isOpen()) return false;
+
+        std::string raw;
+        if (!inflateData((const uint8_t*)file.data(), file.size(), raw, std::string::npos)) return false;
+        size_t nul = raw.find('\0');
+        if (nul == std::string::npos) return false;
+
+        std::string_view header(raw.data(), nul);
+        if (header.rfind("commit ", 0) == 0) type = GitObjectType::Commit;
+        else if (header.rfind("tree ", 0) == 0) type = GitObjectType::Tree;
+        else if (header.rfind("blob ", 0) == 0) type = GitObjectType::Blob;
+        else if (header.rfind("tag ", 0) == 0) type = GitObjectType::Tag;
+        else return false;
+        data.assign(raw, nul + 1, std::string::npos);
+        return true;
+    #else
+        (void)oid; (void)type; (void)data;
+        return false;
+    #endif
+}
+
+void GitObjectStore::loadPacks() {
+    packsLoaded = true;
+    std::error_code ec;
+    for (fs::directory_iterator it(objectsDir + "/pack", ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() != ".idx") continue;
+
+        auto pack = std::make_unique<Pack>();
+        fs::path packPath = it->path();
+        packPath.replace_extension(".pack");
+        if (!pack->idx.open(it->path().string()) || !pack->data.open(packPath.string())) continue;
+
+        const uint8_t* p = (const uint8_t*)pack->idx.data();
+        size_t size = pack->idx.size();
+        if (size < 8 + 1024 || be32(p) != 0xff744f63 || be32(p + 4) != 2) continue; // only idx v2
+        pack->fanout = p + 8;
+        pack->count = be32(pack->fanout + 255 * 4);
+        pack->oids = pack->fanout + 1024;
+        pack->offsets = pack->oids + (size_t)pack->count * 24; // oids + crc32s
+        pack->largeOffsets = pack->offsets + (size_t)pack->count * 4;
+        if ((size_t)(pack->largeOffsets - p) > size || pack->data.size() < 32) continue;
+        pack->checksum = GitOid::fromRaw(pack->data.data() + pack->data.size() - 20);
+        packs.push_back(std::move(pack));
+    }
+}
+
+bool GitObjectStore::readPacked(const GitOid& oid, GitObjectType& type, std::string& data, int depth) {
+    if (!packsLoaded) loadPacks();
+    for (auto& pack : packs) {
+        uint32_t lo = oid.bytes[0] ? be32(pack->fanout + (oid.bytes[0] - 1) * 4) : 0;
+        uint32_t hi = be32(pack->fanout + oid.bytes[0] * 4);
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            int cmp = std::memcmp(pack->oids + (size_t)mid * 20, oid.bytes, 20);
+            if (cmp == 0) {
+                uint32_t off = be32(pack->offsets + (size_t)mid * 4);
+                uint64_t offset = off;
+                if (off & 0x80000000u) {
+                    const uint8_t* large = pack->largeOffsets + (size_t)(off & 0x7fffffffu) * 8;
+                    offset = (uint64_t)be32(large) << 32 | be32(large + 4);
+                }
+                return readPackEntry(*pack, offset, type, data, depth);
+            }
+            if (cmp < 0) lo = mid + 1;
+            else hi = mid;
+        }
+    }
+    return false;
+}
+
+bool GitObjectStore::readPackEntry(Pack& pack, uint64_t offset, GitObjectType& type, std::string& data, int depth) {
+    #ifdef MYTERM_HAVE_ZLIB
+        const uint8_t* base = (const uint8_t*)pack.data.data();
+        const uint8_t* end = base + pack.data.size();
+        if (offset >= pack.data.size() || depth > 1000) return false;
+
+        const uint8_t* p = base + offset;
+        uint8_t c = *p++;
+        int kind = (c >> 4) & 7;
+        uint64_t size = c & 15;
+        for (int shift = 4; (c & 0x80) && p < end; shift += 7) {
+            c = *p++;
+            size |= (uint64_t)(c & 0x7f) << shift;
+        }
+
+        if (kind >= 1 && kind <= 4) {
+            type = (GitObjectType)kind;
+            return inflateData(p, end - p, data, size);
+        }
+
+        std::string baseData;
+        if (kind == 6) { // OFS_DELTA
+            if (p >= end) return false;
+            c = *p++;
+            uint64_t rel = c & 0x7f;
+            while (c & 0x80) {
+                if (p >= end) return false;
+                c = *p++;
+                rel = ((rel + 1) << 7) | (c & 0x7f);
+            }
+            if (rel == 0 || rel > offset) return false;
+            uint64_t baseOffset = offset - rel;
+            if (!deltaBases.get(pack.checksum, baseOffset, type, baseData)) {
+                if (!readPackEntry(pack, baseOffset, type, baseData, depth + 1)) return false;
+                deltaBases.put(pack.checksum, baseOffset, type, baseData);
+            }
+        } else if (kind == 7) { // REF_DELTA
+            if (end - p < 20) return false;
+            GitOid baseOid = GitOid::fromRaw(p);
+            p += 20;
+            // Through readPacked so that a cycle of REF_DELTAs hits the depth limit
+            if (!readPacked(baseOid, type, baseData, depth + 1) && !readLoose(baseOid, type, baseData)) return false;
+        } else {
+            return false;
+        }
+
+        std::string delta;
+        if (!inflateData(p, end - p, delta, size)) return false;
+        return applyDelta(baseData, delta, data);
+    #else
+        (void)pack; (void)offset; (void)type; (void)data; (void)depth;
+        return false;
+    #endif
+}
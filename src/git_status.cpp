@@ -0,0 +1,866 @@
+#include "git_status.h"
+#include "git_index.h"
+#include "git_objects.h"
+#include "glob.h"
+#include "thread_pool.h"
+#include "trace.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <sys/stat.h>
+#ifndef _WIN32
+    #include <unistd.h>
+#endif
+
+// --- Small file helpers ---------------------------------------------------
+
+static bool readFile(const std::string& path, std::string& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+static std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.back() == '\n' || s.back() == '\r' || s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    return s;
+}
+
+static bool isAbsolute(const std::string& path) {
+    #ifdef _WIN32
+        return path.size() > 1 && (path[1] == ':' || path[0] == '/' || path[0] == '\\');
+    #else
+        return !path.empty() && path[0] == '/';
+    #endif
+}
+
+static bool isDirectory(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+// --- Discovery ------------------------------------------------------------
+
+bool findGitRepository(const std::string& start, GitRepository& repo) {
+    std::string dir = start;
+    while (dir.size() > 1 && (dir.back() == '/' || dir.back() == '\\')) dir.pop_back();
+
+    while (true) {
+        std::string dotGit = (dir == "/" ? "" : dir) + "/.git";
+        std::string content;
+        if (isDirectory(dotGit)) {
+            repo.gitDir = dotGit;
+        } else if (readFile(dotGit, content) && content.rfind("gitdir:", 0) == 0) {
+            // Linked worktree or submodule
+            std::string target(trim(std::string_view(content).substr(7)));
+            repo.gitDir = isAbsolute(target) ? target : dir + "/" + target;
+        }
+
+        if (!repo.gitDir.empty()) {
+            repo.worktree = dir == "/" ? "" : dir;
+            repo.commonDir = repo.gitDir;
+            if (readFile(repo.gitDir + "/commondir", content)) {
+                std::string common(trim(content));
+                repo.commonDir = isAbsolute(common) ? common : repo.gitDir + "/" + common;
+            }
+            return true;
+        }
+
+        size_t slash = dir.find_last_of("/\\");
+        if (slash == std::string::npos || dir == "/") return false;
+        dir = slash == 0 ? "/" : dir.substr(0, slash);
+    }
+}
+
+// --- Refs -----------------------------------------------------------------
+
+static bool lookupPackedRef(const GitRepository& repo, std::string_view name, GitOid& oid) {
+    MappedFile file(repo.commonDir + "/packed-refs");
+    if (!file.isOpen()) return false;
+    std::string_view text(file.data(), file.size());
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == std::string_view::npos) eol = text.size();
+        std::string_view line = trim(text.substr(pos, eol - pos));
+        pos = eol + 1;
+        // "<hex> <refname>"; '#' is the header and '^' a peeled tag
+        if (line.size() > 41 && line[40] == ' ' && line.substr(41) == name) return GitOid::fromHex(line.substr(0, 40), oid);
+    }
+    return false;
+}
+
+static bool resolveRef(const GitRepository& repo, const std::string& name, GitOid& oid, int depth = 0) {
+    if (depth > 5) return false;
+    std::string content;
+    // HEAD and other pseudo-refs are per worktree, refs/ are shared
+    const std::string& base = name.rfind("refs/", 0) == 0 ? repo.commonDir : repo.gitDir;
+    if (readFile(base + "/" + name, content)) {
+        std::string_view value = trim(content);
+        if (value.rfind("ref: ", 0) == 0) return resolveRef(repo, std::string(trim(value.substr(5))), oid, depth + 1);
+        return GitOid::fromHex(value, oid);
+    }
+    return lookupPackedRef(repo, name, oid);
+}
+
+// Value of a config entry after quotes, escapes and a trailing '#' or ';'
+// comment are dealt with
+static std::string configValue(std::string_view raw) {
+    std::string out;
+    size_t keep = 0; // unquoted trailing blanks are dropped
+    bool quoted = false;
+    for (size_t i = 0; i < raw.size(); ++i) {
+        char c = raw[i];
+        if (c == '"') {
+            quoted = !quoted;
+        } else if (c == '\\' && i + 1 < raw.size()) {
+            char next = raw[++i];
+            out += next == 'n' ? '\n' : next == 't' ? '\t' : next;
+            keep = out.size();
+        } else if (!quoted && (c == '#' || c == ';')) {
+            break;
+        } else if (out.empty() && !quoted && (c == ' ' || c == '\t')) {
+            continue;
+        } else {
+            out += c;
+            if (quoted || (c != ' ' && c != '\t')) keep = out.size();
+        }
+    }
+    out.resize(keep);
+    return out;
+}
+
+// Reads `key` of `section` from a git config file into `value`, the last
+// occurrence winning as in git. `section` is lowercase, with the subsection
+// as written: "core" or "branch \"main\"". Keys are case-insensitive.
+static bool readConfigValue(const std::string& path, const std::string& section, const std::string& key, std::string& value) {
+    std::string config;
+    if (!readFile(path, config)) return false;
+
+    bool found = false;
+    bool inSection = false;
+    size_t pos = 0;
+    while (pos < config.size()) {
+        size_t eol = config.find('\n', pos);
+        if (eol == std::string::npos) eol = config.size();
+        std::string_view line = trim(std::string_view(config).substr(pos, eol - pos));
+        pos = eol + 1;
+        if (!line.empty() && line[0] == '[') {
+            size_t close = line.find(']');
+            if (close == std::string_view::npos) continue;
+            std::string_view header = line.substr(1, close - 1);
+            size_t quote = header.find('"');
+            std::string name = toLower(std::string(trim(header.substr(0, quote))));
+            if (quote != std::string_view::npos) name += " \"" + configValue(header.substr(quote)) + "\"";
+            inSection = name == section;
+            // "[core] excludesFile = x" is allowed on one line
+            line = trim(line.substr(close + 1));
+        }
+        if (line.empty() || line[0] == '#' || line[0] == ';' || !inSection) continue;
+        size_t eq = line.find('=');
+        if (toLower(std::string(trim(line.substr(0, eq)))) != key) continue;
+        value = eq == std::string_view::npos ? "true" : configValue(line.substr(eq + 1));
+        found = true;
+    }
+    return found;
+}
+
+// Upstream ref of `branch` from [branch "<name>"] remote/merge in the config
+static bool findUpstream(const GitRepository& repo, const std::string& branch, std::string& upstreamRef) {
+    std::string path = repo.commonDir + "/config";
+    std::string section = "branch \"" + branch + "\"";
+    std::string remote, merge;
+    readConfigValue(path, section, "remote", remote);
+    readConfigValue(path, section, "merge", merge);
+    if (remote.empty() || merge.empty()) return false;
+
+    if (remote == ".") {
+        upstreamRef = merge;
+    } else {
+        std::string_view shortName = merge;
+        if (shortName.rfind("refs/heads/", 0) == 0) shortName.remove_prefix(11);
+        upstreamRef = "refs/remotes/" + remote + "/" + std::string(shortName);
+    }
+    return true;
+}
+
+bool readGitHead(const GitRepository& repo, GitStatus& out) {
+    std::string head;
+    if (!readFile(repo.gitDir + "/HEAD", head)) return false;
+    std::string_view value = trim(head);
+    if (value.rfind("ref: ", 0) == 0) {
+        value = trim(value.substr(5));
+        if (value.rfind("refs/heads/", 0) == 0) value.remove_prefix(11);
+        out.branch = std::string(value);
+    } else if (value.size() >= 7) {
+        out.branch = std::string(value.substr(0, 7)); // detached
+    } else {
+        return false;
+    }
+
+    struct stat st;
+    if (stat((repo.gitDir + "/rebase-merge").c_str(), &st) == 0 || stat((repo.gitDir + "/rebase-apply").c_str(), &st) == 0) {
+        out.state = "REBASE";
+    } else if (stat((repo.gitDir + "/MERGE_HEAD").c_str(), &st) == 0) {
+        out.state = "MERGE";
+    }
+    return true;
+}
+
+// --- Ahead / behind -------------------------------------------------------
+
+namespace {
+
+struct CommitInfo {
+    int64_t time = 0;
+    std::vector<GitOid> parents;
+};
+
+bool parseCommit(const std::string& data, CommitInfo& commit, GitOid* tree) {
+    size_t pos = 0;
+    while (pos < data.size() && data[pos] != '\n') {
+        size_t eol = data.find('\n', pos);
+        if (eol == std::string::npos) eol = data.size();
+        std::string_view line(data.data() + pos, eol - pos);
+        pos = eol + 1;
+        if (line.rfind("tree ", 0) == 0) {
+            if (tree) GitOid::fromHex(line.substr(5), *tree);
+        } else if (line.rfind("parent ", 0) == 0) {
+            GitOid parent;
+            if (GitOid::fromHex(line.substr(7), parent)) commit.parents.push_back(parent);
+        } else if (line.rfind("committer ", 0) == 0) {
+            size_t gt = line.rfind('>');
+            if (gt != std::string_view::npos) commit.time = std::strtoll(line.data() + gt + 1, nullptr, 10);
+        }
+    }
+    return true;
+}
+
+// Counts commits reachable from only one side, walking newest first (git's
+// paint-down-to-common). A commit whose flags grow is queued again to
+// repaint its parents. `pending` is the exact number of queue entries whose
+// commit is not yet reachable from both sides. With skewed dates, a common
+// commit still queued can have an older-looking parent that was counted on
+// one side, so once `pending` is zero the walk goes on through common
+// commits until the newest left is older than every one-sided commit by
+// more than SLOP plus the worst parent-newer-than-child skew seen. False if
+// LIMIT cut the walk short and the counts are only approximate.
+bool countAheadBehind(GitObjectStore& store, const GitOid& local, const GitOid& upstream, int& ahead, int& behind) {
+    enum : uint8_t { LEFT = 1, RIGHT = 2, BOTH = 3 };
+    const size_t LIMIT = 10000;
+    const int64_t SLOP = 300; // seconds
+
+    struct Node {
+        uint8_t flags = 0;
+        uint32_t queued = 0; // entries in the queue
+    };
+    std::unordered_map<GitOid, CommitInfo, GitOidHash> commits;
+    std::unordered_map<GitOid, Node, GitOidHash> nodes;
+    auto load = [&](const GitOid& oid) -> const CommitInfo* {
+        auto it = commits.find(oid);
+        if (it != commits.end()) return &it->second;
+        GitObjectType type;
+        std::string data;
+        CommitInfo info;
+        if (!store.read(oid, type, data) || type != GitObjectType::Commit) return nullptr;
+        parseCommit(data, info, nullptr);
+        return &commits.emplace(oid, std::move(info)).first->second;
+    };
+
+    using Item = std::pair<int64_t, GitOid>;
+    auto older = [](const Item& a, const Item& b) { return a.first < b.first; };
+    std::priority_queue<Item, std::vector<Item>, decltype(older)> queue(older);
+    size_t pending = 0;
+
+    int64_t skew = 0;
+    int64_t oldestSide = INT64_MAX; // date of the oldest commit walked on one side only
+
+    auto paint = [&](const GitOid& oid, uint8_t side, int64_t childTime) {
+        Node& node = nodes[oid];
+        if ((node.flags | side) == node.flags) return;
+        node.flags |= side;
+        // Entries already queued for this commit stop counting once it is BOTH
+        if (node.flags == BOTH) pending -= node.queued;
+        const CommitInfo* info = load(oid);
+        if (!info) return;
+        skew = std::max(skew, info->time - childTime);
+        queue.push({info->time, oid});
+        node.queued++;
+        if (node.flags != BOTH) pending++;
+    };
+
+    paint(local, LEFT, INT64_MAX);
+    paint(upstream, RIGHT, INT64_MAX);
+    size_t walked = 0;
+    while (!queue.empty()) {
+        if (pending == 0 && queue.top().first < oldestSide - SLOP - skew) break;
+        if (walked == LIMIT) break;
+        GitOid oid = queue.top().second;
+        queue.pop();
+        walked++;
+        Node& node = nodes[oid];
+        node.queued--;
+        uint8_t f = node.flags;
+        const CommitInfo* info = load(oid);
+        if (f != BOTH) {
+            pending--;
+            if (info) oldestSide = std::min(oldestSide, info->time);
+        }
+        if (!info) continue;
+        for (const GitOid& parent : info->parents) paint(parent, f, info->time);
+    }
+
+    ahead = behind = 0;
+    for (const auto& [oid, node] : nodes) {
+        if (node.flags == LEFT) ahead++;
+        else if (node.flags == RIGHT) behind++;
+    }
+    return queue.empty() || walked < LIMIT;
+}
+
+// --- Staged: HEAD tree vs index -------------------------------------------
+
+class StagedCounter {
+public:
+    StagedCounter(GitObjectStore& store, const GitIndex& index, std::atomic<size_t>& changes, size_t limit)
+        : store(store), index(index), changes(changes), limit(limit) {}
+
+    // Compares the tree `oid` at `prefix` ("" or "dir/") with index entries [first, last)
+    void compare(const GitOid& oid, const std::string& prefix, size_t first, size_t last) {
+        if (changes >= limit) return;
+        // A valid cache-tree entry with the same id means nothing below is staged
+        auto cached = index.cacheTree.find(prefix);
+        if (cached != index.cacheTree.end() && cached->second.entryCount >= 0 && cached->second.oid == oid) return;
+
+        GitObjectType type;
+        std::string tree;
+        if (!store.read(oid, type, tree) || type != GitObjectType::Tree) {
+            added(first, last);
+            return;
+        }
+
+        size_t cursor = first;
+        const char* p = tree.data();
+        const char* end = p + tree.size();
+        while (p < end && changes < limit) {
+            // "<octal mode> <name>\0<20 byte id>"
+            const char* space = (const char*)std::memchr(p, ' ', end - p);
+            if (!space) break;
+            const char* nul = (const char*)std::memchr(space, 0, end - space);
+            if (!nul || end - nul < 21) break;
+            uint32_t mode = (uint32_t)std::strtoul(p, nullptr, 8);
+            std::string path = prefix + std::string(space + 1, nul - space - 1);
+            GitOid entryOid = GitOid::fromRaw(nul + 1);
+            p = nul + 21;
+
+            bool isTree = (mode & 0170000) == 0040000;
+            if (isTree) path += '/';
+            while (cursor < last && index.entries[cursor].path < path &&
+                   !(isTree && index.entries[cursor].path.compare(0, path.size(), path) == 0)) {
+                added(cursor, cursor + 1);
+                cursor++;
+            }
+
+            if (isTree) {
+                size_t sub = cursor;
+                while (sub < last && index.entries[sub].path.compare(0, path.size(), path) == 0) sub++;
+                if (sub == cursor) changes++; // directory removed from the index
+                else compare(entryOid, path, cursor, sub);
+                cursor = sub;
+            } else if (cursor < last && index.entries[cursor].path == path) {
+                const GitIndexEntry& entry = index.entries[cursor];
+                if (entry.stage != 0 || entry.intentToAdd || entry.oid != entryOid || entry.mode != mode) changes++;
+                while (cursor < last && index.entries[cursor].path == path) cursor++; // conflict stages
+            } else {
+                changes++; // deleted in the index
+            }
+        }
+        if (cursor < last) added(cursor, last);
+    }
+
+    // Paths only in the index, one per path (unmerged entries have several stages)
+    void added(size_t first, size_t last) {
+        for (size_t i = first; i < last && changes < limit; ++i) {
+            if (index.entries[i].intentToAdd) continue;
+            if (i > first && index.entries[i].path == index.entries[i - 1].path) continue;
+            changes++;
+        }
+    }
+
+private:
+    GitObjectStore& store;
+    const GitIndex& index;
+    std::atomic<size_t>& changes;
+    size_t limit;
+};
+
+// --- Modified: index vs working tree --------------------------------------
+
+bool sameStat(const GitStatData& a, const GitStatData& b) {
+    // dev is left out, as git does by default
+    return a.mtimeSec == b.mtimeSec && a.mtimeNsec == b.mtimeNsec && a.ctimeSec == b.ctimeSec &&
+           a.ctimeNsec == b.ctimeNsec && a.ino == b.ino && a.uid == b.uid && a.gid == b.gid && a.size == b.size;
+}
+
+bool contentDiffers(const std::string& path, const GitIndexEntry& entry, bool symlink) {
+    #ifndef _WIN32
+        if (symlink) {
+            char target[4096];
+            ssize_t len = readlink(path.c_str(), target, sizeof(target));
+            return len < 0 || hashBlob(target, (size_t)len) != entry.oid;
+        }
+    #else
+        (void)symlink;
+    #endif
+    MappedFile file(path);
+    if (!file.isOpen()) return true;
+    return hashBlob(file.data(), file.size()) != entry.oid;
+}
+
+bool entryModified(const std::string& root, const GitIndexEntry& entry, const GitIndex& index, std::string& path) {
+    path.assign(root);
+    path.append(entry.path);
+
+    GitStatData st;
+    uint32_t mode;
+    if (!gitLstat(path.c_str(), st, mode)) return true; // deleted
+
+    const uint32_t type = entry.mode & 0170000;
+    #ifndef _WIN32
+        if (type == 0120000) {
+            if (!S_ISLNK(mode)) return true;
+        } else if (!S_ISREG(mode) || (entry.mode & 0100) != (mode & 0100)) {
+            return true;
+        }
+    #endif
+    if (st.size != entry.stat.size) return true;
+
+    // Written in the same second as the index: the stat data can't be trusted
+    bool racy = entry.stat.mtimeSec > index.mtimeSec ||
+                (entry.stat.mtimeSec == index.mtimeSec && entry.stat.mtimeNsec >= index.mtimeNsec);
+    if (sameStat(st, entry.stat) && !racy) return false;
+    return contentDiffers(path, entry, type == 0120000);
+}
+
+void countModified(const GitRepository& repo, const GitIndex& index, std::atomic<size_t>& changes, size_t limit) {
+    TRACE_SCOPE("countModified");
+    const std::string root = repo.worktree + "/";
+    auto check = [&](size_t first, size_t last) {
+        std::string path;
+        for (size_t i = first; i < last && changes < limit; ++i) {
+            const GitIndexEntry& entry = index.entries[i];
+            if (entry.stage != 0 || entry.skipWorktree) continue;
+            uint32_t type = entry.mode & 0170000;
+            if (type == 0160000 || type == 0040000) continue; // submodules, sparse directories
+            if (entry.intentToAdd || entryModified(root, entry, index, path)) changes++;
+        }
+    };
+
+    const size_t CHUNK = 2048;
+    const size_t n = index.entries.size();
+    if (n <= CHUNK) {
+        check(0, n);
+        return;
+    }
+    ThreadPool& pool = ThreadPool::shared();
+    for (size_t first = 0; first < n; first += CHUNK) {
+        pool.submit([&check, first, n] { check(first, std::min(first + CHUNK, n)); });
+    }
+    pool.wait();
+}
+
+// --- Untracked ------------------------------------------------------------
+
+struct IgnoreRule {
+    std::vector<GlobSegment> parts; // path components, "**" as an empty-pattern marker
+    std::vector<bool> recursive;
+    std::string base;               // directory of the .gitignore ("" or "dir/")
+    bool negate = false;
+    bool dirOnly = false;
+    bool basename = false;          // no '/' in the pattern: matches at any depth
+};
+
+struct IgnoreList {
+    std::vector<IgnoreRule> rules;
+};
+
+void parseIgnore(std::string_view text, const std::string& base, IgnoreList& list) {
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == std::string_view::npos) eol = text.size();
+        std::string_view line = text.substr(pos, eol - pos);
+        pos = eol + 1;
+
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        while (!line.empty() && line.back() == ' ' && !(line.size() > 1 && line[line.size() - 2] == '\\')) line.remove_suffix(1);
+        if (line.empty() || line[0] == '#') continue;
+
+        IgnoreRule rule;
+        rule.base = base;
+        if (line[0] == '!') {
+            rule.negate = true;
+            line.remove_prefix(1);
+        } else if (line[0] == '\\' && line.size() > 1 && (line[1] == '!' || line[1] == '#')) {
+            line.remove_prefix(1);
+        }
+        if (!line.empty() && line.back() == '/') {
+            rule.dirOnly = true;
+            line.remove_suffix(1);
+        }
+        if (line.empty()) continue;
+        rule.basename = line.find('/') == std::string_view::npos;
+        if (line[0] == '/') line.remove_prefix(1);
+
+        size_t start = 0;
+        while (start <= line.size()) {
+            size_t slash = line.find('/', start);
+            if (slash == std::string_view::npos) slash = line.size();
+            std::string_view piece = line.substr(start, slash - start);
+            start = slash + 1;
+            if (piece.empty()) continue;
+            rule.recursive.push_back(piece == "**");
+            rule.parts.emplace_back(piece == "**" ? std::string_view() : piece, true);
+        }
+        if (!rule.parts.empty()) list.rules.push_back(std::move(rule));
+    }
+}
+
+bool matchParts(const IgnoreRule& rule, size_t p, const std::vector<std::string_view>& path, size_t c) {
+    while (p < rule.parts.size()) {
+        if (rule.recursive[p]) {
+            if (p + 1 == rule.parts.size()) return c < path.size(); // "dir/**" needs something below
+            for (size_t k = c; k <= path.size(); ++k) {
+                if (matchParts(rule, p + 1, path, k)) return true;
+            }
+            return false;
+        }
+        if (c >= path.size() || !rule.parts[p].matches(path[c])) return false;
+        p++;
+        c++;
+    }
+    return c == path.size();
+}
+
+bool ruleMatches(const IgnoreRule& rule, std::string_view relPath, std::string_view name, bool isDir) {
+    if (rule.dirOnly && !isDir) return false;
+    if (rule.basename) return rule.parts[0].matches(name);
+    if (relPath.compare(0, rule.base.size(), rule.base) != 0) return false;
+
+    std::vector<std::string_view> components;
+    std::string_view rest = relPath.substr(rule.base.size());
+    size_t start = 0;
+    while (start <= rest.size()) {
+        size_t slash = rest.find('/', start);
+        if (slash == std::string_view::npos) slash = rest.size();
+        components.push_back(rest.substr(start, slash - start));
+        start = slash + 1;
+    }
+    return matchParts(rule, 0, components, 0);
+}
+
+// core.excludesFile, or git's default for it. Config files are read in
+// git's order, the last one that sets it winning: the XDG one,
+// ~/.gitconfig, then the repository's.
+std::string excludesFilePath(const GitRepository& repo) {
+    const char* home = getenv("HOME");
+    const char* xdg = getenv("XDG_CONFIG_HOME");
+    std::string xdgGit = xdg && *xdg ? std::string(xdg) + "/git" : home ? std::string(home) + "/.config/git" : "";
+
+    std::string value;
+    if (!xdgGit.empty()) readConfigValue(xdgGit + "/config", "core", "excludesfile", value);
+    if (home) readConfigValue(std::string(home) + "/.gitconfig", "core", "excludesfile", value);
+    readConfigValue(repo.commonDir + "/config", "core", "excludesfile", value);
+    if (value.empty()) return xdgGit.empty() ? "" : xdgGit + "/ignore";
+    if (value.rfind("~/", 0) == 0 && home) value = home + value.substr(1);
+    return value;
+}
+
+class UntrackedScanner {
+public:
+    UntrackedScanner(const GitRepository& repo, const GitIndex& index, std::atomic<size_t>& changes, size_t limit)
+        : repo(repo), index(index), changes(changes), limit(limit) {}
+
+    void run() {
+        TRACE_SCOPE("countUntracked");
+        // Lowest precedence first: core.excludesFile, then info/exclude
+        std::string globalPath = excludesFilePath(repo);
+        std::string text;
+        lists.emplace_back();
+        if (!globalPath.empty() && readFile(globalPath, text)) parseIgnore(text, "", lists.back());
+        lists.emplace_back();
+        if (readFile(repo.commonDir + "/info/exclude", text)) parseIgnore(text, "", lists.back());
+
+        const GitUntrackedDir* rootCache = nullptr;
+        if (cacheUsable(globalPath)) rootCache = &index.untrackedCache.dirs[0];
+        scan("", rootCache);
+    }
+
+private:
+    static GitStatData statOrZero(const std::string& path) {
+        GitStatData st;
+        uint32_t mode;
+        if (!gitLstat(path.c_str(), st, mode)) st = GitStatData();
+        return st;
+    }
+
+    // The UNTR extension is only trusted when it was written for this
+    // worktree, in "show directories, hide empty ones" mode, and the global
+    // exclude files haven't changed since
+    bool cacheUsable(const std::string& globalPath) {
+        const GitUntrackedCache& uc = index.untrackedCache;
+        if (!index.hasUntrackedCache || uc.dirs.empty() || uc.excludePerDir != ".gitignore") return false;
+        if (uc.ident.rfind("Location " + repo.worktree + ",", 0) != 0) return false;
+        if ((uc.dirFlags & 6) != 6) return false;
+        if (!sameStat(statOrZero(repo.commonDir + "/info/exclude"), uc.infoExcludeStat)) return false;
+        return globalPath.empty() || sameStat(statOrZero(globalPath), uc.excludesFileStat);
+    }
+
+    bool ignored(const std::string& relPath, const char* name, bool isDir) const {
+        for (size_t l = lists.size(); l-- > 0;) {
+            const auto& rules = lists[l].rules;
+            for (size_t r = rules.size(); r-- > 0;) {
+                if (ruleMatches(rules[r], relPath, name, isDir)) return !rules[r].negate;
+            }
+        }
+        return false;
+    }
+
+    // Loads rel/.gitignore onto the rule stack; returns false if the cached
+    // directory recorded a different (or no) .gitignore
+    bool pushIgnoreFile(const std::string& rel, const GitUntrackedDir* cached) {
+        lists.emplace_back();
+        MappedFile file(repo.worktree + "/" + rel + ".gitignore");
+        if (!file.isOpen()) return !cached || !cached->hasExcludeOid;
+        parseIgnore(std::string_view(file.data(), file.size()), rel, lists.back());
+        return cached && cached->hasExcludeOid && hashBlob(file.data(), file.size()) == cached->excludeOid;
+    }
+
+    const GitUntrackedDir* cachedChild(const GitUntrackedDir* cached, const std::string& rel) const {
+        if (!cached) return nullptr;
+        for (size_t child : cached->children) {
+            if (index.untrackedCache.dirs[child].path == rel) return &index.untrackedCache.dirs[child];
+        }
+        return nullptr;
+    }
+
+    // rel is "" or "dir/"; cached is this directory's UNTR block, if still trusted
+    void scan(const std::string& rel, const GitUntrackedDir* cached) {
+        if (changes >= limit) return;
+        if (!pushIgnoreFile(rel, cached)) cached = nullptr;
+
+        if (cached && cached->valid && cached->hasStat && sameStat(statOrZero(repo.worktree + "/" + rel), cached->stat)) {
+            // Listing unchanged: take the recorded untracked names and only
+            // descend into tracked subdirectories
+            changes += cached->untracked.size();
+            for (size_t child : cached->children) {
+                const GitUntrackedDir& dir = index.untrackedCache.dirs[child];
+                auto [first, last] = index.range(dir.path);
+                if (first != last) scan(dir.path, &dir);
+            }
+        } else {
+            // Direct children known to the index, so each directory entry
+            // costs one hash lookup instead of a binary search over all paths
+            std::unordered_map<std::string_view, bool> known; // name -> is a tracked directory
+            auto [first, last] = index.range(rel);
+            for (size_t i = first; i < last; ++i) {
+                std::string_view child = std::string_view(index.entries[i].path).substr(rel.size());
+                size_t slash = child.find('/');
+                bool isDir = slash != std::string_view::npos;
+                known.emplace(child.substr(0, slash), isDir);
+                if (isDir) {
+                    // Skip the rest of this subdirectory in one jump
+                    std::string_view dirPrefix(index.entries[i].path.data(), rel.size() + slash + 1);
+                    i = index.range(dirPrefix).second - 1;
+                }
+            }
+
+            std::vector<std::pair<std::string, bool>> subdirs;
+            forEachDirectoryEntry(repo.worktree + "/" + rel, [&](const char* name, bool isDir, bool isLink) {
+                if (changes >= limit || std::strcmp(name, ".git") == 0) return;
+                isDir = isDir && !isLink;
+                auto it = known.find(name);
+                if (it != known.end()) {
+                    // A tracked file, submodule or directory
+                    if (it->second && isDir) subdirs.push_back({rel + name + "/", true});
+                    return;
+                }
+                std::string relPath = rel + name;
+                if (ignored(relPath, name, isDir)) return;
+                if (!isDir) changes++;
+                else subdirs.push_back({relPath + "/", false});
+            });
+            for (const auto& [sub, isTracked] : subdirs) {
+                if (isTracked) scan(sub, cachedChild(cached, sub));
+                else if (hasVisibleFile(sub)) changes++; // shown as a single "dir/"
+            }
+        }
+        lists.pop_back();
+    }
+
+    // True if the untracked directory holds any file that isn't ignored
+    bool hasVisibleFile(const std::string& rel) {
+        lists.emplace_back();
+        std::string text;
+        if (readFile(repo.worktree + "/" + rel + ".gitignore", text)) parseIgnore(text, rel, lists.back());
+
+        bool found = false;
+        std::vector<std::string> subdirs;
+        forEachDirectoryEntry(repo.worktree + "/" + rel, [&](const char* name, bool isDir, bool isLink) {
+            if (found) return;
+            if (std::strcmp(name, ".git") == 0) {
+                found = true; // nested repository
+                return;
+            }
+            isDir = isDir && !isLink;
+            std::string relPath = rel + name;
+            if (ignored(relPath, name, isDir)) return;
+            if (isDir) subdirs.push_back(relPath + "/");
+            else found = true;
+        });
+        for (size_t i = 0; i < subdirs.size() && !found; ++i) found = hasVisibleFile(subdirs[i]);
+        lists.pop_back();
+        return found;
+    }
+
+    const GitRepository& repo;
+    const GitIndex& index;
+    std::atomic<size_t>& changes;
+    size_t limit;
+    std::vector<IgnoreList> lists; // rule stack, most specific last
+};
+
+} // namespace
+
+// --- Directory filter -----------------------------------------------------
+
+struct GitDirectoryFilter::Rules {
+    GitRepository repo;
+    std::vector<IgnoreList> base;                      // core.excludesFile, info/exclude
+    std::unordered_map<std::string, IgnoreList> files; // "dir/" -> its .gitignore
+    std::unordered_map<std::string, bool> ignored;     // "dir/" -> ignored itself or through a parent
+    std::unordered_set<std::string> tracked;           // "dir/" with a tracked file somewhere below
+
+    const IgnoreList& fileRules(const std::string& rel) {
+        auto it = files.find(rel);
+        if (it != files.end()) return it->second;
+        IgnoreList& list = files[rel];
+        MappedFile file(repo.worktree + "/" + rel + ".gitignore");
+        if (file.isOpen()) parseIgnore(std::string_view(file.data(), file.size()), rel, list);
+        return list;
+    }
+
+    bool isIgnored(const std::string& rel) {
+        auto it = ignored.find(rel);
+        if (it != ignored.end()) return it->second;
+        size_t slash = rel.rfind('/', rel.size() - 2);
+        std::string parent = slash == std::string::npos ? "" : rel.substr(0, slash + 1);
+        bool result = !parent.empty() && isIgnored(parent);
+        if (!result) {
+            // Nearest .gitignore first, then the repository-wide lists
+            std::string_view path(rel.data(), rel.size() - 1);
+            std::string_view name = path.substr(parent.size());
+            int decided = -1;
+            auto check = [&](const IgnoreList& list) {
+                for (size_t r = list.rules.size(); r-- > 0 && decided < 0;) {
+                    if (ruleMatches(list.rules[r], path, name, true)) decided = !list.rules[r].negate;
+                }
+            };
+            for (std::string dir = parent; decided < 0;) {
+                check(fileRules(dir));
+                if (dir.empty()) break;
+                size_t up = dir.rfind('/', dir.size() - 2);
+                dir.resize(up == std::string::npos ? 0 : up + 1);
+            }
+            for (size_t l = base.size(); l-- > 0 && decided < 0;) check(base[l]);
+            result = decided > 0;
+        }
+        ignored.emplace(rel, result);
+        return result;
+    }
+};
+
+GitDirectoryFilter::GitDirectoryFilter(const GitRepository& repo) : rules(std::make_unique<Rules>()) {
+    rules->repo = repo;
+    std::string text;
+    std::string globalPath = excludesFilePath(repo);
+    rules->base.emplace_back();
+    if (!globalPath.empty() && readFile(globalPath, text)) parseIgnore(text, "", rules->base.back());
+    rules->base.emplace_back();
+    if (readFile(repo.commonDir + "/info/exclude", text)) parseIgnore(text, "", rules->base.back());
+
+    GitIndex index;
+    if (!index.load(repo.gitDir + "/index")) return;
+    for (const GitIndexEntry& entry : index.entries) {
+        const std::string& path = entry.path;
+        for (size_t slash = path.find('/'); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+            rules->tracked.emplace(path, 0, slash + 1);
+        }
+    }
+}
+
+GitDirectoryFilter::~GitDirectoryFilter() = default;
+
+bool GitDirectoryFilter::wanted(const std::string& rel) {
+    return rules->tracked.count(rel) || !rules->isIgnored(rel);
+}
+
+bool readGitStatus(const GitRepository& repo, GitStatus& out, size_t maxChanges) {
+    TRACE_SCOPE("readGitStatus");
+    if (!readGitHead(repo, out)) return false;
+
+    GitOid head;
+    bool hasHead = resolveRef(repo, "HEAD", head);
+    GitObjectStore store(repo.commonDir + "/objects");
+
+    // Ahead/behind: only for a branch with a configured, resolvable upstream
+    std::string upstreamRef;
+    GitOid upstream;
+    if (hasHead && GitObjectStore::available() && findUpstream(repo, out.branch, upstreamRef) &&
+        resolveRef(repo, upstreamRef, upstream)) {
+        out.hasUpstream = true;
+        if (upstream != head) out.aheadBehindApprox = !countAheadBehind(store, head, upstream, out.ahead, out.behind);
+    }
+
+    // A fresh repository has no index yet: everything is untracked
+    GitIndex index;
+    struct stat st;
+    std::string indexPath = repo.gitDir + "/index";
+    if (stat(indexPath.c_str(), &st) == 0 && !index.load(indexPath)) return true; // format we don't read
+    out.hasCounts = true;
+
+    std::atomic<size_t> changes{0};
+    if (GitObjectStore::available()) {
+        TRACE_SCOPE("countStaged");
+        StagedCounter counter(store, index, changes, maxChanges);
+        GitObjectType type;
+        std::string commit;
+        GitOid tree;
+        CommitInfo info;
+        if (!hasHead) {
+            counter.added(0, index.entries.size()); // unborn branch: everything is new
+        } else if (store.read(head, type, commit) && type == GitObjectType::Commit && parseCommit(commit, info, &tree)) {
+            counter.compare(tree, "", 0, index.entries.size());
+        }
+    }
+    out.staged = changes;
+
+    countModified(repo, index, changes, maxChanges);
+    out.modified = changes - out.staged;
+
+    UntrackedScanner(repo, index, changes, maxChanges).run();
+    out.untracked = changes - out.staged - out.modified;
+
+    out.truncated = changes >= maxChanges;
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,263 @@
+#include "glob.h"
+#include "thread_pool.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+#ifdef _WIN32
+    #include <filesystem>
+    namespace fs = std::filesystem;
+#else
+    #include <sys/stat.h>
+#endif
+
+bool hasGlobMeta(std::string_view word) {
+    for (size_t i = 0; i < word.size(); ++i) {
+        if (word[i] == '\\') i++;
+        else if (word[i] == '*' || word[i] == '?' || word[i] == '[') return true;
+    }
+    return false;
+}
+
+std::string unescapeGlob(std::string_view word) {
+    std::string out;
+    out.reserve(word.size());
+    for (size_t i = 0; i < word.size(); ++i) {
+        if (word[i] == '\\' && i + 1 < word.size()) i++;
+        out += word[i];
+    }
+    return out;
+}
+
+// --- Directory listing ----------------------------------------------------
+
+static bool pathExists(const std::string& path, bool& isDir) {
+    #ifdef _WIN32
+        std::error_code ec;
+        auto status = fs::status(path, ec);
+        isDir = fs::is_directory(status);
+        return fs::exists(status) || fs::is_symlink(fs::symlink_status(path, ec));
+    #else
+        struct stat st;
+        if (stat(path.c_str(), &st) == 0) {
+            isDir = S_ISDIR(st.st_mode);
+            return true;
+        }
+        isDir = false;
+        return lstat(path.c_str(), &st) == 0; // dangling symlink
+    #endif
+}
+
+// --- GlobSegment ----------------------------------------------------------
+
+GlobSegment::GlobSegment(std::string_view pattern, bool dotfiles) {
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        char c = pattern[i];
+        if (c == '\\' && i + 1 < pattern.size()) {
+            ops.push_back({OpType::Char, pattern[++i], -1});
+        } else if (c == '*') {
+            if (ops.empty() || ops.back().type != OpType::Star) ops.push_back({OpType::Star, 0, -1});
+        } else if (c == '?') {
+            ops.push_back({OpType::Any, 0, -1});
+        } else if (c == '[') {
+            size_t j = i + 1;
+            bool negated = j < pattern.size() && (pattern[j] == '!' || pattern[j] == '^');
+            if (negated) j++;
+            std::bitset<256> set;
+            bool first = true;
+            while (j < pattern.size() && (pattern[j] != ']' || first)) {
+                unsigned char lo = pattern[j];
+                if (lo == '\\' && j + 1 < pattern.size()) lo = pattern[++j];
+                unsigned char hi = lo;
+                if (j + 2 < pattern.size() && pattern[j + 1] == '-' && pattern[j + 2] != ']') {
+                    hi = pattern[j + 2];
+                    j += 2;
+                }
+                for (unsigned v = lo; v <= hi; ++v) set.set(v);
+                first = false;
+                j++;
+            }
+            if (j >= pattern.size()) {
+                ops.push_back({OpType::Char, '[', -1}); // unterminated: literal '['
+                continue;
+            }
+            if (negated) set.flip();
+            classes.push_back(set);
+            ops.push_back({OpType::Class, 0, (int)classes.size() - 1});
+            i = j;
+        } else {
+            ops.push_back({OpType::Char, c, -1});
+        }
+    }
+
+    size_t head = 0;
+    while (head < ops.size() && ops[head].type == OpType::Char) prefix += ops[head++].c;
+    literal = head == ops.size();
+    if (!literal) {
+        size_t tail = ops.size();
+        while (tail > head && ops[tail - 1].type == OpType::Char) tail--;
+        for (size_t k = tail; k < ops.size(); ++k) suffix += ops[k].c;
+    }
+    matchesDotfiles = dotfiles || (!prefix.empty() && prefix[0] == '.');
+}
+
+bool GlobSegment::matches(std::string_view name) const {
+    if (literal) return name == prefix;
+    if (!matchesDotfiles && !name.empty() && name[0] == '.') return false;
+
+    // Literal prefix/suffix first: rejects most names without running the matcher
+    if (name.size() < prefix.size() + suffix.size()) return false;
+    if (name.compare(0, prefix.size(), prefix) != 0) return false;
+    if (name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) return false;
+    return matchOps(name.substr(prefix.size(), name.size() - prefix.size() - suffix.size()));
+}
+
+// Runs the ops between prefix and suffix; a star backtracks to the last
+// position it was tried at, which keeps matching linear for one star and
+// O(n*m) in the worst case
+bool GlobSegment::matchOps(std::string_view name) const {
+    const size_t begin = prefix.size();
+    const size_t end = ops.size() - suffix.size();
+
+    size_t p = begin, n = 0;
+    size_t starP = std::string::npos, starN = 0;
+    while (n < name.size()) {
+        if (p < end && ops[p].type == OpType::Star) {
+            starP = p++;
+            starN = n;
+            continue;
+        }
+        if (p < end) {
+            const Op& op = ops[p];
+            unsigned char c = name[n];
+            bool ok = op.type == OpType::Any ||
+                      (op.type == OpType::Char && op.c == (char)c) ||
+                      (op.type == OpType::Class && classes[op.classIndex].test(c));
+            if (ok) {
+                p++;
+                n++;
+                continue;
+            }
+        }
+        if (starP == std::string::npos) return false;
+        p = starP + 1;
+        n = ++starN;
+    }
+    while (p < end && ops[p].type == OpType::Star) p++;
+    return p == end;
+}
+
+// --- GlobPattern ----------------------------------------------------------
+
+GlobPattern::GlobPattern(std::string_view pattern) {
+    if (!pattern.empty() && pattern[0] == '/') root = "/";
+    while (pattern.size() > 1 && pattern.back() == '/') {
+        directoriesOnly = true;
+        pattern.remove_suffix(1);
+    }
+
+    size_t pos = 0;
+    bool leading = true;
+    while (pos <= pattern.size()) {
+        size_t slash = pattern.find('/', pos);
+        if (slash == std::string_view::npos) slash = pattern.size();
+        std::string_view piece = pattern.substr(pos, slash - pos);
+        pos = slash + 1;
+        if (piece.empty()) continue;
+
+        if (piece == "**") {
+            leading = false;
+            if (parts.empty() || !parts.back().recursive) parts.push_back({true, GlobSegment("")});
+            hasRecursive = true;
+            continue;
+        }
+        GlobSegment segment(piece);
+        // Literal directories before the first wildcard are joined without listing
+        if (leading && segment.isLiteral() && slash < pattern.size()) {
+            root += segment.text() + "/";
+            continue;
+        }
+        leading = false;
+        parts.push_back({false, std::move(segment)});
+    }
+}
+
+void GlobPattern::emit(const std::string& display, bool isDir, std::vector<std::string>& out) const {
+    if (directoriesOnly && !isDir) return;
+    out.push_back(directoriesOnly ? display + "/" : display);
+}
+
+void GlobPattern::expandFrom(const std::string& display, size_t part, std::vector<std::string>& out,
+                             std::vector<std::vector<std::string>>* perWorker) const {
+    const Part& p = parts[part];
+    const bool last = part + 1 == parts.size();
+
+    if (p.recursive) {
+        ThreadPool::shared().submit([this, display, part, perWorker] { walkRecursive(display, part + 1, *perWorker); });
+        return;
+    }
+
+    if (p.segment.isLiteral()) {
+        std::string path = display + p.segment.text();
+        bool isDir = false;
+        if (!pathExists(path, isDir)) return;
+        if (last) emit(path, isDir, out);
+        else if (isDir) expandFrom(path + "/", part + 1, out, perWorker);
+        return;
+    }
+
+    forEachDirectoryEntry(display, [&](const char* name, bool isDir, bool isLink) {
+        if (!p.segment.matches(name)) return;
+        std::string path = display + name;
+        if (isLink) pathExists(path, isDir); // outside ** symlinked directories are followed
+        if (last) emit(path, isDir, out);
+        else if (isDir) expandFrom(path + "/", part + 1, out, perWorker);
+    });
+}
+
+// One task per directory below a "**": matches the rest of the pattern here
+// and fans out to the subdirectories (hidden ones and symlinks are skipped,
+// as bash does with globstar)
+void GlobPattern::walkRecursive(const std::string& display, size_t part,
+                                std::vector<std::vector<std::string>>& perWorker) const {
+    ThreadPool& pool = ThreadPool::shared();
+    std::vector<std::string> local;
+
+    const bool tail = part == parts.size();
+    const bool single = part + 1 == parts.size() && !parts[part].recursive;
+    forEachDirectoryEntry(display, [&](const char* name, bool isDir, bool isLink) {
+        bool hidden = name[0] == '.';
+        if (tail ? !hidden : (single && parts[part].segment.matches(name))) {
+            emit(display + name, isDir && !isLink, local);
+        }
+        if (isDir && !isLink && !hidden) {
+            std::string sub = display + name + "/";
+            pool.submit([this, sub, part, &perWorker] { walkRecursive(sub, part, perWorker); });
+        }
+    });
+    if (!tail && !single) expandFrom(display, part, local, &perWorker);
+
+    auto& bucket = perWorker[pool.workerIndex()];
+    bucket.insert(bucket.end(), std::make_move_iterator(local.begin()), std::make_move_iterator(local.end()));
+}
+
+std::vector<std::string> GlobPattern::expand() const {
+    std::vector<std::string> out;
+    if (parts.empty()) return out;
+
+    if (!hasRecursive) {
+        expandFrom(root, 0, out, nullptr);
+    } else {
+        ThreadPool& pool = ThreadPool::shared();
+        std::vector<std::vector<std::string>> perWorker(pool.size() + 1);
+        expandFrom(root, 0, perWorker[pool.size()], &perWorker);
+        pool.wait();
+        for (auto& bucket : perWorker) {
+            out.insert(out.end(), std::make_move_iterator(bucket.begin()), std::make_move_iterator(bucket.end()));
+        }
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
@@ -0,0 +1,496 @@
+#include "grep.h"
+#include "thread_pool.h"
+#include "trace.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define MYTERM_GREP_SSE2 1
+#endif
+
+#include <sys/stat.h>
+
+static inline unsigned char asciiLower(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? c + 32 : c;
+}
+
+static inline unsigned char asciiUpper(unsigned char c) {
+    return (c >= 'a' && c <= 'z') ? c - 32 : c;
+}
+
+// --- LiteralFinder --------------------------------------------------------
+
+// Lower is more common. Bytes not listed (uppercase, most symbols, non-ASCII)
+// are treated as rare.
+static int byteFrequency(unsigned char c) {
+    static const char common[] = " etaoinsrlhdcumpfgybwv\n_.,;()=k\t/*\"-:x0>'1<{}2j[]#q+z&!";
+    const char* hit = (const char*)std::memchr(common, c, sizeof(common) - 1);
+    return hit ? (int)(sizeof(common) - (hit - common)) : 0;
+}
+
+LiteralFinder::LiteralFinder(std::string_view text, bool ignoreCase) : needle(text), ignoreCase(ignoreCase) {
+    if (needle.empty()) return;
+    if (ignoreCase) {
+        for (char& c : needle) c = (char)asciiLower(c);
+    }
+
+    // Two rarest positions (the same one for a single byte needle)
+    for (size_t k = 1; k < needle.size(); ++k) {
+        if (byteFrequency(needle[k]) < byteFrequency(needle[rareOffset1])) rareOffset1 = k;
+    }
+    rareOffset2 = rareOffset1 == 0 && needle.size() > 1 ? 1 : 0;
+    for (size_t k = 0; k < needle.size(); ++k) {
+        if (k != rareOffset1 && byteFrequency(needle[k]) < byteFrequency(needle[rareOffset2])) rareOffset2 = k;
+    }
+    if (needle.size() == 1) rareOffset2 = rareOffset1;
+
+    unsigned char r1 = needle[rareOffset1], r2 = needle[rareOffset2];
+    rare1Lower = r1;
+    rare1Upper = ignoreCase ? asciiUpper(r1) : r1;
+    rare2Lower = r2;
+    rare2Upper = ignoreCase ? asciiUpper(r2) : r2;
+}
+
+bool LiteralFinder::equalsAt(const char* p) const {
+    if (!ignoreCase) return std::memcmp(p, needle.data(), needle.size()) == 0;
+    for (size_t k = 0; k < needle.size(); ++k) {
+        if (asciiLower(p[k]) != (unsigned char)needle[k]) return false;
+    }
+    return true;
+}
+
+// Candidate starts in [from, lastStart], 16 at a time
+size_t LiteralFinder::findVector(const char* data, size_t from, size_t lastStart) const {
+    size_t i = from;
+    #ifdef MYTERM_GREP_SSE2
+        const __m128i r1L = _mm_set1_epi8((char)rare1Lower), r1U = _mm_set1_epi8((char)rare1Upper);
+        const __m128i r2L = _mm_set1_epi8((char)rare2Lower), r2U = _mm_set1_epi8((char)rare2Upper);
+        // Both loads stay inside the buffer: i + offset + 15 <= lastStart + m - 1
+        for (; i + 16 <= lastStart + 1; i += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(data + i + rareOffset1));
+            __m128i b = _mm_loadu_si128((const __m128i*)(data + i + rareOffset2));
+            __m128i eq1 = _mm_or_si128(_mm_cmpeq_epi8(a, r1L), _mm_cmpeq_epi8(a, r1U));
+            __m128i eq2 = _mm_or_si128(_mm_cmpeq_epi8(b, r2L), _mm_cmpeq_epi8(b, r2U));
+            unsigned mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(eq1, eq2));
+            while (mask) {
+                unsigned bit = (unsigned)__builtin_ctz(mask);
+                if (equalsAt(data + i + bit)) return i + bit;
+                mask &= mask - 1;
+            }
+        }
+    #endif
+    for (; i <= lastStart; ++i) {
+        unsigned char c = data[i + rareOffset1];
+        if ((c == rare1Lower || c == rare1Upper) && equalsAt(data + i)) return i;
+    }
+    return std::string::npos;
+}
+
+size_t LiteralFinder::find(const char* data, size_t size) const {
+    const size_t m = needle.size();
+    if (m == 0) return 0;
+    if (size < m) return std::string::npos;
+    const size_t lastStart = size - m; // last offset a match can start at
+
+    // memchr only works for a single byte value
+    if (rare1Lower != rare1Upper) return findVector(data, 0, lastStart);
+
+    size_t i = 0, misses = 0;
+    while (i <= lastStart) {
+        const void* hit = std::memchr(data + i + rareOffset1, rare1Lower, lastStart - i + 1);
+        if (!hit) return std::string::npos;
+        size_t start = (const char*)hit - data - rareOffset1;
+        unsigned char c2 = data[start + rareOffset2];
+        if ((c2 == rare2Lower || c2 == rare2Upper) && equalsAt(data + start)) return start;
+        i = start + 1;
+        // The "rare" byte is common in this text: memchr restarts too often
+        if (++misses > 64 && i < misses * 32) return findVector(data, i, lastStart);
+    }
+    return std::string::npos;
+}
+
+// --- GrepMatcher ----------------------------------------------------------
+
+// Index of the ']' closing the bracket expression that opens at `open`, by
+// the rules of LineRegexCompiler::parseBracket: a leading ']' is a member,
+// and [:class:], [=x=] and [.x.] may contain ']'
+static size_t bracketEnd(std::string_view pattern, size_t open) {
+    size_t j = open + 1;
+    if (j < pattern.size() && pattern[j] == '^') j++;
+    if (j < pattern.size() && pattern[j] == ']') j++;
+    while (j < pattern.size() && pattern[j] != ']') {
+        if (pattern[j] == '[' && j + 1 < pattern.size() && std::strchr(":=.", pattern[j + 1])) {
+            size_t close = pattern.find(std::string{pattern[j + 1], ']'}, j + 2);
+            if (close == std::string_view::npos) return pattern.size();
+            j = close + 2;
+        } else {
+            j++;
+        }
+    }
+    return j;
+}
+
+// Longest run of plain characters that every match of the regex must
+// contain. Conservative: nothing when the pattern has alternation, and runs
+// inside groups or right before a quantifier are not used.
+static std::string requiredLiteral(std::string_view pattern, bool extended) {
+    std::string best, current;
+    auto flush = [&] {
+        if (current.size() > best.size()) best = current;
+        current.clear();
+    };
+    auto quantifier = [&] {
+        if (!current.empty()) current.pop_back(); // the repeated atom may be absent
+        flush();
+    };
+
+    int depth = 0;
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        char c = pattern[i];
+        if (c == '\\') {
+            if (i + 1 >= pattern.size()) break;
+            char next = pattern[++i];
+            if (next == '|') return "";
+            if (std::strchr("<>`'", next)) {
+                flush(); // zero-width: \< \> \` \'
+                continue;
+            }
+            bool special = extended ? std::isalnum((unsigned char)next)
+                                    : std::isalnum((unsigned char)next) || std::strchr("(){}+?", next);
+            if (!special) {
+                if (depth == 0) current += next;
+                else flush();
+                continue;
+            }
+            if (!extended && next == '(') depth++;
+            else if (!extended && next == ')') depth = std::max(0, depth - 1);
+            if (!extended && (next == '{' || next == '?' || next == '+')) {
+                quantifier();
+                if (next == '{') {
+                    size_t close = pattern.find("\\}", i);
+                    i = close == std::string_view::npos ? pattern.size() : close + 1;
+                }
+            } else {
+                flush();
+            }
+            continue;
+        }
+        if (extended && c == '|') return "";
+        if (c == '*' || (extended && (c == '?' || c == '{'))) {
+            quantifier();
+            if (c == '{') {
+                while (i < pattern.size() && pattern[i] != '}') i++;
+            }
+            continue;
+        }
+        if (extended && c == '(') {
+            depth++;
+            flush();
+            continue;
+        }
+        if (extended && c == ')') {
+            depth = std::max(0, depth - 1);
+            flush();
+            continue;
+        }
+        if (c == '[') {
+            flush();
+            i = bracketEnd(pattern, i);
+            continue;
+        }
+        if (c == '.' || c == '^' || c == '$' || (extended && c == '+')) {
+            flush();
+            continue;
+        }
+        if (depth == 0) current += c;
+    }
+    flush();
+    return best;
+}
+
+GrepMatcher::GrepMatcher(std::string_view pattern, const GrepOptions& options) {
+    if (options.fixed) {
+        literal = LiteralFinder(pattern, options.ignoreCase);
+        return;
+    }
+    literal = LiteralFinder(requiredLiteral(pattern, options.extended), options.ignoreCase);
+
+    useRegex = regex.compile(pattern, options.extended, options.ignoreCase, error);
+}
+
+size_t GrepMatcher::nextCandidate(const char* data, size_t size, size_t from) const {
+    if (from >= size) return std::string::npos;
+    if (literal.empty()) return from;
+    size_t hit = literal.find(data + from, size - from);
+    if (hit == std::string::npos) return std::string::npos;
+    size_t pos = from + hit;
+    while (pos > from && data[pos - 1] != '\n') pos--;
+    return pos;
+}
+
+bool GrepMatcher::matchLine(const char* line, size_t length, std::vector<std::pair<size_t, size_t>>* spans) const {
+    if (!useRegex) {
+        if (literal.empty()) return true;
+        bool found = false;
+        size_t pos = 0;
+        while (pos + literal.length() <= length) {
+            size_t hit = literal.find(line + pos, length - pos);
+            if (hit == std::string::npos) break;
+            found = true;
+            if (!spans) break;
+            spans->push_back({pos + hit, pos + hit + literal.length()});
+            pos += hit + literal.length();
+        }
+        return found;
+    }
+
+    if (!literal.empty() && literal.find(line, length) == std::string::npos) return false;
+    if (!spans) return regex.matches(line, length);
+
+    bool found = false;
+    size_t start, end;
+    for (size_t from = 0; from <= length && regex.search(line, length, from, start, end);) {
+        found = true;
+        if (end > start) spans->push_back({start, end});
+        from = end > start ? end : end + 1;
+    }
+    return found;
+}
+
+// --- Search ---------------------------------------------------------------
+
+namespace {
+
+struct FileResult {
+    std::string output;
+    bool matched = false;
+    bool failed = false;
+    bool done = false; // guarded by the search's mutex
+};
+
+size_t countNewlines(const char* data, size_t size) {
+    size_t count = 0;
+    const char* end = data + size;
+    while (const void* hit = std::memchr(data, '\n', end - data)) {
+        count++;
+        data = (const char*)hit + 1;
+    }
+    return count;
+}
+
+class Searcher {
+public:
+    Searcher(const GrepMatcher& matcher, const GrepOptions& options, const GrepColors& colors, bool showPath)
+        : matcher(matcher), options(options), colors(colors), showPath(showPath) {}
+
+    void searchFile(const std::string& path, FileResult& result) const {
+        MappedFile file(path);
+        if (!file.isOpen()) {
+            result.failed = true;
+            result.output = Colors::RED + "Error: No se pudo leer " + path + Colors::RESET + "\n";
+            return;
+        }
+        const char* data = file.data();
+        const size_t size = file.size();
+        const bool binary = std::memchr(data, '\0', std::min<size_t>(size, 8192)) != nullptr;
+
+        size_t matches = 0;
+        size_t lineNumber = 1, counted = 0;
+        std::vector<std::pair<size_t, size_t>> spans;
+        auto emit = [&](size_t start, size_t end) {
+            matches++;
+            if (options.countOnly || options.filesOnly || binary) return;
+            std::string& out = result.output;
+            if (showPath) out += colors.path + path + colors.separator + ":" + colors.reset;
+            if (options.lineNumbers) {
+                lineNumber += countNewlines(data + counted, start - counted);
+                counted = start;
+                out += colors.lineNumber + std::to_string(lineNumber) + colors.separator + ":" + colors.reset;
+            }
+            size_t pos = start;
+            for (const auto& span : spans) {
+                out.append(data + pos, start + span.first - pos);
+                out += colors.match;
+                out.append(data + start + span.first, span.second - span.first);
+                out += colors.reset;
+                pos = start + span.second;
+            }
+            out.append(data + pos, end - pos);
+            out += '\n';
+        };
+        // Binary files and -l/-c only need to know whether (or how often) it matched
+        const bool wantSpans = !options.invert && !options.countOnly && !options.filesOnly && !binary;
+        const bool stopAtFirst = options.filesOnly || (binary && !options.countOnly);
+
+        size_t pos = 0;
+        while (pos < size) {
+            size_t start = options.invert ? pos : matcher.nextCandidate(data, size, pos);
+            if (start == std::string::npos) break;
+            const void* nl = std::memchr(data + start, '\n', size - start);
+            size_t end = nl ? (const char*)nl - data : size;
+
+            spans.clear();
+            bool hit = matcher.matchLine(data + start, end - start, wantSpans ? &spans : nullptr);
+            if (hit != options.invert) {
+                emit(start, end);
+                if (stopAtFirst) break;
+            }
+            pos = end + 1;
+        }
+
+        result.matched = matches > 0;
+        if (options.countOnly) {
+            if (showPath) result.output += colors.path + path + colors.separator + ":" + colors.reset;
+            result.output += std::to_string(matches) + "\n";
+        } else if (options.filesOnly) {
+            if (matches) result.output = colors.path + path + colors.reset + "\n";
+        } else if (binary && matches) {
+            result.output = "Archivo binario " + path + " coincide\n";
+        }
+    }
+
+private:
+    const GrepMatcher& matcher;
+    const GrepOptions& options;
+    const GrepColors& colors;
+    bool showPath;
+};
+
+// One task per directory, files gathered per worker like GlobPattern does
+void walkDirectory(const std::string& dir, std::vector<std::vector<std::string>>& perWorker) {
+    ThreadPool& pool = ThreadPool::shared();
+    std::vector<std::string> local;
+    forEachDirectoryEntry(dir, [&](const char* name, bool isDir, bool isLink) {
+        if (name[0] == '.' || isLink) return;
+        std::string path = dir + name;
+        if (isDir) pool.submit([path, &perWorker] { walkDirectory(path + "/", perWorker); });
+        else local.push_back(std::move(path));
+    });
+    auto& bucket = perWorker[pool.workerIndex()];
+    bucket.insert(bucket.end(), std::make_move_iterator(local.begin()), std::make_move_iterator(local.end()));
+}
+
+bool isDirectoryPath(const std::string& path, bool& exists) {
+    struct stat st;
+    exists = stat(path.c_str(), &st) == 0;
+    return exists && S_ISDIR(st.st_mode);
+}
+
+} // namespace
+
+int runGrep(const GrepMatcher& matcher, const std::vector<std::string>& paths, const GrepOptions& options,
+            const GrepColors& colors, std::ostream& out) {
+    TRACE_SCOPE("grep");
+    ThreadPool& pool = ThreadPool::shared();
+
+    // Files in output order; errors are kept in place as pre-filled results
+    std::vector<std::string> files;
+    std::vector<FileResult> results;
+    auto addError = [&](const std::string& message) {
+        files.emplace_back();
+        results.emplace_back();
+        results.back().failed = true;
+        results.back().output = Colors::RED + "Error: " + message + Colors::RESET + "\n";
+    };
+    auto addFile = [&](std::string path) {
+        files.push_back(std::move(path));
+        results.emplace_back();
+    };
+
+    {
+        TRACE_SCOPE("grepWalk");
+        for (const std::string& arg : paths) {
+            bool exists;
+            if (!isDirectoryPath(arg.empty() ? "." : arg, exists)) {
+                if (exists) addFile(arg);
+                else addError(arg + ": no existe el archivo o directorio");
+                continue;
+            }
+            if (!options.recursive) {
+                addError(arg + " es un directorio (use -r)");
+                continue;
+            }
+            std::string root = arg.empty() || arg.back() == '/' ? arg : arg + "/";
+            std::vector<std::vector<std::string>> perWorker(pool.size() + 1);
+            walkDirectory(root, perWorker);
+            pool.wait();
+            std::vector<std::string> found;
+            for (auto& bucket : perWorker) {
+                found.insert(found.end(), std::make_move_iterator(bucket.begin()), std::make_move_iterator(bucket.end()));
+            }
+            std::sort(found.begin(), found.end());
+            for (auto& path : found) addFile(std::move(path));
+        }
+    }
+
+    const bool showPath = options.recursive || paths.size() > 1;
+    Searcher searcher(matcher, options, colors, showPath);
+
+    // Results are written as soon as every file before them is done, in
+    // large blocks rather than line by line, and freed right away. At most
+    // `window` files are searched ahead of the one being written.
+    bool matched = false, failed = false;
+    std::string buffer;
+    auto write = [&](FileResult& result) {
+        matched |= result.matched;
+        failed |= result.failed;
+        buffer += result.output;
+        std::string().swap(result.output);
+        if (buffer.size() >= 64 * 1024) {
+            out.write(buffer.data(), (std::streamsize)buffer.size());
+            buffer.clear();
+        }
+    };
+    auto flush = [&] {
+        out.write(buffer.data(), (std::streamsize)buffer.size());
+        buffer.clear();
+        out.flush();
+    };
+
+    {
+        TRACE_SCOPE("grepSearch");
+        if (files.size() == 1) {
+            if (!results[0].failed) searcher.searchFile(files[0], results[0]);
+            write(results[0]);
+        } else {
+            std::mutex mutex;
+            std::condition_variable doneCv;
+            auto submit = [&](size_t i) {
+                if (results[i].failed) {
+                    results[i].done = true;
+                    return;
+                }
+                pool.submit([&, i] {
+                    searcher.searchFile(files[i], results[i]);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    results[i].done = true;
+                    doneCv.notify_one();
+                });
+            };
+            const size_t window = 4 * pool.size();
+            size_t submitted = 0;
+            for (; submitted < files.size() && submitted < window; ++submitted) submit(submitted);
+            for (size_t i = 0; i < files.size(); ++i) {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (!results[i].done) {
+                    lock.unlock();
+                    flush(); // show what is ready before blocking
+                    lock.lock();
+                    doneCv.wait(lock, [&] { return results[i].done; });
+                }
+                lock.unlock();
+                write(results[i]);
+                if (submitted < files.size()) submit(submitted++);
+            }
+            pool.wait();
+        }
+    }
+    flush();
+    return failed ? 2 : matched ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,678 @@
+#include "line_regex.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <map>
+
+namespace {
+
+const size_t MAX_PROGRAM = 100000; // ops, after {m,n} copies
+const int MAX_REPEAT = 1000;
+
+inline bool isWordByte(unsigned char c) {
+    return std::isalnum(c) || c == '_';
+}
+
+// Parse tree; {m,n} is expanded only when the program is emitted
+struct Node {
+    enum Kind : uint8_t { Empty, Char, Set, Assert, Concat, Alternate, Repeat };
+    Kind kind = Empty;
+    uint8_t value = 0;  // Char: the byte; Assert: the assertion
+    int set = -1;       // Set: index in LineRegex::sets
+    int min = 0;        // Repeat bounds; max -1 is unbounded
+    int max = 0;
+    std::vector<int> children;
+};
+
+} // namespace
+
+// Recursive descent over the pattern. Nesting depth is bounded by the
+// pattern length, which comes from the command line.
+class LineRegexCompiler {
+public:
+    LineRegexCompiler(LineRegex& out, std::string_view pattern, bool extended, bool ignoreCase)
+        : out(out), pattern(pattern), extended(extended), ignoreCase(ignoreCase) {}
+
+    bool compile(std::string& message) {
+        int root = parseAlternation();
+        if (error.empty() && pos < pattern.size()) error = "parentesis sin abrir";
+        if (error.empty()) {
+            emit(root);
+            emitOp(LineRegex::OpType::Match);
+            if (out.program.size() > MAX_PROGRAM) error = "expresion demasiado grande";
+        }
+        if (!error.empty()) {
+            out.program.clear();
+            out.sets.clear();
+            message = error;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    using Op = LineRegex::Op;
+    using OpType = LineRegex::OpType;
+
+    int node(Node::Kind kind) {
+        nodes.push_back(Node());
+        nodes.back().kind = kind;
+        return (int)nodes.size() - 1;
+    }
+
+    int setNode(std::bitset<256> bytes) {
+        if (ignoreCase) {
+            for (int c = 'a'; c <= 'z'; ++c) {
+                if (bytes[c] || bytes[c - 32]) bytes.set(c).set(c - 32);
+            }
+        }
+        int n = node(Node::Set);
+        nodes[n].set = (int)out.sets.size();
+        out.sets.push_back(bytes);
+        return n;
+    }
+
+    int charNode(unsigned char c) {
+        if (ignoreCase && std::isalpha(c)) return setNode(std::bitset<256>().set(c));
+        int n = node(Node::Char);
+        nodes[n].value = c;
+        return n;
+    }
+
+    int assertNode(uint8_t assertion) {
+        int n = node(Node::Assert);
+        nodes[n].value = assertion;
+        return n;
+    }
+
+    bool at(const char* token) const {
+        return pattern.substr(pos, std::strlen(token)) == token;
+    }
+
+    // Operator tokens differ between the two syntaxes
+    bool atAlternation() const { return extended ? at("|") : at("\\|"); }
+    bool atOpenGroup() const { return extended ? at("(") : at("\\("); }
+    bool atCloseGroup() const { return extended ? depth > 0 && at(")") : at("\\)"); }
+
+    int parseAlternation() {
+        int first = parseConcat();
+        if (!atAlternation()) return first;
+        int alt = node(Node::Alternate);
+        nodes[alt].children.push_back(first);
+        while (error.empty() && atAlternation()) {
+            pos += extended ? 1 : 2;
+            int next = parseConcat();
+            nodes[alt].children.push_back(next);
+        }
+        return alt;
+    }
+
+    int parseConcat() {
+        int concat = node(Node::Concat);
+        size_t begin = pos;
+        while (error.empty() && pos < pattern.size() && !atAlternation() && !atCloseGroup()) {
+            // A leading '*' (after an optional '^') repeats nothing: it is literal
+            bool leading = pos == begin || (pos == begin + 1 && pattern[begin] == '^');
+            int atom = parseAtom(leading);
+            if (!error.empty()) break;
+            atom = parseQuantifiers(atom);
+            nodes[concat].children.push_back(atom);
+        }
+        return concat;
+    }
+
+    int parseQuantifiers(int atom) {
+        while (error.empty() && pos < pattern.size()) {
+            int min, max;
+            if (pattern[pos] == '*') {
+                pos++;
+                min = 0, max = -1;
+            } else if (extended ? at("+") : at("\\+")) {
+                pos += extended ? 1 : 2;
+                min = 1, max = -1;
+            } else if (extended ? at("?") : at("\\?")) {
+                pos += extended ? 1 : 2;
+                min = 0, max = 1;
+            } else if (extended ? at("{") : at("\\{")) {
+                size_t saved = pos;
+                pos += extended ? 1 : 2;
+                if (!parseInterval(min, max)) {
+                    // GNU ERE: a '{' that does not start an interval is literal
+                    if (extended && error.empty()) pos = saved;
+                    else if (error.empty()) error = "intervalo invalido";
+                    return atom;
+                }
+            } else {
+                return atom;
+            }
+            int repeat = node(Node::Repeat);
+            nodes[repeat].min = min;
+            nodes[repeat].max = max;
+            nodes[repeat].children.push_back(atom);
+            atom = repeat;
+        }
+        return atom;
+    }
+
+    // After the opening brace: "m}", "m,}", "m,n}" or GNU's ",n}"
+    bool parseInterval(int& min, int& max) {
+        auto number = [&](int& value) {
+            size_t start = pos;
+            value = 0;
+            while (pos < pattern.size() && std::isdigit((unsigned char)pattern[pos])) {
+                value = std::min(value * 10 + (pattern[pos++] - '0'), MAX_REPEAT + 1);
+            }
+            return pos > start;
+        };
+        bool hasMin = number(min);
+        if (!hasMin) min = 0;
+        max = min;
+        if (pos < pattern.size() && pattern[pos] == ',') {
+            pos++;
+            if (!number(max)) max = -1;
+        } else if (!hasMin) {
+            return false;
+        }
+        if (!(extended ? at("}") : at("\\}"))) return false;
+        pos += extended ? 1 : 2;
+        if (min > MAX_REPEAT || max > MAX_REPEAT || (max >= 0 && max < min)) {
+            error = "intervalo invalido";
+            return false;
+        }
+        return true;
+    }
+
+    int parseAtom(bool leading) {
+        char c = pattern[pos];
+        if (atOpenGroup()) {
+            pos += extended ? 1 : 2;
+            depth++;
+            int inner = parseAlternation();
+            depth--;
+            if (!error.empty()) return inner;
+            if (!(extended ? at(")") : at("\\)"))) {
+                error = "parentesis sin cerrar";
+                return inner;
+            }
+            pos += extended ? 1 : 2;
+            return inner;
+        }
+        if (c == '[') {
+            pos++;
+            return parseBracket();
+        }
+        if (c == '.') {
+            pos++;
+            return setNode(std::bitset<256>().set().reset('\n'));
+        }
+        if (c == '^' && (extended || leading)) {
+            pos++;
+            return assertNode(LineRegex::LINE_START);
+        }
+        if (c == '$' && (extended || pos + 1 == pattern.size() || pattern.substr(pos + 1, 2) == "\\)" ||
+                         pattern.substr(pos + 1, 2) == "\\|")) {
+            pos++;
+            return assertNode(LineRegex::LINE_END);
+        }
+        if (c == '*' && leading) {
+            pos++;
+            return charNode('*');
+        }
+        if (extended && leading && (c == '+' || c == '?' || c == '{')) {
+            pos++;
+            return charNode((unsigned char)c);
+        }
+        if (c == '\\') return parseEscape();
+        pos++;
+        return charNode((unsigned char)c);
+    }
+
+    int parseEscape() {
+        if (pos + 1 >= pattern.size()) {
+            error = "barra invertida al final";
+            return node(Node::Empty);
+        }
+        unsigned char c = pattern[pos + 1];
+        pos += 2;
+        std::bitset<256> bytes;
+        switch (c) {
+            case 'w':
+            case 'W':
+                for (int b = 0; b < 256; ++b) bytes[b] = isWordByte((unsigned char)b);
+                if (c == 'W') bytes.flip();
+                return setNode(bytes);
+            case 's':
+            case 'S':
+                for (int b = 0; b < 256; ++b) bytes[b] = std::isspace(b) != 0;
+                if (c == 'S') bytes.flip();
+                return setNode(bytes);
+            case 'b': return assertNode(LineRegex::WORD_BOUNDARY);
+            case 'B': return assertNode(LineRegex::NOT_WORD_BOUNDARY);
+            case '<': return assertNode(LineRegex::WORD_START);
+            case '>': return assertNode(LineRegex::WORD_END);
+            case '`': return assertNode(LineRegex::LINE_START);
+            case '\'': return assertNode(LineRegex::LINE_END);
+            default:
+                if (c >= '1' && c <= '9') {
+                    error = "las referencias hacia atras (\\1-\\9) no estan soportadas";
+                    return node(Node::Empty);
+                }
+                return charNode(c);
+        }
+    }
+
+    // After the '['
+    int parseBracket() {
+        std::bitset<256> bytes;
+        bool negate = pos < pattern.size() && pattern[pos] == '^';
+        if (negate) pos++;
+        bool first = true;
+        while (true) {
+            if (pos >= pattern.size()) {
+                error = "falta ']'";
+                return node(Node::Empty);
+            }
+            unsigned char c = pattern[pos];
+            if (c == ']' && !first) {
+                pos++;
+                break;
+            }
+            first = false;
+            if (c == '[' && pos + 1 < pattern.size() && std::strchr(":=.", pattern[pos + 1])) {
+                char kind = pattern[pos + 1];
+                size_t close = pattern.find(std::string{kind, ']'}, pos + 2);
+                if (close == std::string_view::npos) {
+                    error = "falta ']'";
+                    return node(Node::Empty);
+                }
+                std::string_view name = pattern.substr(pos + 2, close - pos - 2);
+                pos = close + 2;
+                if (kind == ':') {
+                    if (!addClass(name, bytes)) {
+                        error = "clase de caracteres desconocida '" + std::string(name) + "'";
+                        return node(Node::Empty);
+                    }
+                    continue;
+                }
+                if (name.size() != 1) {
+                    error = "elemento de intercalacion no soportado";
+                    return node(Node::Empty);
+                }
+                c = name[0];
+            } else {
+                pos++;
+            }
+            // Range, unless the '-' is the last thing before ']'
+            if (pos + 1 < pattern.size() && pattern[pos] == '-' && pattern[pos + 1] != ']') {
+                unsigned char last = pattern[pos + 1];
+                pos += 2;
+                if (last < c) {
+                    error = "rango invalido";
+                    return node(Node::Empty);
+                }
+                for (int b = c; b <= last; ++b) bytes.set(b);
+            } else {
+                bytes.set(c);
+            }
+        }
+        if (ignoreCase) {
+            for (int b = 'a'; b <= 'z'; ++b) {
+                if (bytes[b] || bytes[b - 32]) bytes.set(b).set(b - 32);
+            }
+        }
+        if (negate) bytes.flip().reset('\n');
+        return setNode(bytes);
+    }
+
+    // [:name:] in the C locale
+    static bool addClass(std::string_view name, std::bitset<256>& bytes) {
+        static const char* const names[] = {"alpha", "digit", "alnum", "upper", "lower", "space",
+                                            "blank", "punct", "print", "graph", "cntrl", "xdigit"};
+        int kind = 0;
+        while (kind < 12 && name != names[kind]) kind++;
+        for (int b = 0; b < 128; ++b) {
+            bool in = false;
+            switch (kind) {
+                case 0: in = std::isalpha(b); break;
+                case 1: in = std::isdigit(b); break;
+                case 2: in = std::isalnum(b); break;
+                case 3: in = std::isupper(b); break;
+                case 4: in = std::islower(b); break;
+                case 5: in = std::isspace(b); break;
+                case 6: in = std::isblank(b); break;
+                case 7: in = std::ispunct(b); break;
+                case 8: in = std::isprint(b); break;
+                case 9: in = std::isgraph(b); break;
+                case 10: in = std::iscntrl(b); break;
+                case 11: in = std::isxdigit(b); break;
+                default: return false;
+            }
+            if (in) bytes.set(b);
+        }
+        return true;
+    }
+
+    size_t emitOp(OpType type, uint8_t arg = 0, int32_t x = 0, int32_t y = 0) {
+        out.program.push_back({type, arg, x, y});
+        return out.program.size() - 1;
+    }
+
+    void emit(int index) {
+        if (out.program.size() > MAX_PROGRAM) return;
+        const Node& n = nodes[index];
+        switch (n.kind) {
+            case Node::Empty:
+                break;
+            case Node::Char:
+                emitOp(OpType::Char, n.value);
+                break;
+            case Node::Set:
+                emitOp(OpType::Set, 0, n.set);
+                break;
+            case Node::Assert:
+                emitOp(OpType::Assert, n.value);
+                break;
+            case Node::Concat:
+                for (int child : n.children) emit(child);
+                break;
+            case Node::Alternate: {
+                std::vector<size_t> jumps;
+                for (size_t i = 0; i < n.children.size(); ++i) {
+                    bool last = i + 1 == n.children.size();
+                    size_t split = last ? 0 : emitOp(OpType::Split);
+                    if (!last) out.program[split].x = (int32_t)out.program.size();
+                    emit(n.children[i]);
+                    if (last) break;
+                    jumps.push_back(emitOp(OpType::Jump));
+                    out.program[split].y = (int32_t)out.program.size();
+                }
+                for (size_t jump : jumps) out.program[jump].x = (int32_t)out.program.size();
+                break;
+            }
+            case Node::Repeat: {
+                int child = n.children[0];
+                for (int i = 0; i < n.min && out.program.size() <= MAX_PROGRAM; ++i) emit(child);
+                if (n.max < 0) {
+                    // x* : L: split L+1, end; x; jump L
+                    size_t loop = emitOp(OpType::Split);
+                    out.program[loop].x = (int32_t)loop + 1;
+                    emit(child);
+                    emitOp(OpType::Jump, 0, (int32_t)loop);
+                    out.program[loop].y = (int32_t)out.program.size();
+                } else {
+                    // x{0,k} : k times "split next, end; x"
+                    std::vector<size_t> splits;
+                    for (int i = n.min; i < n.max && out.program.size() <= MAX_PROGRAM; ++i) {
+                        splits.push_back(emitOp(OpType::Split));
+                        out.program[splits.back()].x = (int32_t)out.program.size();
+                        emit(child);
+                    }
+                    for (size_t split : splits) out.program[split].y = (int32_t)out.program.size();
+                }
+                break;
+            }
+        }
+    }
+
+    LineRegex& out;
+    std::string_view pattern;
+    bool extended;
+    bool ignoreCase;
+    size_t pos = 0;
+    int depth = 0;
+    std::vector<Node> nodes;
+    std::string error;
+};
+
+bool LineRegex::compile(std::string_view pattern, bool extended, bool ignoreCase, std::string& error) {
+    static std::atomic<uint64_t> nextId{1};
+    program.clear();
+    sets.clear();
+    id = nextId++;
+    if (!LineRegexCompiler(*this, pattern, extended, ignoreCase).compile(error)) return false;
+    dfaSafe = std::none_of(program.begin(), program.end(), [](const Op& op) {
+        return op.type == OpType::Assert && op.arg != LINE_START && op.arg != LINE_END;
+    });
+    return true;
+}
+
+namespace {
+
+struct Thread {
+    int32_t pc;
+    size_t start;
+};
+
+// Per-thread VM state, reused between lines so matching does not allocate
+struct Scratch {
+    std::vector<Thread> current;
+    std::vector<Thread> next;
+    std::vector<uint64_t> seen; // stamp of the list each pc was last added to
+    std::vector<int32_t> stack;
+    uint64_t stamp = 0;
+};
+
+thread_local Scratch scratch;
+
+// Lazily built DFA for the last regex this thread matched with. A state is
+// the sorted set of pcs waiting on input: Char, Set, Match, and LINE_END
+// assertions, which only move on the END symbol fed after the last byte.
+struct Dfa {
+    static constexpr int END = 256;
+    static constexpr size_t MAX_STATES = 1024;
+
+    uint64_t owner = 0;
+    std::vector<std::vector<int32_t>> states;
+    std::vector<std::array<int32_t, 257>> next; // -1 until computed
+    std::vector<bool> accepting;
+    std::map<std::vector<int32_t>, int32_t> ids;
+    std::vector<uint64_t> seen;
+    uint64_t stamp = 0;
+    std::vector<int32_t> stack;
+    std::vector<int32_t> pcs;
+    int32_t start = -1;
+
+    void reset(uint64_t regex, size_t programSize) {
+        owner = regex;
+        states.clear();
+        next.clear();
+        accepting.clear();
+        ids.clear();
+        seen.assign(programSize, 0);
+        start = -1;
+    }
+};
+
+thread_local Dfa dfa;
+
+} // namespace
+
+bool LineRegex::search(const char* line, size_t length, size_t from, size_t& start, size_t& end) const {
+    return run(line, length, from, false, start, end);
+}
+
+bool LineRegex::matches(const char* line, size_t length) const {
+    if (dfaSafe && length > 0) {
+        int result = runDfa(line, length);
+        if (result >= 0) return result == 1;
+    }
+    size_t start, end;
+    return run(line, length, 0, true, start, end);
+}
+
+// Unanchored search: every step also restarts the program at pc 0, so the
+// DFA accepts as soon as a match ends anywhere in the line
+int LineRegex::runDfa(const char* line, size_t length) const {
+    Dfa& d = dfa;
+    if (d.owner != id || d.states.size() >= Dfa::MAX_STATES) d.reset(id, program.size());
+
+    // State for `seeds` after jumps, splits and assertions
+    auto closure = [&](bool atStart, bool atEnd) -> int32_t {
+        uint64_t stamp = ++d.stamp;
+        std::vector<int32_t>& set = d.pcs;
+        set.clear();
+        while (!d.stack.empty()) {
+            int32_t at = d.stack.back();
+            d.stack.pop_back();
+            if (d.seen[at] == stamp) continue;
+            d.seen[at] = stamp;
+            const Op& op = program[at];
+            if (op.type == OpType::Jump) {
+                d.stack.push_back(op.x);
+            } else if (op.type == OpType::Split) {
+                d.stack.push_back(op.y);
+                d.stack.push_back(op.x);
+            } else if (op.type == OpType::Assert && op.arg == LINE_START) {
+                if (atStart) d.stack.push_back(at + 1);
+            } else if (op.type == OpType::Assert && atEnd) {
+                d.stack.push_back(at + 1);
+            } else {
+                set.push_back(at);
+            }
+        }
+        std::sort(set.begin(), set.end());
+        auto it = d.ids.find(set);
+        if (it != d.ids.end()) return it->second;
+        int32_t state = (int32_t)d.states.size();
+        d.ids.emplace(set, state);
+        d.states.push_back(set);
+        d.next.emplace_back();
+        d.next.back().fill(-1);
+        d.accepting.push_back(std::any_of(set.begin(), set.end(), [&](int32_t pc) {
+            return program[pc].type == OpType::Match;
+        }));
+        return state;
+    };
+
+    // Successor of `state` on a byte, or on END (only LINE_END moves)
+    auto step = [&](int32_t state, int symbol) {
+        d.stack.clear();
+        if (symbol != Dfa::END) d.stack.push_back(0);
+        for (int32_t pc : d.states[state]) {
+            const Op& op = program[pc];
+            bool moves = symbol == Dfa::END ? op.type == OpType::Assert
+                       : op.type == OpType::Char ? op.arg == symbol
+                       : op.type == OpType::Set && sets[op.x][symbol];
+            if (moves) d.stack.push_back(pc + 1);
+        }
+        int32_t target = closure(false, symbol == Dfa::END);
+        d.next[state][symbol] = target;
+        return target;
+    };
+
+    if (d.start < 0) {
+        d.stack.assign(1, 0);
+        d.start = closure(true, false);
+    }
+    int32_t state = d.start;
+    for (size_t i = 0; i < length; ++i) {
+        if (d.accepting[state]) return 1;
+        unsigned char c = line[i];
+        int32_t target = d.next[state][c];
+        if (target < 0) {
+            if (d.states.size() >= Dfa::MAX_STATES) return -1;
+            target = step(state, c);
+        }
+        state = target;
+    }
+    if (d.accepting[state]) return 1;
+    int32_t end = d.next[state][Dfa::END];
+    if (end < 0) end = step(state, Dfa::END);
+    return d.accepting[end] ? 1 : 0;
+}
+
+// Threads are kept in order of their start offset: carried threads come
+// first and a new one is only started at the end of the list, so when two
+// reach the same pc the earlier start keeps it, which is the one leftmost-
+// longest prefers. Once a match is found no new starts are added and later
+// starts are dropped; the walk goes on while an equal or earlier start can
+// still make it longer.
+bool LineRegex::run(const char* line, size_t length, size_t from, bool firstOnly, size_t& start, size_t& end) const {
+    if (program.empty() || from > length) return false;
+    Scratch& s = scratch;
+    if (s.seen.size() < program.size()) s.seen.assign(program.size(), 0);
+    s.current.clear();
+
+    auto holds = [&](uint8_t assertion, size_t pos) {
+        bool before = pos > 0 && isWordByte((unsigned char)line[pos - 1]);
+        bool after = pos < length && isWordByte((unsigned char)line[pos]);
+        switch (assertion) {
+            case LINE_START: return pos == 0;
+            case LINE_END: return pos == length;
+            case WORD_BOUNDARY: return before != after;
+            case NOT_WORD_BOUNDARY: return before == after;
+            case WORD_START: return !before && after;
+            case WORD_END: return before && !after;
+        }
+        return false;
+    };
+
+    // Follows jumps, splits and assertions at `pos` without recursion
+    auto add = [&](std::vector<Thread>& list, uint64_t stamp, int32_t pc, size_t threadStart, size_t pos) {
+        s.stack.clear();
+        s.stack.push_back(pc);
+        while (!s.stack.empty()) {
+            int32_t at = s.stack.back();
+            s.stack.pop_back();
+            if (s.seen[at] == stamp) continue;
+            s.seen[at] = stamp;
+            const Op& op = program[at];
+            switch (op.type) {
+                case OpType::Jump:
+                    s.stack.push_back(op.x);
+                    break;
+                case OpType::Split:
+                    s.stack.push_back(op.y);
+                    s.stack.push_back(op.x);
+                    break;
+                case OpType::Assert:
+                    if (holds(op.arg, pos)) s.stack.push_back(at + 1);
+                    break;
+                default:
+                    list.push_back({at, threadStart});
+                    break;
+            }
+        }
+    };
+
+    const size_t none = std::string::npos;
+    size_t bestStart = none, bestEnd = 0;
+    uint64_t currentStamp = ++s.stamp;
+    for (size_t pos = from;; ++pos) {
+        if (bestStart == none) add(s.current, currentStamp, 0, pos, pos);
+        if (s.current.empty()) {
+            if (bestStart != none || pos >= length) break;
+            currentStamp = ++s.stamp;
+            continue;
+        }
+
+        uint64_t nextStamp = ++s.stamp;
+        s.next.clear();
+        for (const Thread& t : s.current) {
+            if (bestStart != none && t.start > bestStart) break;
+            const Op& op = program[t.pc];
+            if (op.type == OpType::Match) {
+                if (bestStart == none || t.start < bestStart || pos > bestEnd) {
+                    bestStart = t.start;
+                    bestEnd = pos;
+                }
+                if (firstOnly) break;
+                continue;
+            }
+            if (pos >= length) continue;
+            unsigned char c = line[pos];
+            if (op.type == OpType::Char ? c == op.arg : sets[op.x][c]) add(s.next, nextStamp, t.pc + 1, t.start, pos + 1);
+        }
+        if ((firstOnly && bestStart != none) || pos >= length) break;
+        std::swap(s.current, s.next);
+        currentStamp = nextStamp;
+    }
+
+    if (bestStart == none) return false;
+    start = bestStart;
+    end = bestEnd;
+    return true;
+}
@@ -1,8 +1,12 @@
 #include <iostream>
+#include <string>
+#include "daemon.h"
 #include "terminal.h"
 #include "utils.h"
 
-int main() {
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "--daemon") return runDaemon();
+
     try {
         Terminal terminal;
         terminal.run();
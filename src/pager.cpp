@@ -0,0 +1,728 @@
+#include "pager.h"
+#include "grep.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define MYTERM_PAGER_SSE2 1
+#endif
+
+#ifndef _WIN32
+    #include <poll.h>
+    #include <termios.h>
+    #include <unistd.h>
+    #ifdef __linux__
+        #include <sys/inotify.h>
+    #endif
+#endif
+
+namespace fs = std::filesystem;
+
+// Searches give the keyboard a chance (Ctrl-C, q) after this many bytes
+static const size_t SEARCH_WINDOW = 64 << 20;
+
+static const char* findLastNewline(const char* begin, size_t length) {
+    #ifdef __GLIBC__
+        return (const char*)memrchr(begin, '\n', length);
+    #else
+        for (size_t i = length; i-- > 0;) {
+            if (begin[i] == '\n') return begin + i;
+        }
+        return nullptr;
+    #endif
+}
+
+// --- LineIndex ------------------------------------------------------------
+
+void LineIndex::start(const char* newData, size_t newSize) {
+    stop();
+    data = newData;
+    size = newSize;
+    if (scanned.load() >= size) {
+        done.store(true, std::memory_order_release);
+        return;
+    }
+    done.store(false);
+    worker = std::thread(&LineIndex::run, this);
+}
+
+void LineIndex::stop() {
+    stopping.store(true);
+    if (worker.joinable()) worker.join();
+    stopping.store(false);
+}
+
+void LineIndex::reset() {
+    stop();
+    std::lock_guard<std::mutex> lock(mutex);
+    checkpoints.assign(1, 0);
+    scanned.store(0);
+    lines.store(0);
+    done.store(false);
+}
+
+void LineIndex::run() {
+    TRACE_SCOPE("LineIndex::run");
+    size_t pos = scanned.load();
+    size_t count = lines.load();
+    std::vector<uint64_t> found;
+    while (pos < size && !stopping.load(std::memory_order_relaxed)) {
+        size_t end = std::min(size, pos + CHUNK);
+        found.clear();
+        scan(pos, end, count, found);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            checkpoints.insert(checkpoints.end(), found.begin(), found.end());
+            lines.store(count, std::memory_order_release);
+            scanned.store(end, std::memory_order_release);
+        }
+        pos = end;
+    }
+    if (pos >= size) done.store(true, std::memory_order_release);
+}
+
+// Counts newlines in [begin, end) and records the start of every STRIDE-th
+// line. The vector loop only looks at individual bits when a checkpoint
+// falls inside the 16-byte block.
+void LineIndex::scan(size_t begin, size_t end, size_t& count, std::vector<uint64_t>& found) const {
+    size_t i = begin;
+    #ifdef MYTERM_PAGER_SSE2
+        const __m128i newline = _mm_set1_epi8('\n');
+        for (; i + 16 <= end; i += 16) {
+            __m128i block = _mm_loadu_si128((const __m128i*)(data + i));
+            unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+            if (!mask) continue;
+            size_t hits = (size_t)__builtin_popcount(mask);
+            if (hits < STRIDE - count % STRIDE) {
+                count += hits;
+                continue;
+            }
+            while (mask) {
+                unsigned bit = (unsigned)__builtin_ctz(mask);
+                mask &= mask - 1;
+                if (++count % STRIDE == 0) found.push_back(i + bit + 1);
+            }
+        }
+    #endif
+    while (i < end) {
+        const char* hit = (const char*)std::memchr(data + i, '\n', end - i);
+        if (!hit) break;
+        i = (size_t)(hit - data) + 1;
+        if (++count % STRIDE == 0) found.push_back(i);
+    }
+}
+
+size_t LineIndex::lineCount() const {
+    size_t count = newlines();
+    if (complete() && size > 0 && data[size - 1] != '\n') count++;
+    return count;
+}
+
+bool LineIndex::lineOf(size_t offset, size_t& line) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (offset > scanned.load(std::memory_order_relaxed)) return false;
+    size_t k = (size_t)(std::upper_bound(checkpoints.begin(), checkpoints.end(), (uint64_t)offset) - checkpoints.begin()) - 1;
+    line = k * STRIDE + (size_t)std::count(data + checkpoints[k], data + offset, '\n');
+    return true;
+}
+
+bool LineIndex::offsetOf(size_t line, size_t& offset) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (line > lines.load(std::memory_order_relaxed)) return false;
+    size_t pos = checkpoints[line / STRIDE];
+    for (size_t r = line % STRIDE; r > 0; --r) {
+        pos = (size_t)((const char*)std::memchr(data + pos, '\n', size - pos) - data) + 1;
+    }
+    offset = pos;
+    return true;
+}
+
+size_t LineIndex::memoryBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return checkpoints.capacity() * sizeof(uint64_t);
+}
+
+// --- Pager ----------------------------------------------------------------
+
+Pager::Pager(std::string path) : path(std::move(path)) {}
+
+Pager::~Pager() {
+    index.stop();
+}
+
+bool Pager::open() {
+    if (!file.open(path)) return false;
+    index.start(text(), textSize());
+    return true;
+}
+
+void Pager::setSize(int newRows, int newCols) {
+    rows = std::max(2, newRows);
+    cols = std::max(20, newCols);
+}
+
+size_t Pager::lineStart(size_t offset) const {
+    const char* hit = findLastNewline(text(), offset);
+    return hit ? (size_t)(hit - text()) + 1 : 0;
+}
+
+size_t Pager::nextLine(size_t offset) const {
+    if (offset >= textSize()) return textSize();
+    const char* hit = (const char*)std::memchr(text() + offset, '\n', textSize() - offset);
+    return hit ? (size_t)(hit - text()) + 1 : textSize();
+}
+
+// Top offset that puts the last line on the last text row
+size_t Pager::bottomTop() const {
+    size_t size = textSize();
+    if (size == 0) return 0;
+    size_t pos = text()[size - 1] == '\n' ? lineStart(size - 1) : lineStart(size);
+    for (int r = 1; r < rows - 1 && pos > 0; ++r) pos = lineStart(pos - 1);
+    return pos;
+}
+
+size_t Pager::screenEnd() const {
+    size_t pos = top;
+    for (int r = 0; r < rows - 1 && pos < textSize(); ++r) pos = nextLine(pos);
+    return pos;
+}
+
+void Pager::lineDown(size_t count) {
+    size_t line;
+    if (count > (size_t)rows * 4 && index.lineOf(top, line)) {
+        goToLine(line + 1 + count);
+        return;
+    }
+    size_t limit = bottomTop();
+    while (count-- > 0 && top < limit) top = nextLine(top);
+}
+
+void Pager::lineUp(size_t count) {
+    size_t line;
+    if (count > (size_t)rows * 4 && index.lineOf(top, line)) {
+        goToLine(line >= count ? line - count + 1 : 1);
+        return;
+    }
+    while (count-- > 0 && top > 0) top = lineStart(top - 1);
+}
+
+void Pager::goToLine(size_t line) {
+    size_t target = line > 0 ? line - 1 : 0;
+    size_t offset = 0;
+    while (!index.offsetOf(target, offset)) {
+        if (index.complete()) {
+            goBottom();
+            return;
+        }
+        if (interrupted()) return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    top = std::min(offset, bottomTop());
+}
+
+void Pager::goToPercent(size_t percent) {
+    percent = std::min<size_t>(percent, 100);
+    size_t offset = (size_t)((double)textSize() * percent / 100);
+    top = std::min(lineStart(offset), bottomTop());
+}
+
+// --- Search ---------------------------------------------------------------
+
+bool Pager::search(const std::string& pattern, bool forward) {
+    if (!pattern.empty()) {
+        GrepOptions options;
+        options.extended = true;
+        // Smart case: only a pattern with capitals is case sensitive
+        options.ignoreCase = std::none_of(pattern.begin(), pattern.end(), [](unsigned char c) { return std::isupper(c); });
+        auto compiled = std::make_unique<GrepMatcher>(pattern, options);
+        if (!compiled->valid()) {
+            message = "Patron invalido: " + compiled->errorMessage();
+            return false;
+        }
+        matcher = std::move(compiled);
+        lastMatch = SIZE_MAX;
+    }
+    lastForward = forward;
+    return runSearch(forward);
+}
+
+bool Pager::searchAgain(bool reverse) {
+    return runSearch(reverse ? !lastForward : lastForward);
+}
+
+bool Pager::runSearch(bool forward) {
+    TRACE_SCOPE("Pager::search");
+    if (!matcher) {
+        message = "No hay patron anterior";
+        return false;
+    }
+    // A match near the end may sit below the top line; continue after it
+    size_t from = nextLine(top);
+    if (lastMatch != SIZE_MAX && lastMatch >= top && lastMatch < screenEnd()) from = std::max(from, nextLine(lastMatch));
+
+    size_t found = 0;
+    if (!(forward ? findForward(from, found) : findBackward(top, found))) {
+        if (message.empty()) message = "Patron no encontrado";
+        return false;
+    }
+    lastMatch = found;
+    top = std::min(found, bottomTop());
+    return true;
+}
+
+bool Pager::findForward(size_t from, size_t& found) {
+    const char* data = text();
+    size_t size = textSize();
+    size_t pos = from;
+    while (pos < size) {
+        size_t limit = nextLine(std::min(size, pos + SEARCH_WINDOW));
+        size_t candidate = matcher->nextCandidate(data, limit, pos);
+        if (candidate == std::string::npos) {
+            pos = limit;
+            if (interrupted()) return false;
+            continue;
+        }
+        size_t end = nextLine(candidate);
+        size_t length = end - candidate - (end > candidate && data[end - 1] == '\n' ? 1 : 0);
+        if (matcher->matchLine(data + candidate, length, nullptr)) {
+            found = candidate;
+            return true;
+        }
+        pos = end;
+    }
+    return false;
+}
+
+// Scans windows backwards from `before`, forward within each window, keeping
+// the last match
+bool Pager::findBackward(size_t before, size_t& found) {
+    const char* data = text();
+    size_t end = before;
+    while (end > 0) {
+        size_t begin = lineStart(end > SEARCH_WINDOW ? end - SEARCH_WINDOW : 0);
+        bool any = false;
+        size_t pos = begin;
+        while (pos < end) {
+            size_t candidate = matcher->nextCandidate(data, end, pos);
+            if (candidate == std::string::npos) break;
+            const char* newline = (const char*)std::memchr(data + candidate, '\n', end - candidate);
+            size_t lineEnd = newline ? (size_t)(newline - data) : end;
+            if (matcher->matchLine(data + candidate, lineEnd - candidate, nullptr)) {
+                found = candidate;
+                any = true;
+            }
+            pos = lineEnd + 1;
+        }
+        if (any) return true;
+        if (interrupted()) return false;
+        end = begin;
+    }
+    return false;
+}
+
+// Ctrl-C or q pressed during a long search or wait
+bool Pager::interrupted() {
+    #ifdef _WIN32
+        return false;
+    #else
+        if (!interactive) return false;
+        struct pollfd pfd = {STDIN_FILENO, POLLIN, 0};
+        char c = 0;
+        if (poll(&pfd, 1, 0) <= 0 || read(STDIN_FILENO, &c, 1) != 1) return false;
+        if (c != 3 && c != 'q') return false;
+        message = "Interrumpido";
+        return true;
+    #endif
+}
+
+// --- Rendering ------------------------------------------------------------
+
+static size_t digits(size_t n) {
+    size_t d = 1;
+    while (n >= 10) {
+        n /= 10;
+        d++;
+    }
+    return d;
+}
+
+void Pager::render(std::string& out) const {
+    TRACE_SCOPE("Pager::render");
+    out.clear();
+    out += "\033[H";
+    size_t firstLine = 0;
+    bool numbered = index.lineOf(top, firstLine);
+    int textRows = rows - 1;
+    int gutter = (int)std::max<size_t>(4, digits(firstLine + textRows));
+    int width = std::max(1, cols - gutter - 3);
+
+    size_t pos = top;
+    size_t shown = 0;
+    char number[32];
+    for (int r = 0; r < textRows; ++r) {
+        if (pos < textSize()) {
+            size_t next = nextLine(pos);
+            size_t end = next > pos && text()[next - 1] == '\n' ? next - 1 : next;
+            if (numbered) std::snprintf(number, sizeof(number), "%*zu | ", gutter, firstLine + shown + 1);
+            else std::snprintf(number, sizeof(number), "%*s | ", gutter, "");
+            out += Colors::BRIGHT_BLACK;
+            out += number;
+            out += Colors::RESET;
+            renderLine(out, pos, end, width);
+            pos = next;
+            shown++;
+        } else {
+            out += Colors::BRIGHT_BLACK + "~" + Colors::RESET;
+        }
+        out += "\033[K\r\n";
+    }
+    renderStatus(out, pos, numbered, firstLine, shown);
+}
+
+// One line chopped to `width` columns: tabs expanded, control characters as
+// ^X, search matches in reverse video
+void Pager::renderLine(std::string& out, size_t begin, size_t end, int width) const {
+    const char* line = text() + begin;
+    size_t length = end - begin;
+    if (length > 0 && line[length - 1] == '\r') length--;
+
+    std::vector<std::pair<size_t, size_t>> spans;
+    if (matcher) matcher->matchLine(line, std::min<size_t>(length, 64 << 10), &spans);
+    size_t span = 0;
+    bool highlighted = false;
+
+    int column = 0;
+    for (size_t i = 0; i < length; ++i) {
+        unsigned char c = (unsigned char)line[i];
+        bool continuation = (c & 0xC0) == 0x80;
+        if (!continuation && column >= width) break;
+
+        while (span < spans.size() && spans[span].second <= i) span++;
+        bool inside = span < spans.size() && spans[span].first <= i;
+        if (inside != highlighted) {
+            out += inside ? "\033[7m" : "\033[27m";
+            highlighted = inside;
+        }
+
+        if (c == '\t') {
+            int next = std::min(width, (column / 8 + 1) * 8);
+            out.append((size_t)(next - column), ' ');
+            column = next;
+        } else if (c < 32 || c == 127) {
+            out += '^';
+            out += (char)(c == 127 ? '?' : c + 64);
+            column += 2;
+        } else {
+            out += (char)c;
+            if (!continuation) column++;
+        }
+    }
+    if (highlighted) out += "\033[27m";
+}
+
+void Pager::renderStatus(std::string& out, size_t end, bool numbered, size_t firstLine, size_t shown) const {
+    std::string status = " " + path;
+    if (numbered && shown > 0) {
+        status += "  lineas " + std::to_string(firstLine + 1) + "-" + std::to_string(firstLine + shown);
+        if (index.complete()) status += "/" + std::to_string(index.lineCount());
+    }
+    size_t size = textSize();
+    if (end >= size) status += "  (FIN)";
+    else status += "  " + std::to_string(size ? (size_t)((double)end * 100 / size) : 100) + "%";
+    if (!index.complete()) {
+        status += "  indexando " + std::to_string(size ? (size_t)((double)index.indexedBytes() * 100 / size) : 100) + "%";
+    }
+    if (following) status += "  Esperando datos... (cualquier tecla para salir)";
+    else if (!message.empty()) status += "  " + message;
+    if (!pending.empty()) status += "  :" + pending;
+
+    if (status.size() > (size_t)cols) status.resize((size_t)cols);
+    else status.append((size_t)cols - status.size(), ' ');
+    out += "\033[7m" + status + "\033[0m\033[K";
+}
+
+// --- Follow mode ----------------------------------------------------------
+
+// A mapping faults (SIGBUS) on pages a truncation cut off, e.g. logrotate's
+// copytruncate, and a followed file is the one likely to get one. Follow
+// mode moves to a copy of the file and from then on reads only what was
+// appended, or everything again after a truncation.
+bool Pager::reload() {
+    std::error_code ec;
+    size_t size = (size_t)fs::file_size(path, ec);
+    bool toCopy = following && !copied;
+    if (ec || (size == textSize() && !toCopy)) return false;
+
+    index.stop();
+    size_t previous = textSize();
+    if (following || copied) {
+        if (!readCopy(toCopy || size < previous ? 0 : previous)) {
+            index.start(text(), textSize());
+            return false;
+        }
+        copied = true;
+        file.close();
+    } else if (!file.open(path)) {
+        return false;
+    }
+    bool truncated = textSize() < previous;
+    if (truncated || index.indexedBytes() > textSize()) {
+        index.reset();
+        top = lineStart(std::min(top, textSize()));
+        lastMatch = SIZE_MAX;
+    }
+    index.start(text(), textSize());
+    return true;
+}
+
+// Reads the file from `from` on into the copy, keeping [0, from)
+bool Pager::readCopy(size_t from) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    size_t size = (size_t)in.tellg();
+    if (size < from) from = 0; // truncated again since the size was read
+    in.seekg((std::streamoff)from);
+    std::string data = from ? std::move(copy) : std::string();
+    data.resize(size);
+    in.read(&data[from], (std::streamsize)(size - from));
+    if (in.bad()) return false;
+    data.resize(from + (size_t)in.gcount());
+    copy = std::move(data);
+    return true;
+}
+
+// --- Interactive loop -----------------------------------------------------
+
+#ifndef _WIN32
+
+enum {
+    KEY_NONE = -1,
+    KEY_UP = 256,
+    KEY_DOWN,
+    KEY_PAGE_UP,
+    KEY_PAGE_DOWN,
+    KEY_HOME,
+    KEY_END,
+};
+
+// One key, with arrow/paging escape sequences decoded; KEY_NONE on timeout
+int Pager::readKey(int timeoutMs) {
+    struct pollfd pfd = {STDIN_FILENO, POLLIN, 0};
+    if (poll(&pfd, 1, timeoutMs) <= 0) return KEY_NONE;
+    unsigned char c = 0;
+    if (read(STDIN_FILENO, &c, 1) != 1) return 'q';
+    if (c != 27) return c;
+
+    char seq[8];
+    ssize_t n = 0;
+    if (poll(&pfd, 1, 30) > 0) n = read(STDIN_FILENO, seq, sizeof(seq));
+    std::string s(seq, (size_t)std::max<ssize_t>(n, 0));
+    if (s == "[A" || s == "OA") return KEY_UP;
+    if (s == "[B" || s == "OB") return KEY_DOWN;
+    if (s == "[5~") return KEY_PAGE_UP;
+    if (s == "[6~") return KEY_PAGE_DOWN;
+    if (s == "[H" || s == "OH" || s == "[1~" || s == "[7~") return KEY_HOME;
+    if (s == "[F" || s == "OF" || s == "[4~" || s == "[8~") return KEY_END;
+    return 27;
+}
+
+// Line editor on the status row for / and ?; false if cancelled
+bool Pager::readPrompt(const std::string& prefix, std::string& text) {
+    text.clear();
+    while (true) {
+        std::string line = "\033[" + std::to_string(rows) + ";1H\033[K" + prefix + text + "\033[?25h";
+        if (write(STDOUT_FILENO, line.data(), line.size()) < 0) return false;
+        int key = readKey(-1);
+        if (key == '\r' || key == '\n') break;
+        if (key == 27 || key == 3) {
+            text.clear();
+            break;
+        }
+        if (key == 127 || key == 8) {
+            if (text.empty()) break;
+            text.pop_back();
+        } else if (key >= 32 && key < 256) {
+            text += (char)key;
+        }
+    }
+    const char hide[] = "\033[?25l";
+    if (write(STDOUT_FILENO, hide, sizeof(hide) - 1) < 0) return false;
+    return !text.empty();
+}
+
+void Pager::draw() {
+    setSize(getTerminalHeight(), getTerminalWidth());
+    std::string screen;
+    render(screen);
+    size_t written = 0;
+    while (written < screen.size()) {
+        ssize_t n = write(STDOUT_FILENO, screen.data() + written, screen.size() - written);
+        if (n <= 0) break;
+        written += (size_t)n;
+    }
+}
+
+// Like tail -f: stays at the end, woken by inotify (or a short poll where
+// it isn't available), until a key is pressed
+void Pager::follow() {
+    following = true;
+    reload();
+    goBottom();
+    int watch = -1;
+    #ifdef __linux__
+        watch = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (watch >= 0 && inotify_add_watch(watch, path.c_str(), IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE) < 0) {
+            ::close(watch);
+            watch = -1;
+        }
+    #endif
+    while (true) {
+        draw();
+        struct pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {watch, POLLIN, 0}};
+        int ready = poll(fds, watch >= 0 ? 2 : 1, watch >= 0 ? 1000 : 250);
+        if (ready > 0 && (fds[0].revents & POLLIN)) {
+            readKey(0);
+            break;
+        }
+        if (ready > 0 && watch >= 0 && (fds[1].revents & POLLIN)) {
+            char events[4096];
+            while (read(watch, events, sizeof(events)) > 0) {}
+        }
+        if (reload()) goBottom();
+    }
+    if (watch >= 0) ::close(watch);
+    following = false;
+}
+
+int Pager::run() {
+    if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)) {
+        // Not a terminal: behave like cat
+        fwrite(text(), 1, textSize(), stdout);
+        fflush(stdout);
+        return 0;
+    }
+
+    struct termios saved, raw;
+    tcgetattr(STDIN_FILENO, &saved);
+    raw = saved;
+    raw.c_lflag &= ~(ICANON | ECHO | ISIG);
+    raw.c_iflag &= ~(IXON | ICRNL);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+    fflush(stdout);
+    const char enter[] = "\033[?1049h\033[?25l";
+    if (write(STDOUT_FILENO, enter, sizeof(enter) - 1) < 0) return 1;
+    interactive = true;
+
+    int shownRows = 0, shownCols = 0;
+    size_t shownIndexed = SIZE_MAX;
+    bool dirty = true;
+    std::string text;
+    while (true) {
+        if (getTerminalHeight() != shownRows || getTerminalWidth() != shownCols) dirty = true;
+        if (index.indexedBytes() != shownIndexed) dirty = true;
+        if (dirty) {
+            draw();
+            shownRows = rows;
+            shownCols = cols;
+            shownIndexed = index.indexedBytes();
+            dirty = false;
+        }
+
+        // Wake up now and then while indexing to refresh the status line
+        int key = readKey(index.complete() ? 500 : 200);
+        if (key == KEY_NONE) continue;
+        dirty = true;
+        if (key >= '0' && key <= '9') {
+            if (pending.size() < 18) pending += (char)key;
+            continue;
+        }
+        message.clear();
+        bool hasCount = !pending.empty();
+        size_t count = hasCount ? std::stoull(pending) : 0;
+        pending.clear();
+        size_t page = (size_t)std::max(1, rows - 1);
+
+        switch (key) {
+            case 'q': case 'Q': case 3:
+                goto done;
+            case 'j': case 'e': case '\r': case '\n': case KEY_DOWN:
+                lineDown(hasCount ? count : 1);
+                break;
+            case 'k': case 'y': case KEY_UP:
+                lineUp(hasCount ? count : 1);
+                break;
+            case ' ': case 'f': case 6: case KEY_PAGE_DOWN:
+                lineDown(hasCount ? count : page);
+                break;
+            case 'b': case 2: case KEY_PAGE_UP:
+                lineUp(hasCount ? count : page);
+                break;
+            case 'd': case 4:
+                lineDown(page / 2);
+                break;
+            case 'u': case 21:
+                lineUp(page / 2);
+                break;
+            case 'g': case '<': case KEY_HOME:
+                if (hasCount) goToLine(count);
+                else goTop();
+                break;
+            case 'G': case '>': case KEY_END:
+                if (hasCount) goToLine(count);
+                else goBottom();
+                break;
+            case 'p': case '%':
+                goToPercent(count);
+                break;
+            case '/': case '?':
+                if (readPrompt(std::string(1, (char)key), text)) search(text, key == '/');
+                break;
+            case 'n': case 'N':
+                for (size_t i = 0; i < (hasCount ? count : 1); ++i) {
+                    if (!searchAgain(key == 'N')) break;
+                }
+                break;
+            case 'F':
+                follow();
+                break;
+            case 'r': case 12: {
+                const char clear[] = "\033[2J";
+                if (write(STDOUT_FILENO, clear, sizeof(clear) - 1) < 0) goto done;
+                break;
+            }
+            case 'h': case 'H':
+                message = "j/k lineas  espacio/b paginas  g/G inicio/fin  Ng linea  Np %  / ? n N buscar  F seguir  q salir";
+                break;
+            default:
+                break;
+        }
+    }
+
+done:
+    interactive = false;
+    const char leave[] = "\033[?25h\033[?1049l";
+    if (write(STDOUT_FILENO, leave, sizeof(leave) - 1) < 0) {}
+    tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+    return 0;
+}
+
+#else
+
+// No raw terminal handling here: print the file like cat
+int Pager::run() {
+    fwrite(text(), 1, textSize(), stdout);
+    fflush(stdout);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,84 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+
+CommandTimer::CommandTimer()
+    : start(std::chrono::steady_clock::now()), selfStart(getSelfUsage()) {}
+
+CommandRecord CommandTimer::finish(std::string_view name, int exitStatus, const ResourceUsage& childUsage) const {
+    ResourceUsage selfEnd = getSelfUsage();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    CommandRecord rec;
+    size_t len = std::min(name.size(), sizeof(rec.name) - 1);
+    std::memcpy(rec.name, name.data(), len);
+    rec.name[len] = '\0';
+    rec.wallNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    rec.userMicros = selfEnd.userMicros - selfStart.userMicros + childUsage.userMicros;
+    rec.sysMicros = selfEnd.sysMicros - selfStart.sysMicros + childUsage.sysMicros;
+    rec.maxRssKb = childUsage.maxRssKb > 0 ? childUsage.maxRssKb : -1;
+    rec.exitStatus = exitStatus;
+    return rec;
+}
+
+// Nearest-rank percentile over an already sorted vector
+static int64_t percentile(const std::vector<int64_t>& sorted, int pct) {
+    size_t rank = (sorted.size() * pct + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+std::vector<CommandSummary> CommandStats::summarize() const {
+    std::map<std::string, std::vector<const CommandRecord*>> byName;
+    std::vector<CommandRecord> all = records.snapshot();
+    for (const auto& rec : all) byName[rec.name].push_back(&rec);
+
+    std::vector<CommandSummary> summaries;
+    std::vector<int64_t> walls;
+    for (const auto& [name, recs] : byName) {
+        CommandSummary s;
+        s.name = name;
+        s.count = recs.size();
+
+        walls.clear();
+        int64_t user = 0, sys = 0;
+        for (const CommandRecord* rec : recs) {
+            walls.push_back(rec->wallNanos);
+            s.totalNanos += rec->wallNanos;
+            user += rec->userMicros;
+            sys += rec->sysMicros;
+            s.maxRssKb = std::max(s.maxRssKb, rec->maxRssKb);
+            if (rec->exitStatus != 0) s.failures++;
+        }
+        std::sort(walls.begin(), walls.end());
+        s.p50Nanos = percentile(walls, 50);
+        s.p90Nanos = percentile(walls, 90);
+        s.p99Nanos = percentile(walls, 99);
+        s.maxNanos = walls.back();
+        s.avgUserMicros = user / (int64_t)s.count;
+        s.avgSysMicros = sys / (int64_t)s.count;
+        summaries.push_back(s);
+    }
+
+    std::sort(summaries.begin(), summaries.end(), [](const CommandSummary& a, const CommandSummary& b) {
+        return a.totalNanos > b.totalNanos;
+    });
+    return summaries;
+}
+
+std::string formatDuration(int64_t nanos) {
+    char buf[32];
+    if (nanos < 1000000) {
+        snprintf(buf, sizeof(buf), "%lldus", (long long)(nanos / 1000));
+    } else if (nanos < 1000000000) {
+        snprintf(buf, sizeof(buf), "%.1fms", nanos / 1e6);
+    } else if (nanos < 60LL * 1000000000) {
+        snprintf(buf, sizeof(buf), "%.2fs", nanos / 1e9);
+    } else {
+        long long secs = nanos / 1000000000;
+        snprintf(buf, sizeof(buf), "%lldm%02llds", secs / 60, secs % 60);
+    }
+    return buf;
+}
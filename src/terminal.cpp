@@ -2,11 +2,16 @@
 #include "commands.h"
 #include "ui.h"
 #include "utils.h"
+#include "trace.h"
+#include "glob.h"
+#include "git_status.h"
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <filesystem>
 #include <fstream>
+#include <ctime>
 
 #ifdef _WIN32
     #include <windows.h>
@@ -32,12 +37,126 @@ Terminal::Terminal() {
     initializeTerminal();
     currentPath = fs::current_path().string();
     previousPath = currentPath;
+    // Without a daemon this fails at once and everything below runs standalone
+    daemonClient.connect();
+    lastDaemonAttempt = std::time(nullptr);
     getUserInfo();
     showGitBranch = true;
     initializeThemes();
+    std::string home = getHomeDirectory();
+    if (!home.empty()) {
+        dirIndex.load((fs::path(home) / ".myterm_dirs").string());
+        historyFile = (fs::path(home) / ".myterm_history").string();
+        configFile = (fs::path(home) / ".myterm.conf").string();
+    }
+    const char* customConfig = getenv("MYTERM_CONFIG");
+    if (customConfig && *customConfig) configFile = customConfig;
+    applyConfig();
+    configWatcher.watch(configFile);
+    loadHistory();
     signal(SIGINT, signalHandler);
 }
 
+void Terminal::recordDirectory(const std::string& path) {
+    // Like zoxide, home is always one "cd" away and not worth ranking
+    if (path == getHomeDirectory()) return;
+    dirIndex.add(path, (int64_t)std::time(nullptr));
+    // Also saved on exit; this bounds what a crash or a closed window loses
+    if (dirIndex.pendingChanges() >= FrecencyIndex::SAVE_EVERY) dirIndex.save();
+}
+
+void Terminal::loadHistory() {
+    if (daemonClient.loadHistory(config.historySize, commandHistory)) return;
+    if (historyFile.empty()) return;
+    compactHistoryFile(historyFile, config.historySize);
+    readHistoryFile(historyFile, config.historySize, commandHistory);
+}
+
+void Terminal::addToHistory(const std::string& line) {
+    if (!commandHistory.empty() && commandHistory.back() == line) return;
+    commandHistory.push_back(line);
+    if (commandHistory.size() > config.historySize) commandHistory.erase(commandHistory.begin());
+    if (daemonClient.appendHistory(line)) return;
+    unsavedHistory.push_back(line);
+    if (unsavedHistory.size() >= HISTORY_SAVE_EVERY) saveHistory();
+}
+
+void Terminal::saveHistory() {
+    if (!historyFile.empty()) appendHistoryFile(historyFile, unsavedHistory);
+    unsavedHistory.clear();
+}
+
+// The file on top of the built-in themes. Problems are reported and the line
+// skipped; a broken prompt falls back to the default one.
+void Terminal::applyConfig() {
+    std::string previousTheme = config.theme;
+    config = Config();
+    if (!configFile.empty()) loadConfig(configFile, config);
+    for (const std::string& error : config.errors) {
+        std::cout << Colors::YELLOW << "Aviso: " << configFile << ", " << error << Colors::RESET << std::endl;
+    }
+
+    Theme active = currentTheme;
+    themes.clear();
+    initializeThemes();
+    currentTheme = active;
+    for (const auto& [name, theme] : config.themes) themes[name] = theme;
+    // A `theme` command wins until the file names another theme
+    if (!config.theme.empty() && (themeFromConfig || config.theme != previousTheme)) {
+        auto it = themes.find(config.theme);
+        if (it != themes.end()) {
+            currentTheme = it->second;
+            themeFromConfig = true;
+        } else {
+            std::cout << Colors::YELLOW << "Aviso: " << configFile << ", el tema '" << config.theme << "' no existe" << Colors::RESET << std::endl;
+        }
+    }
+
+    if (commandHistory.size() > config.historySize) {
+        commandHistory.erase(commandHistory.begin(), commandHistory.end() - config.historySize);
+    }
+    dirIndex.setMaxAge(config.dirMaxAge > 0 ? config.dirMaxAge : FrecencyIndex::DEFAULT_MAX_AGE);
+    compilePrompt();
+}
+
+void Terminal::compilePrompt() {
+    std::string error;
+    if (prompt.compile(config.prompt, currentTheme, error)) return;
+    std::cout << Colors::YELLOW << "Aviso: " << configFile << ", prompt: " << error << Colors::RESET << std::endl;
+    config.prompt = PromptTemplate::DEFAULT;
+    prompt.compile(config.prompt, currentTheme, error);
+}
+
+void Terminal::reloadConfig() {
+    applyConfig();
+    std::cout << Colors::BRIGHT_BLACK << "Configuracion recargada" << Colors::RESET << std::endl;
+}
+
+void Terminal::setCurrentTheme(const Theme& theme) {
+    currentTheme = theme;
+    themeFromConfig = false;
+    compilePrompt();
+}
+
+std::map<std::string, std::string> Terminal::getAliases() const {
+    std::map<std::string, std::string> all = config.aliases;
+    for (const auto& [name, value] : sessionAliases) all[name] = value;
+    return all;
+}
+
+// Textual, as in bash: the first word is replaced once and the rest of the
+// line kept, so an alias can add arguments, pipes or redirections
+std::string Terminal::expandAlias(const std::string& input) const {
+    size_t end = input.find_first_of(" \t");
+    std::string word = input.substr(0, end);
+    const std::string* value = nullptr;
+    auto session = sessionAliases.find(word);
+    if (session != sessionAliases.end()) value = &session->second;
+    else if (auto it = config.aliases.find(word); it != config.aliases.end()) value = &it->second;
+    if (!value) return input;
+    return *value + (end == std::string::npos ? std::string() : input.substr(end));
+}
+
 void Terminal::signalHandler(int signum) {
     if (signum == SIGINT && instance) {
         std::cout << "\n";
@@ -48,6 +167,7 @@ void Terminal::signalHandler(int signum) {
 }
 
 void Terminal::getUserInfo() {
+    if (daemonClient.userInfo(userName, computerName)) return;
     #ifdef _WIN32
         char* user = getenv("USERNAME");
         char* computer = getenv("COMPUTERNAME");
@@ -84,119 +204,166 @@ std::string Terminal::getRelativePath() {
 }
 
 std::string Terminal::getGitBranch() {
+    TRACE_SCOPE("getGitBranch");
     if (!showGitBranch) return "";
-    
-    fs::path current_dir = fs::current_path();
-    fs::path git_dir;
 
-    while (true) {
-        if (fs::exists(current_dir / ".git")) {
-            git_dir = current_dir / ".git";
-            break;
-        }
-        if (current_dir.has_parent_path() && current_dir != current_dir.parent_path()) {
-            current_dir = current_dir.parent_path();
-        } else {
-            break;
-        }
+    std::string cwd = fs::current_path().string();
+    GitStatus status;
+    bool found = false;
+    if (!daemonClient.gitStatus(cwd, found, status)) {
+        GitRepository repo;
+        found = findGitRepository(cwd, repo) && readGitStatus(repo, status);
     }
+    if (!found) return "";
+
+    // " (main +2 ~3 ?1 ^1 v2 | REBASE)": staged, modified, untracked, ahead, behind
+    std::string segment = " (" + status.branch;
+    if (status.staged) segment += " +" + std::to_string(status.staged);
+    if (status.modified) segment += " ~" + std::to_string(status.modified);
+    if (status.untracked) segment += " ?" + std::to_string(status.untracked);
+    if (status.truncated) segment += "+";
+    if (status.ahead) segment += " ^" + std::to_string(status.ahead) + (status.aheadBehindApprox ? "+" : "");
+    if (status.behind) segment += " v" + std::to_string(status.behind) + (status.aheadBehindApprox ? "+" : "");
+    if (!status.state.empty()) segment += " | " + status.state;
+    return segment + ")";
+}
 
-    if (git_dir.empty()) return "";
-
-    std::string branch_name;
-    try {
-        fs::path head_file_path = git_dir / "HEAD";
-        std::ifstream headFile(head_file_path);
-        if (headFile.is_open()) {
-            std::string line;
-            std::getline(headFile, line);
-            headFile.close();
-            if (line.rfind("ref: refs/heads/", 0) == 0) {
-                branch_name = line.substr(16);
-            }
+// Called once per command: redraws while editing reuse the cached segment
+void Terminal::refreshPromptInfo() {
+    if (configWatcher.changed()) reloadConfig();
+    // Picks up a daemon started after this session (or restarted)
+    if (!daemonClient.connected()) {
+        std::time_t now = std::time(nullptr);
+        if (now - lastDaemonAttempt >= 5) {
+            lastDaemonAttempt = now;
+            daemonClient.connect();
         }
-    } catch (...) {}
-
-    if (branch_name.empty()) return ""; // Si no se encontró rama (o no es un repo git), no mostrar nada
-
-    std::string state;
-    if (fs::exists(git_dir / "rebase-merge") || fs::exists(git_dir / "rebase-apply")) {
-        state = " | REBASE";
-    } else if (fs::exists(git_dir / "MERGE_HEAD")) {
-        state = " | MERGE";
     }
-
-    return " (" + branch_name + state + ")";
+    gitSegment = getGitBranch();
 }
 
 void Terminal::showPrompt() {
-    ::showPrompt(*this, getRelativePath(), getGitBranch());
+    TRACE_SCOPE("showPrompt");
+    std::string duration;
+    if (showLastDuration) {
+        if (const CommandRecord* last = stats.last()) duration = " [" + formatDuration(last->wallNanos) + "]";
+    }
+    std::string path = getRelativePath();
+    PromptTemplate::Slots slots;
+    slots[PromptTemplate::USER] = userName;
+    slots[PromptTemplate::HOST] = computerName;
+    slots[PromptTemplate::PATH] = path;
+    slots[PromptTemplate::GIT] = gitSegment;
+    slots[PromptTemplate::DURATION] = duration;
+    ::showPrompt(prompt, slots, promptBuffer);
 }
 
-std::vector<std::string> Terminal::splitCommand(const std::string& command) {
-    std::vector<std::string> tokens;
-    std::string current_token;
-    bool in_quotes = false;
+const std::vector<std::string_view>& Terminal::splitCommand(std::string_view command) {
+    TRACE_SCOPE("splitCommand");
+    return tokenizer.tokenize(command);
+}
 
-    for (char c : command) {
-        if (c == ' ' && !in_quotes) {
-            if (!current_token.empty()) {
-                tokens.push_back(current_token);
-                current_token.clear();
-            }
-        } else if (c == '"') {
-            in_quotes = !in_quotes;
-        } else {
-            current_token += c;
-        }
+// Replaces glob words by their sorted matches; a pattern without matches is
+// kept as a literal word, like bash does by default
+const std::vector<std::string_view>& Terminal::expandGlobs(const std::vector<std::string_view>& tokens) {
+    if (!tokenizer.hasGlobs()) return tokens;
+    TRACE_SCOPE("expandGlobs");
+
+    globStorage.clear();
+    std::vector<size_t> produced(tokens.size(), 0);
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        if (!tokenizer.isGlob(i)) continue;
+        std::vector<std::string> matches = GlobPattern(tokens[i]).expand();
+        if (matches.empty()) matches.push_back(unescapeGlob(tokens[i]));
+        produced[i] = matches.size();
+        for (auto& match : matches) globStorage.push_back(std::move(match));
     }
 
-    if (!current_token.empty()) {
-        tokens.push_back(current_token);
+    // Views are taken once globStorage has stopped growing
+    expandedTokens.clear();
+    size_t next = 0;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        if (!tokenizer.isGlob(i)) {
+            expandedTokens.push_back(tokens[i]);
+            continue;
+        }
+        for (size_t k = 0; k < produced[i]; ++k) expandedTokens.push_back(globStorage[next++]);
     }
-
-    return tokens;
+    return expandedTokens;
 }
 
-void Terminal::executeCommand(const std::vector<std::string>& tokens, const std::string& originalCommand) {
+void Terminal::executeCommand(const std::vector<std::string_view>& tokens, const std::string& originalCommand) {
     if (tokens.empty()) return;
-    
-    std::string cmd = tokens[0];
-    
-    if (cmd == "help") showHelp();
-    else if (cmd == "ls" || cmd == "dir") listDirectory(*this, tokens);
-    else if (cmd == "cd") changeDirectory(*this, tokens.size() > 1 ? tokens[1] : "~");
-    else if (cmd == "pwd") std::cout << Colors::BRIGHT_BLUE << currentPath << Colors::RESET << std::endl;
-    else if (cmd == "mkdir") {
-        if (tokens.size() > 1) makeDirectory(tokens[1]);
-        else std::cout << Colors::RED << "Error: Especifique el nombre del directorio" << Colors::RESET << std::endl;
-    }
-    else if (cmd == "rmdir") {
-        if (tokens.size() > 1) removeDirectory(tokens[1]);
-        else std::cout << Colors::RED << "Error: Especifique el nombre del directorio" << Colors::RESET << std::endl;
-    }
-    else if (cmd == "touch") {
-        if (tokens.size() > 1) createFile(tokens[1]);
-        else std::cout << Colors::RED << "Error: Especifique el nombre del archivo" << Colors::RESET << std::endl;
+    TRACE_SCOPE("executeCommand");
+
+    CommandTimer timer;
+    ResourceUsage childUsage;
+    int status = dispatchCommand(tokens, originalCommand, childUsage);
+    stats.record(timer.finish(tokens[0], status, childUsage));
+}
+
+// mkdir, rm, cat...: one call per argument, failing if any of them failed
+static int forEachArgument(const std::vector<std::string_view>& tokens, int (*fn)(const std::string&), const char* missing) {
+    if (tokens.size() < 2) {
+        std::cout << Colors::RED << missing << Colors::RESET << std::endl;
+        return 1;
     }
-    else if (cmd == "rm") {
-        if (tokens.size() > 1) removeFile(tokens[1]);
-        else std::cout << Colors::RED << "Error: Especifique el nombre del archivo" << Colors::RESET << std::endl;
+    int status = 0;
+    for (size_t i = 1; i < tokens.size(); ++i) {
+        if (fn(std::string(tokens[i])) != 0) status = 1;
     }
-    else if (cmd == "cat") {
-        if (tokens.size() > 1) showFileContent(tokens[1]);
-        else std::cout << Colors::RED << "Error: Especifique el nombre del archivo" << Colors::RESET << std::endl;
+    return status;
+}
+
+int Terminal::dispatchCommand(const std::vector<std::string_view>& tokens, const std::string& originalCommand, ResourceUsage& childUsage) {
+    std::string_view cmd = tokens[0];
+    
+    if (cmd == "help") showHelp();
+    else if (cmd == "ls" || cmd == "dir") return listDirectory(*this, tokens);
+    else if (cmd == "cd") {
+        if (tokens.size() > 2) return jumpDirectory(*this, tokens);
+        return changeDirectory(*this, tokens.size() > 1 ? std::string(tokens[1]) : "~");
     }
+    else if (cmd == "j") return jumpDirectory(*this, tokens);
+    else if (cmd == "pushd") return pushDirectory(*this, tokens);
+    else if (cmd == "popd") return popDirectory(*this);
+    else if (cmd == "dirs") showDirectoryStack(*this, tokens);
+    else if (cmd == "pwd") std::cout << Colors::BRIGHT_BLUE << currentPath << Colors::RESET << std::endl;
+    else if (cmd == "mkdir") return forEachArgument(tokens, makeDirectory, "Error: Especifique el nombre del directorio");
+    else if (cmd == "rmdir") return forEachArgument(tokens, removeDirectory, "Error: Especifique el nombre del directorio");
+    else if (cmd == "touch") return forEachArgument(tokens, createFile, "Error: Especifique el nombre del archivo");
+    else if (cmd == "rm") return forEachArgument(tokens, removeFile, "Error: Especifique el nombre del archivo");
+    else if (cmd == "cat") return forEachArgument(tokens, showFileContent, "Error: Especifique el nombre del archivo");
     else if (cmd == "clear" || cmd == "cls") clearScreen();
-    else if (cmd == "git") executeGitCommand(tokens);
+    else if (cmd == "git") return executeGitCommand(tokens, &childUsage);
     else if (cmd == "theme") {
-        if (tokens.size() > 1) changeTheme(*this, tokens[1]);
-        else ::showThemes(*this);
+        if (tokens.size() > 1) return changeTheme(*this, std::string(tokens[1]));
+        ::showThemes(*this);
+    }
+    else if (cmd == "stats") handleStatsCommand(tokens);
+    else if (cmd == "trace") return traceCommand(tokens);
+    else if (cmd == "grep" && !tokenizer.needsShell()) return grepCommand(*this, tokens);
+    else if ((cmd == "less" || cmd == "more") && !tokenizer.needsShell()) return pagerCommand(tokens);
+    else if (cmd == "daemon") return daemonCommand(*this, tokens);
+    else if (cmd == "alias") return aliasCommand(*this, tokens);
+    else if (cmd == "config") return configCommand(*this, tokens);
+    else if (tokenizer.needsShell() || cmd.find('=') != std::string_view::npos) {
+        // Pipes, redirections, VAR=valor...: the system shell handles the line
+        return runShellCommand(originalCommand, &childUsage);
     }
     else {
-        signal(SIGINT, SIG_IGN); 
-        system(originalCommand.c_str());
-        signal(SIGINT, signalHandler);
+        return runProcess(tokens, originalCommand, &childUsage);
+    }
+    return 0;
+}
+
+void Terminal::handleStatsCommand(const std::vector<std::string_view>& tokens) {
+    if (tokens.size() > 1 && tokens[1] == "prompt") {
+        if (tokens.size() > 2) showLastDuration = (tokens[2] == "on");
+        else showLastDuration = !showLastDuration;
+        std::cout << Colors::BRIGHT_GREEN << "Duracion en el prompt: " << (showLastDuration ? "activada" : "desactivada") << Colors::RESET << std::endl;
+    } else {
+        ::showStats(*this);
     }
 }
 
@@ -211,26 +378,42 @@ void Terminal::initializeThemes() {
 }
 
 void Terminal::handleTabCompletion(std::string& line, size_t& cursorPos) {
+    TRACE_SCOPE("handleTabCompletion");
     size_t word_start = line.rfind(' ', cursorPos > 0 ? cursorPos - 1 : 0);
     if (word_start == std::string::npos) word_start = 0;
     else word_start++;
 
     std::string to_complete_orig = line.substr(word_start, cursorPos - word_start);
     std::string to_complete_lower = toLower(to_complete_orig);
-    std::vector<std::string> matches;
+    std::vector<CompletionEntry> matches;
+
+    std::error_code ec;
+    std::string cwd = fs::current_path(ec).string();
+    std::vector<CompletionEntry> entries;
+    if (!daemonClient.listDirectory(cwd, entries)) entries = listCompletionEntries("");
+    for (auto& entry : entries) {
+        if (toLower(entry.name).rfind(to_complete_lower, 0) == 0) matches.push_back(std::move(entry));
+    }
 
-    try {
-        for (const auto& entry : fs::directory_iterator(".")) {
-            std::string filename = entry.path().filename().string();
-            if (toLower(filename).rfind(to_complete_lower, 0) == 0) {
-                matches.push_back(filename);
-            }
+    // The first word may also be a command on PATH
+    if (word_start == 0 && !to_complete_orig.empty() && to_complete_orig.find('/') == std::string::npos) {
+        const char* pathVar = getenv("PATH");
+        std::vector<std::string> fromDaemon;
+        const std::vector<std::string>* commands = &fromDaemon;
+        if (pathVar && !daemonClient.pathCommands(pathVar, fromDaemon)) {
+            executables.refresh(pathVar);
+            commands = &executables.names();
+        }
+        auto first = std::lower_bound(commands->begin(), commands->end(), to_complete_orig);
+        for (auto it = first; it != commands->end() && it->compare(0, to_complete_orig.size(), to_complete_orig) == 0; ++it) {
+            bool present = std::any_of(matches.begin(), matches.end(), [&](const CompletionEntry& m) { return m.name == *it; });
+            if (!present) matches.push_back({*it, false});
         }
-    } catch (...) {}
+    }
 
     if (matches.size() == 1) {
-        std::string completion = matches[0];
-        if (fs::is_directory(completion)) {
+        std::string completion = matches[0].name;
+        if (matches[0].isDir) {
             #ifdef _WIN32
                 completion += "\\";
             #else
@@ -247,10 +430,10 @@ void Terminal::handleTabCompletion(std::string& line, size_t& cursorPos) {
     } else if (matches.size() > 1) {
         std::cout << std::endl;
         for (const auto& match : matches) {
-            if (fs::is_directory(match)) {
-                std::cout << Colors::BRIGHT_BLUE << match << "/  " << Colors::RESET;
+            if (match.isDir) {
+                std::cout << Colors::BRIGHT_BLUE << match.name << "/  " << Colors::RESET;
             } else {
-                std::cout << match << "  ";
+                std::cout << match.name << "  ";
             }
         }
         std::cout << std::endl;
@@ -266,6 +449,7 @@ std::string Terminal::getLineAdvanced() {
 
     #ifdef _WIN32
         while ((c = _getch()) != '\r') {
+            TRACE_SCOPE("getLineAdvanced.key");
             if (c == '\b') {
                 if (cursorPos > 0) {
                     cursorPos--;
@@ -337,6 +521,7 @@ std::string Terminal::getLineAdvanced() {
         tcsetattr(STDIN_FILENO, TCSANOW, &newt);
 
         while ((c = getchar()) != '\n') { // Enter key
+            TRACE_SCOPE("getLineAdvanced.key");
             if (c == 127 || c == '\b') { // Backspace (127 en la mayoría de terminales Linux)
                 if (cursorPos > 0) {
                     cursorPos--;
@@ -405,6 +590,7 @@ std::string Terminal::getLineAdvanced() {
 void Terminal::run() {
     std::string input;
     while (true) {
+        refreshPromptInfo();
         showPrompt();
         historyIndex = -1;
         input = getLineAdvanced();
@@ -413,16 +599,17 @@ void Terminal::run() {
         input.erase(input.find_last_not_of(" \t") + 1);
         
         if (!input.empty()) {
-            if (commandHistory.empty() || commandHistory.back() != input) {
-                commandHistory.push_back(input);
-            }
+            addToHistory(input);
+            std::string command = expandAlias(input);
 
-            std::vector<std::string> tokens = splitCommand(input);
+            const std::vector<std::string_view>& tokens = expandGlobs(splitCommand(command));
             if (!tokens.empty() && (tokens[0] == "exit" || tokens[0] == "quit")) {
                 std::cout << Colors::BRIGHT_CYAN << "Hasta luego!" << Colors::RESET << std::endl;
+                dirIndex.save();
+                saveHistory();
                 break;
             }
-            executeCommand(tokens, input);
+            executeCommand(tokens, command);
         }
     }
 }
\ No newline at end of file
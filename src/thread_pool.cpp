@@ -0,0 +1,99 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace {
+    thread_local const ThreadPool* currentPool = nullptr;
+    thread_local size_t currentIndex = 0;
+}
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < threads; ++i) queues.push_back(std::make_unique<Queue>());
+    for (size_t i = 0; i < threads; ++i) workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    sleepCv.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+size_t ThreadPool::workerIndex() const {
+    return currentPool == this ? currentIndex : size();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    size_t index = workerIndex();
+    if (index == size()) index = nextQueue.fetch_add(1, std::memory_order_relaxed) % size();
+
+    pending.fetch_add(1, std::memory_order_relaxed);
+    {
+        // Counted under the sleep mutex so a worker about to check the
+        // predicate cannot miss the wakeup
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queued.fetch_add(1, std::memory_order_release);
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    sleepCv.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    doneCv.wait(lock, [this] { return pending.load(std::memory_order_acquire) == 0; });
+}
+
+bool ThreadPool::popLocal(size_t index, std::function<void()>& task) {
+    Queue& q = *queues[index];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty()) return false;
+    task = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(size_t index, std::function<void()>& task) {
+    for (size_t k = 1; k < queues.size(); ++k) {
+        Queue& q = *queues[(index + k) % queues.size()];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) continue;
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentIndex = index;
+
+    std::function<void()> task;
+    while (true) {
+        if (popLocal(index, task) || steal(index, task)) {
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            task();
+            task = nullptr;
+            if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                doneCv.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepCv.wait(lock, [this] { return stopping || queued.load(std::memory_order_acquire) > 0; });
+        if (stopping) return;
+    }
+}
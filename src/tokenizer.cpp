@@ -0,0 +1,230 @@
+#include "tokenizer.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+    #include <pwd.h>
+#endif
+
+static inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline bool isOperator(char c) {
+    return c == '|' || c == '&' || c == ';' || c == '<' || c == '>' || c == '(' || c == ')' || c == '`';
+}
+
+static inline bool isGlobMeta(char c) {
+    return c == '*' || c == '?' || c == '[';
+}
+
+// Characters that force a word out of the zero-copy path
+static inline bool isSpecial(char c) {
+    return c == '\'' || c == '"' || c == '\\' || c == '$' || isOperator(c);
+}
+
+static inline bool isNameChar(char c, bool first) {
+    return c == '_' || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (!first && c >= '0' && c <= '9');
+}
+
+static const char* homeDirectory() {
+    #ifdef _WIN32
+        const char* home = getenv("USERPROFILE");
+    #else
+        const char* home = getenv("HOME");
+    #endif
+    return home ? home : "";
+}
+
+// Home directory for "~user" ("" is the current user), or null if unknown.
+// `buffer` backs the returned string.
+static const char* tildeDirectory(std::string_view user, char* buffer, size_t size) {
+    if (user.empty()) return homeDirectory();
+    #ifdef _WIN32
+        (void)buffer;
+        (void)size;
+        return nullptr;
+    #else
+        char name[256];
+        if (user.size() >= sizeof(name)) return nullptr;
+        std::memcpy(name, user.data(), user.size());
+        name[user.size()] = '\0';
+        struct passwd entry;
+        struct passwd* result = nullptr;
+        if (getpwnam_r(name, &entry, buffer, size, &result) != 0 || !result) return nullptr;
+        return result->pw_dir;
+    #endif
+}
+
+// Quoted, escaped or expanded text: glob metacharacters (and the escape
+// character itself) are protected with a backslash until the word is done
+void Tokenizer::appendLiteral(char c) {
+    if (isGlobMeta(c) || c == ']' || c == '\\') {
+        arena += '\\';
+        escaped = true;
+    }
+    arena += c;
+}
+
+void Tokenizer::appendLiteral(const char* s) {
+    while (*s) appendLiteral(*s++);
+}
+
+// line[i] == '$'. Appends the value of $NAME / ${NAME} (or a literal '$')
+// and leaves i past the reference. Special parameters only exist in the
+// system shell, so they hand the line over to it.
+void Tokenizer::appendVariable(std::string_view line, size_t& i) {
+    size_t nameStart = i + 1;
+    size_t nameEnd = nameStart;
+    size_t next;
+
+    if (nameStart < line.size() && line[nameStart] == '(') {
+        shellSyntax = true; // $(...) command substitution
+    }
+    if (nameStart < line.size() && line[nameStart] && std::strchr("?$!#*@-0123456789", line[nameStart])) {
+        shellSyntax = true;
+        arena += '$';
+        arena += line[nameStart];
+        i = nameStart + 1;
+        return;
+    }
+    if (nameStart < line.size() && line[nameStart] == '{') {
+        size_t close = line.find('}', nameStart + 1);
+        if (close == std::string_view::npos) {
+            arena += '$';
+            i++;
+            return;
+        }
+        nameStart++;
+        nameEnd = close;
+        next = close + 1;
+    } else {
+        while (nameEnd < line.size() && isNameChar(line[nameEnd], nameEnd == nameStart)) nameEnd++;
+        next = nameEnd;
+    }
+
+    // getenv needs a terminated name; copying it to the stack keeps this allocation-free
+    char name[256];
+    size_t len = nameEnd - nameStart;
+    if (len == 0 || len >= sizeof(name)) {
+        arena += '$';
+        i++;
+        return;
+    }
+    std::memcpy(name, line.data() + nameStart, len);
+    name[len] = '\0';
+    if (!isNameChar(name[0], true)) shellSyntax = true; // ${1}, ${#VAR}, ${VAR:-x}...
+    if (const char* value = getenv(name)) appendLiteral(value);
+    i = next;
+}
+
+const std::vector<std::string_view>& Tokenizer::tokenize(std::string_view line) {
+    arena.clear();
+    spans.clear();
+    tokens.clear();
+    anyGlob = false;
+    shellSyntax = false;
+
+    const size_t n = line.size();
+    size_t i = 0;
+    while (true) {
+        while (i < n && isBlank(line[i])) i++;
+        if (i >= n || line[i] == '#') break;
+
+        // Fast path: plain word, referenced in place
+        size_t start = i;
+        bool glob = false;
+        while (i < n && !isBlank(line[i]) && !isSpecial(line[i])) glob |= isGlobMeta(line[i++]);
+        // ~ or ~user, only when the prefix ends at an unquoted '/', a blank or
+        // the end of the line: ~"x" and ~user'x' stay literal, as in bash
+        const char* tildeHome = nullptr;
+        size_t prefixEnd = start + 1;
+        char passwdBuffer[1024];
+        if (line[start] == '~') {
+            while (prefixEnd < i && line[prefixEnd] != '/') prefixEnd++;
+            if (prefixEnd < i || i >= n || isBlank(line[i])) {
+                tildeHome = tildeDirectory(line.substr(start + 1, prefixEnd - start - 1), passwdBuffer, sizeof(passwdBuffer));
+            }
+        }
+        if (!tildeHome && (i >= n || isBlank(line[i]))) {
+            spans.push_back({(uint32_t)start, (uint32_t)(i - start), false, glob});
+            anyGlob |= glob;
+            continue;
+        }
+
+        // Slow path: rebuild the word in the arena
+        size_t arenaStart = arena.size();
+        bool quoted = false;
+        escaped = false;
+        if (tildeHome) {
+            appendLiteral(tildeHome);
+            arena.append(line.data() + prefixEnd, i - prefixEnd);
+        } else {
+            arena.append(line.data() + start, i - start);
+        }
+
+        while (i < n && !isBlank(line[i])) {
+            char c = line[i];
+            if (c == '\'') {
+                quoted = true;
+                size_t close = line.find('\'', i + 1);
+                if (close == std::string_view::npos) close = n;
+                for (size_t k = i + 1; k < close; ++k) appendLiteral(line[k]);
+                i = close < n ? close + 1 : n;
+            } else if (c == '"') {
+                quoted = true;
+                i++;
+                while (i < n && line[i] != '"') {
+                    if (line[i] == '\\' && i + 1 < n && std::strchr("$`\"\\\n", line[i + 1])) {
+                        if (line[i + 1] != '\n') appendLiteral(line[i + 1]);
+                        i += 2;
+                    } else if (line[i] == '$') {
+                        appendVariable(line, i);
+                    } else {
+                        if (line[i] == '`') shellSyntax = true;
+                        appendLiteral(line[i++]);
+                    }
+                }
+                if (i < n) i++; // closing quote
+            } else if (c == '\\') {
+                if (i + 1 < n && line[i + 1] != '\n') appendLiteral(line[i + 1]);
+                i += 2;
+            } else if (c == '$') {
+                appendVariable(line, i);
+            } else {
+                if (isOperator(c)) shellSyntax = true;
+                size_t run = i;
+                while (i < n && !isBlank(line[i]) && (!isSpecial(line[i]) || (i == run && isOperator(line[i])))) {
+                    glob |= isGlobMeta(line[i++]);
+                }
+                arena.append(line.data() + run, i - run);
+            }
+        }
+        if (i > n) i = n;
+
+        size_t length = arena.size() - arenaStart;
+        if (escaped && !glob) {
+            // Not a glob after all: drop the protective backslashes in place
+            size_t out = arenaStart;
+            for (size_t k = arenaStart; k < arenaStart + length; ++k) {
+                if (arena[k] == '\\') k++;
+                arena[out++] = arena[k];
+            }
+            length = out - arenaStart;
+        }
+
+        // An unquoted expansion that came out empty is not a word
+        if (length > 0 || quoted) {
+            spans.push_back({(uint32_t)arenaStart, (uint32_t)length, true, glob});
+            anyGlob |= glob;
+        }
+    }
+
+    // The arena may have moved while growing, so views are taken at the end
+    for (const Span& span : spans) {
+        tokens.push_back(span.inArena ? std::string_view(arena.data() + span.offset, span.length)
+                                      : line.substr(span.offset, span.length));
+    }
+    return tokens;
+}
@@ -0,0 +1,154 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <unistd.h>
+    #ifdef __linux__
+        #include <sys/syscall.h>
+    #endif
+#endif
+
+namespace Trace {
+    std::atomic<bool> enabled{false};
+
+    namespace {
+        struct Event {
+            const char* name;
+            int64_t startNanos;
+            int64_t durNanos;
+        };
+
+        // Owned by one thread; the dumper only reads slots below `count`
+        struct ThreadBuffer {
+            static constexpr size_t CAPACITY = 1 << 16;
+
+            std::unique_ptr<Event[]> events{new Event[CAPACITY]};
+            std::atomic<uint64_t> count{0};
+            uint64_t tid = 0;
+        };
+
+        std::mutex registryMutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> registry;
+
+        uint64_t currentTid() {
+            #ifdef _WIN32
+                return GetCurrentThreadId();
+            #elif defined(__linux__)
+                return (uint64_t)syscall(SYS_gettid);
+            #else
+                return std::hash<std::thread::id>{}(std::this_thread::get_id());
+            #endif
+        }
+
+        uint64_t currentPid() {
+            #ifdef _WIN32
+                return GetCurrentProcessId();
+            #else
+                return (uint64_t)getpid();
+            #endif
+        }
+
+        ThreadBuffer& localBuffer() {
+            thread_local std::shared_ptr<ThreadBuffer> buffer;
+            if (!buffer) {
+                buffer = std::make_shared<ThreadBuffer>();
+                buffer->tid = currentTid();
+                std::lock_guard<std::mutex> lock(registryMutex);
+                registry.push_back(buffer);
+            }
+            return *buffer;
+        }
+
+        struct Collected {
+            Event event;
+            uint64_t tid;
+        };
+
+        std::vector<Collected> collect() {
+            std::vector<Collected> all;
+            std::lock_guard<std::mutex> lock(registryMutex);
+            for (const auto& buffer : registry) {
+                uint64_t n = buffer->count.load(std::memory_order_acquire);
+                uint64_t first = n > ThreadBuffer::CAPACITY ? n - ThreadBuffer::CAPACITY : 0;
+                for (uint64_t i = first; i < n; ++i) {
+                    all.push_back({buffer->events[i & (ThreadBuffer::CAPACITY - 1)], buffer->tid});
+                }
+            }
+            std::sort(all.begin(), all.end(), [](const Collected& a, const Collected& b) {
+                return a.event.startNanos < b.event.startNanos;
+            });
+            return all;
+        }
+    }
+
+    int64_t nowNanos() {
+        // steady_clock es CLOCK_MONOTONIC en Linux, el mismo reloj que perf -k
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void record(const char* name, int64_t startNanos, int64_t endNanos) {
+        ThreadBuffer& buffer = localBuffer();
+        uint64_t n = buffer.count.load(std::memory_order_relaxed);
+        buffer.events[n & (ThreadBuffer::CAPACITY - 1)] = {name, startNanos, endNanos - startNanos};
+        buffer.count.store(n + 1, std::memory_order_release);
+    }
+
+    void start() {
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            for (const auto& buffer : registry) buffer->count.store(0, std::memory_order_relaxed);
+        }
+        enabled.store(true, std::memory_order_release);
+    }
+
+    void stop() {
+        enabled.store(false, std::memory_order_release);
+    }
+
+    size_t eventCount() {
+        size_t total = 0;
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const auto& buffer : registry) {
+            total += std::min<uint64_t>(buffer->count.load(std::memory_order_acquire), ThreadBuffer::CAPACITY);
+        }
+        return total;
+    }
+
+    bool dumpChrome(const std::string& path) {
+        FILE* out = fopen(path.c_str(), "w");
+        if (!out) return false;
+
+        uint64_t pid = currentPid();
+        fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", out);
+        bool first = true;
+        for (const auto& c : collect()) {
+            fprintf(out, "%s{\"name\":\"%s\",\"cat\":\"myterm\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%llu,\"tid\":%llu}",
+                    first ? "" : ",\n", c.event.name, c.event.startNanos / 1000.0, c.event.durNanos / 1000.0,
+                    (unsigned long long)pid, (unsigned long long)c.tid);
+            first = false;
+        }
+        fputs("\n]}\n", out);
+        return fclose(out) == 0;
+    }
+
+    bool dumpPerf(const std::string& path) {
+        FILE* out = fopen(path.c_str(), "w");
+        if (!out) return false;
+
+        for (const auto& c : collect()) {
+            fprintf(out, "%lld %llu %lld %s\n", (long long)c.event.startNanos, (unsigned long long)c.tid,
+                    (long long)c.event.durNanos, c.event.name);
+        }
+        return fclose(out) == 0;
+    }
+}
@@ -15,15 +15,24 @@ void showHelp() {
         {"help", "Muestra esta ayuda"},
         {"ls/dir [-l] [ruta]", "Lista archivos y directorios"},
         {"cd [ruta|~|-]", "Cambia de directorio"},
+        {"cd/j <palabras...>", "Salta al directorio recordado que mejor coincide"},
+        {"pushd/popd/dirs", "Pila de directorios"},
         {"pwd", "Muestra el directorio actual"},
         {"mkdir <nombre>", "Crea un directorio"},
         {"rmdir <nombre>", "Elimina un directorio"},
         {"touch <archivo>", "Crea un archivo vacio"},
         {"rm <archivo>", "Elimina un archivo"},
         {"cat <archivo>", "Muestra el contenido de un archivo"},
+        {"less/more <archivo>", "Visor paginado (/ buscar, Ng linea, F seguir, q salir)"},
+        {"daemon [start|stop|status]", "Cache compartida entre sesiones"},
+        {"alias [nombre=valor]", "Muestra o define alias"},
+        {"config [reload]", "Configuracion (~/.myterm.conf): prompt, temas, alias"},
+        {"grep [-rinFEvlc] <patron>", "Busca texto en archivos (-r recursivo)"},
         {"clear/cls", "Limpia la pantalla"},
         {"git <comando>", "Ejecuta comandos de Git"},
         {"theme [nombre]", "Cambia o lista los temas de colores"},
+        {"stats [prompt on|off]", "Tiempos y recursos por comando"},
+        {"trace start|stop|dump", "Trazas internas (JSON Chrome o --perf)"},
         {"exit/quit", "Salir del terminal"}
     };
     
@@ -42,9 +51,36 @@ void showThemes(Terminal& term) {
     }
 }
 
-void showPrompt(Terminal& term, const std::string& relativePath, const std::string& gitBranch) {
-    const auto& theme = term.getCurrentTheme();
-    std::cout << theme.user_host << term.getUserName() << "@" << term.getComputerName() << Colors::RESET << ":"
-              << theme.directory << relativePath << theme.branch << gitBranch << Colors::RESET << "$ ";
+void showStats(Terminal& term) {
+    std::vector<CommandSummary> summaries = term.getStats().summarize();
+    if (summaries.empty()) {
+        std::cout << Colors::YELLOW << "No hay comandos registrados todavia." << Colors::RESET << std::endl;
+        return;
+    }
+
+    std::cout << Colors::BOLD << Colors::BRIGHT_WHITE << std::left << std::setw(16) << "comando" << std::right
+              << std::setw(7) << "n" << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99"
+              << std::setw(10) << "max" << std::setw(10) << "user" << std::setw(10) << "sys"
+              << std::setw(10) << "rss" << std::setw(7) << "err" << Colors::RESET << std::endl;
+    for (const auto& s : summaries) {
+        std::cout << Colors::BRIGHT_GREEN << std::left << std::setw(16) << s.name << Colors::RESET << std::right
+                  << std::setw(7) << s.count
+                  << std::setw(10) << formatDuration(s.p50Nanos)
+                  << std::setw(10) << formatDuration(s.p90Nanos)
+                  << std::setw(10) << formatDuration(s.p99Nanos)
+                  << std::setw(10) << formatDuration(s.maxNanos)
+                  << std::setw(10) << formatDuration(s.avgUserMicros * 1000)
+                  << std::setw(10) << formatDuration(s.avgSysMicros * 1000)
+                  << std::setw(8) << (s.maxRssKb < 0 ? "-" : std::to_string(s.maxRssKb / 1024)) << (s.maxRssKb < 0 ? "  " : "MB")
+                  << (s.failures ? Colors::RED : "") << std::setw(7) << s.failures << Colors::RESET << std::endl;
+    }
+    std::cout << Colors::BRIGHT_BLACK << term.getStats().total() << " comandos registrados (ultimos "
+              << CommandStats::CAPACITY << " conservados)" << Colors::RESET << std::endl;
+}
+
+void showPrompt(const PromptTemplate& prompt, const PromptTemplate::Slots& slots, std::string& buffer) {
+    buffer.clear();
+    prompt.render(slots, buffer);
+    std::cout.write(buffer.data(), (std::streamsize)buffer.size());
     std::cout.flush();
 }
\ No newline at end of file
@@ -1,5 +1,27 @@
 #include "utils.h"
 
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+    #include <chrono>
+    #include <filesystem>
+    namespace fs = std::filesystem;
+#else
+    #include <cerrno>
+    #include <dirent.h>
+    #include <unistd.h>
+    #include <fcntl.h>
+    #include <sys/file.h>
+    #include <sys/ioctl.h>
+    #include <sys/mman.h>
+    #include <sys/resource.h>
+    #include <sys/stat.h>
+    #include <sys/wait.h>
+#endif
+
 namespace Colors {
     const std::string RESET = "\033[0m";
     const std::string BLACK = "\033[30m";
@@ -39,7 +61,30 @@ int getTerminalWidth() {
         GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi);
         return csbi.srWindow.Right - csbi.srWindow.Left + 1;
     #else
-        return 80; // Valor por defecto para sistemas no-Windows
+        struct winsize ws;
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0) return ws.ws_col;
+        return 80; // Valor por defecto si la salida no es una terminal
+    #endif
+}
+
+std::string getHomeDirectory() {
+    #ifdef _WIN32
+        const char* home = getenv("USERPROFILE");
+    #else
+        const char* home = getenv("HOME");
+    #endif
+    return home ? home : "";
+}
+
+int getTerminalHeight() {
+    #ifdef _WIN32
+        CONSOLE_SCREEN_BUFFER_INFO csbi;
+        GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi);
+        return csbi.srWindow.Bottom - csbi.srWindow.Top + 1;
+    #else
+        struct winsize ws;
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0) return ws.ws_row;
+        return 24;
     #endif
 }
 
@@ -56,4 +101,359 @@ void initializeTerminal() {
         SetConsoleOutputCP(CP_UTF8);
         SetConsoleCP(CP_UTF8);
     #endif
-}
\ No newline at end of file
+}
+
+#ifndef _WIN32
+static ResourceUsage fromRusage(const struct rusage& ru) {
+    ResourceUsage usage;
+    usage.userMicros = (int64_t)ru.ru_utime.tv_sec * 1000000 + ru.ru_utime.tv_usec;
+    usage.sysMicros = (int64_t)ru.ru_stime.tv_sec * 1000000 + ru.ru_stime.tv_usec;
+    #ifdef __APPLE__
+        usage.maxRssKb = ru.ru_maxrss / 1024; // macOS lo reporta en bytes
+    #else
+        usage.maxRssKb = ru.ru_maxrss;
+    #endif
+    return usage;
+}
+#endif
+
+ResourceUsage getSelfUsage() {
+    #ifdef _WIN32
+        ResourceUsage usage;
+        FILETIME creation, exitTime, kernel, user;
+        if (GetProcessTimes(GetCurrentProcess(), &creation, &exitTime, &kernel, &user)) {
+            auto toMicros = [](const FILETIME& ft) {
+                return (int64_t)((((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime) / 10);
+            };
+            usage.userMicros = toMicros(user);
+            usage.sysMicros = toMicros(kernel);
+        }
+        return usage;
+    #else
+        struct rusage ru;
+        getrusage(RUSAGE_SELF, &ru);
+        return fromRusage(ru);
+    #endif
+}
+
+#ifndef _WIN32
+// fork + wait4 en lugar de system() para obtener el rusage exacto del hijo.
+// Con argv se ejecuta el programa directamente; si no existe (builtins del
+// shell, funciones...) el hijo recurre a /bin/sh -c shellCommand.
+static int spawnAndWait(char* const* argv, const char* shellCommand, ResourceUsage* usage) {
+    auto previous = signal(SIGINT, SIG_IGN);
+    pid_t pid = fork();
+    if (pid == 0) {
+        signal(SIGINT, SIG_DFL);
+        if (argv) {
+            execvp(argv[0], argv);
+            if (errno != ENOENT) _exit(126);
+        }
+        execl("/bin/sh", "sh", "-c", shellCommand, (char*)nullptr);
+        _exit(127);
+    }
+
+    int status = 0;
+    struct rusage ru {};
+    if (pid > 0) {
+        while (wait4(pid, &status, 0, &ru) < 0 && errno == EINTR) {}
+    }
+    signal(SIGINT, previous);
+
+    if (usage) *usage = pid > 0 ? fromRusage(ru) : ResourceUsage{};
+    if (pid < 0) return -1;
+    if (WIFEXITED(status)) return WEXITSTATUS(status);
+    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    return status;
+}
+#endif
+
+int runShellCommand(const std::string& command, ResourceUsage* usage) {
+    #ifdef _WIN32
+        if (usage) *usage = ResourceUsage{};
+        return system(command.c_str());
+    #else
+        return spawnAndWait(nullptr, command.c_str(), usage);
+    #endif
+}
+
+int runProcess(const std::vector<std::string_view>& args, const std::string& originalCommand, ResourceUsage* usage) {
+    #ifdef _WIN32
+        // cmd.exe no expande comodines: se le pasa la lista ya expandida
+        std::string command;
+        for (const auto& arg : args) {
+            if (!command.empty()) command += ' ';
+            command += quoteShellArgument(arg);
+        }
+        if (usage) *usage = ResourceUsage{};
+        return system(command.c_str());
+    #else
+        // Todo se prepara antes del fork: el hijo no debe reservar memoria
+        std::string buffer;
+        for (const auto& arg : args) {
+            buffer.append(arg.data(), arg.size());
+            buffer += '\0';
+        }
+        std::vector<char*> argv;
+        for (size_t pos = 0; pos < buffer.size(); pos += strlen(&buffer[pos]) + 1) argv.push_back(&buffer[pos]);
+        argv.push_back(nullptr);
+        return spawnAndWait(argv.data(), originalCommand.c_str(), usage);
+    #endif
+}
+
+std::string quoteShellArgument(std::string_view arg) {
+    bool safe = !arg.empty();
+    for (char c : arg) {
+        if (!isalnum((unsigned char)c) && !strchr("-_./=:,+@%", c)) safe = false;
+    }
+    if (safe) return std::string(arg);
+
+    #ifdef _WIN32
+        std::string quoted = "\"";
+        for (char c : arg) {
+            if (c == '"') quoted += '\\';
+            quoted += c;
+        }
+        return quoted + "\"";
+    #else
+        std::string quoted = "'";
+        for (char c : arg) {
+            if (c == '\'') quoted += "'\\''";
+            else quoted += c;
+        }
+        return quoted + "'";
+    #endif
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        ptr = std::exchange(other.ptr, nullptr);
+        length = std::exchange(other.length, 0);
+        #ifdef _WIN32
+            mapping = std::exchange(other.mapping, nullptr);
+        #endif
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    static const char empty[1] = {0};
+    #ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                  nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize)) {
+            CloseHandle(file);
+            return false;
+        }
+        length = (size_t)fileSize.QuadPart;
+        if (length == 0) {
+            CloseHandle(file);
+            ptr = empty;
+            return true;
+        }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (!mapping) return false;
+        ptr = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!ptr) {
+            CloseHandle(mapping);
+            mapping = nullptr;
+            return false;
+        }
+        return true;
+    #else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            ::close(fd);
+            return false;
+        }
+        length = (size_t)st.st_size;
+        if (length == 0) {
+            ::close(fd);
+            ptr = empty;
+            return true;
+        }
+        void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            length = 0;
+            return false;
+        }
+        ptr = (const char*)p;
+        return true;
+    #endif
+}
+
+void MappedFile::close() {
+    if (ptr && length > 0) {
+        #ifdef _WIN32
+            UnmapViewOfFile(ptr);
+            CloseHandle(mapping);
+            mapping = nullptr;
+        #else
+            munmap((void*)ptr, length);
+        #endif
+    }
+    ptr = nullptr;
+    length = 0;
+}
+
+void forEachDirectoryEntry(const std::string& dir, const std::function<void(const char*, bool, bool)>& fn) {
+    #ifdef _WIN32
+        std::error_code ec;
+        for (fs::directory_iterator it(dir.empty() ? "." : dir, ec), end; !ec && it != end; it.increment(ec)) {
+            std::string name = it->path().filename().string();
+            fn(name.c_str(), it->is_directory(ec), it->is_symlink(ec));
+        }
+    #else
+        DIR* d = opendir(dir.empty() ? "." : dir.c_str());
+        if (!d) return;
+        while (struct dirent* e = readdir(d)) {
+            const char* name = e->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+            bool isDir = e->d_type == DT_DIR;
+            bool isLink = e->d_type == DT_LNK;
+            if (e->d_type == DT_UNKNOWN) {
+                struct stat st;
+                std::string path = dir + name;
+                if (lstat(path.c_str(), &st) == 0) {
+                    isDir = S_ISDIR(st.st_mode);
+                    isLink = S_ISLNK(st.st_mode);
+                }
+            }
+            fn(name, isDir, isLink);
+        }
+        closedir(d);
+    #endif
+}
+
+int64_t modificationTime(const std::string& path) {
+    #ifdef _WIN32
+        std::error_code ec;
+        auto time = fs::last_write_time(path, ec);
+        if (ec) return -1;
+        return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    #else
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) return -1;
+        #ifdef __APPLE__
+            return (int64_t)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+        #else
+            return (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+        #endif
+    #endif
+}
+
+// Start of the last `max` lines of [begin, end); `total` is the line count
+static const char* lastLines(const char* begin, const char* end, size_t total, size_t max) {
+    const char* start = begin;
+    if (total > max) {
+        size_t skip = total - max;
+        while (skip--) start = (const char*)memchr(start, '\n', end - start) + 1;
+    }
+    return start;
+}
+
+static size_t countLines(const char* begin, const char* end) {
+    return std::count(begin, end, '\n') + (end > begin && end[-1] != '\n');
+}
+
+#ifndef _WIN32
+// A writer that replaces the file (history compaction, the directory index)
+// does so holding the lock, so whoever was waiting on the old one opens it
+// again.
+int lockFile(const std::string& path, int flags) {
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        int fd = open(path.c_str(), flags | O_CLOEXEC, 0600);
+        if (fd < 0) return -1;
+        if (flock(fd, LOCK_EX) != 0) return fd; // no locking here (some NFS): carry on without
+        struct stat locked, current;
+        if (fstat(fd, &locked) == 0 && stat(path.c_str(), &current) == 0 && locked.st_ino == current.st_ino &&
+            locked.st_dev == current.st_dev) {
+            return fd;
+        }
+        close(fd);
+    }
+    return -1;
+}
+#endif
+
+void readHistoryFile(const std::string& path, size_t max, std::vector<std::string>& out) {
+    out.clear();
+    MappedFile file;
+    if (!file.open(path) || max == 0) return;
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    for (const char* p = lastLines(begin, end, countLines(begin, end), max); p < end;) {
+        const char* nl = (const char*)memchr(p, '\n', end - p);
+        if (!nl) nl = end;
+        if (nl > p) out.emplace_back(p, nl - p);
+        p = nl + 1;
+    }
+}
+
+void compactHistoryFile(const std::string& path, size_t max) {
+    if (max == 0) return;
+    #ifndef _WIN32
+        int lock = lockFile(path, O_RDONLY);
+        if (lock < 0) return;
+    #endif
+    MappedFile file;
+    if (file.open(path)) {
+        const char* begin = file.data();
+        const char* end = begin + file.size();
+        size_t total = countLines(begin, end);
+        if (total > 2 * max) {
+            const char* start = lastLines(begin, end, total, max);
+            std::string tmp = path + ".tmp";
+            if (FILE* f = fopen(tmp.c_str(), "wb")) {
+                bool ok = fwrite(start, 1, end - start, f) == (size_t)(end - start);
+                if (ok && end > start && end[-1] != '\n') ok = fputc('\n', f) != EOF;
+                ok = (fclose(f) == 0) && ok;
+                // Skipped if it grew after all (writers that don't lock)
+                #ifdef _WIN32
+                    std::error_code ec;
+                    ok = ok && fs::file_size(path, ec) == file.size() && !ec;
+                #else
+                    struct stat st;
+                    ok = ok && fstat(lock, &st) == 0 && (size_t)st.st_size == file.size();
+                #endif
+                file.close();
+                if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) std::remove(tmp.c_str());
+            }
+        }
+    }
+    #ifndef _WIN32
+        close(lock);
+    #endif
+}
+
+bool appendHistoryFile(const std::string& path, const std::vector<std::string>& lines) {
+    std::string records;
+    for (const std::string& line : lines) {
+        if (line.find('\n') != std::string::npos) continue;
+        records += line;
+        records += '\n';
+    }
+    if (records.empty()) return true;
+    #ifdef _WIN32
+        FILE* f = fopen(path.c_str(), "ab");
+        if (!f) return false;
+        bool ok = fwrite(records.data(), 1, records.size(), f) == records.size();
+        return (fclose(f) == 0) && ok;
+    #else
+        // One write on an O_APPEND descriptor: concurrent sessions never
+        // interleave lines. The lock keeps it out of a compaction's way.
+        int fd = lockFile(path, O_WRONLY | O_APPEND | O_CREAT);
+        if (fd < 0) return false;
+        bool ok = write(fd, records.data(), records.size()) == (ssize_t)records.size();
+        close(fd);
+        return ok;
+    #endif
+}
@@ -0,0 +1,134 @@
+// Compares GrepMatcher with GNU grep, line by line, over a fixed text and a
+// set of BRE/ERE patterns. Skipped (77) when GNU grep is not installed.
+//
+//   grep_vs_gnu <workdir>
+
+#include "grep.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static const char* TEXT[] = {
+    "int main(int argc, char** argv) {",
+    "    std::string s = \"hola mundo\";",
+    "    return 0;",
+    "}",
+    "sol y sombra",
+    "Solo un paso",
+    "perro, gato <y> raton",
+    "it's `quoted' text",
+    "foo.bar[baz] = qux;",
+    "a]b a-b a^b",
+    "x=1 y=22 z=333",
+    "  espacios al final   ",
+    "",
+    "TODO: revisar esto",
+    "todo bien",
+    "abcabcabc",
+    "a{2} literal",
+    "ruta/a/archivo.txt",
+};
+
+struct Case {
+    const char* pattern;
+    bool extended;
+    bool ignoreCase;
+};
+
+static const Case CASES[] = {
+    {"\\<s", false, false},
+    {"o\\>", false, false},
+    {"\\bso", true, false},
+    {"a\\Bb", true, false},
+    {"\\`int", false, false},
+    {";\\'", false, false},
+    {"[[:alpha:]]", false, false},
+    {"[[:digit:]]\\{2,\\}", false, false},
+    {"[[:space:]]$", true, false},
+    {"[[=a=]]b", false, false},
+    {"[[.-.]]b", false, false},
+    {"a[]^]b", false, false},
+    {"[^[:alnum:] ]", true, false},
+    {"foo\\.bar\\[baz\\]", false, false},
+    {"<y>", true, false},
+    {"'s `", false, false},
+    {"(abc){3}", true, false},
+    {"\\(abc\\)\\{2\\}", false, false},
+    {"a{2}", false, false},
+    {"todo", false, true},
+    {"^s|paso$", true, false},
+    {"r+o", true, false},
+    {"\\w+/\\w+", true, false},
+    {"x=1.*z", false, false},
+};
+
+int main(int argc, char** argv) {
+    fs::path dir = argc > 1 ? fs::path(argv[1]) : fs::temp_directory_path();
+    fs::create_directories(dir);
+    fs::path textPath = dir / "grep_vs_gnu.txt";
+    std::vector<std::string> lines(std::begin(TEXT), std::end(TEXT));
+    {
+        std::ofstream out(textPath, std::ios::binary);
+        for (const std::string& line : lines) out << line << '\n';
+    }
+
+    FILE* version = popen("grep --version 2>/dev/null", "r");
+    char banner[256] = "";
+    bool gnu = version && fgets(banner, sizeof(banner), version) && std::string(banner).find("GNU") != std::string::npos;
+    if (version) pclose(version);
+    if (!gnu) {
+        std::cout << "GNU grep no disponible" << std::endl;
+        return 77;
+    }
+
+    int failures = 0;
+    for (const Case& c : CASES) {
+        std::string quoted = "'";
+        for (const char* p = c.pattern; *p; ++p) quoted += *p == '\'' ? std::string("'\\''") : std::string(1, *p);
+        quoted += "'";
+        std::string command = std::string("LC_ALL=C grep -n ") + (c.extended ? "-E " : "") + (c.ignoreCase ? "-i " : "") +
+                              "-e " + quoted + " '" + textPath.string() + "' | cut -d: -f1";
+        std::vector<bool> expected(lines.size(), false);
+        FILE* gnuGrep = popen(command.c_str(), "r");
+        char number[32];
+        while (gnuGrep && fgets(number, sizeof(number), gnuGrep)) expected[std::stoul(number) - 1] = true;
+        if (gnuGrep) pclose(gnuGrep);
+
+        GrepOptions options;
+        options.extended = c.extended;
+        options.ignoreCase = c.ignoreCase;
+        GrepMatcher matcher(c.pattern, options);
+        if (!matcher.valid()) {
+            std::cout << "FALLO " << c.pattern << ": " << matcher.errorMessage() << std::endl;
+            failures++;
+            continue;
+        }
+        // Through nextCandidate as runGrep does, so the literal prefilter counts
+        std::string data;
+        for (const std::string& line : lines) data += line + '\n';
+        std::vector<bool> actual(lines.size(), false);
+        size_t pos = 0, lineNo = 0, lineStart = 0;
+        while (pos < data.size()) {
+            size_t start = matcher.nextCandidate(data.data(), data.size(), pos);
+            if (start == std::string::npos) break;
+            while (lineStart < start) lineStart = data.find('\n', lineStart) + 1, lineNo++;
+            size_t end = data.find('\n', start);
+            if (matcher.matchLine(data.data() + start, end - start, nullptr)) actual[lineNo] = true;
+            pos = end + 1;
+        }
+        for (size_t i = 0; i < lines.size(); ++i) {
+            if (actual[i] == expected[i]) continue;
+            std::cout << "FALLO " << (c.extended ? "-E " : "") << (c.ignoreCase ? "-i " : "") << c.pattern << " linea " << i + 1
+                      << ": myterm " << actual[i] << ", GNU grep " << expected[i] << std::endl;
+            failures++;
+        }
+    }
+    std::cout << (sizeof(CASES) / sizeof(CASES[0])) << " patrones, " << failures << " diferencias" << std::endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,283 @@
+// Headless harness: runs myterm inside a pseudo terminal, replays a recorded
+// keystroke stream into getLineAdvanced() and measures, per key, the latency
+// until the first byte of the redraw and the bytes written back.
+//
+//   pty_harness <myterm> <replay.keys>
+//
+// Replay format, one directive per line ('#' starts a comment):
+//   type <text>           each byte is sent as a separate keystroke
+//   key <escaped>         one keystroke, e.g. "key \t" or "key \x1b[A"
+//   line <text>           type <text> followed by Enter
+//   paste <escaped>       the whole string in a single write
+//   expect <text>         wait until the output (since the last expect) contains <text>
+//   reject <text>         fail if the output since the last expect contains <text>
+//   mkdir <path>          fixture directory inside the session's working directory
+//   file <path> <escaped> fixture file with the given content
+//   max-latency-ms <n>    fail if any non-Enter keystroke takes longer than <n> ms
+//
+// The session runs in a fresh temporary directory that is also $HOME and
+// $XDG_RUNTIME_DIR, so a daemon it starts never meets the user's own.
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#if defined(__APPLE__)
+    #include <util.h>
+#else
+    #include <pty.h>
+#endif
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+static const int QUIET_MS = 15;      // output considered settled after this pause
+static const int EXPECT_TIMEOUT_MS = 5000;
+static const int SILENT_KEY_MS = 500;  // keys like Left at column 0 print nothing
+
+struct KeySample {
+    double latencyMicros;
+    size_t bytes;
+    bool enter;
+    bool echoed;
+};
+
+class Session {
+public:
+    Session(const std::string& binary, const fs::path& workdir) {
+        struct winsize ws {};
+        ws.ws_row = 40;
+        ws.ws_col = 120;
+        pid = forkpty(&master, nullptr, nullptr, &ws);
+        if (pid < 0) {
+            perror("forkpty");
+            exit(2);
+        }
+        if (pid == 0) {
+            if (chdir(workdir.c_str()) != 0) _exit(126);
+            setenv("HOME", workdir.c_str(), 1);
+            setenv("XDG_RUNTIME_DIR", workdir.c_str(), 1);
+            unsetenv("MYTERM_DAEMON_SOCKET");
+            setenv("TERM", "xterm-256color", 1);
+            execl(binary.c_str(), binary.c_str(), (char*)nullptr);
+            _exit(127);
+        }
+    }
+
+    ~Session() {
+        if (pid > 0) {
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+        }
+        close(master);
+    }
+
+    // Reads whatever is available within timeoutMs; returns bytes read
+    size_t pump(int timeoutMs) {
+        struct pollfd pfd = {master, POLLIN, 0};
+        if (poll(&pfd, 1, timeoutMs) <= 0) return 0;
+        char buf[65536];
+        ssize_t n = read(master, buf, sizeof(buf));
+        if (n <= 0) {
+            exited = true;
+            return 0;
+        }
+        output.append(buf, n);
+        return (size_t)n;
+    }
+
+    KeySample send(const std::string& bytes) {
+        auto start = Clock::now();
+        if (write(master, bytes.data(), bytes.size()) != (ssize_t)bytes.size()) {
+            perror("write");
+            exit(2);
+        }
+        KeySample sample{0, 0, bytes == "\r", false};
+        while (true) {
+            size_t n = pump(sample.echoed ? QUIET_MS : (sample.enter ? EXPECT_TIMEOUT_MS : SILENT_KEY_MS));
+            if (n == 0) break;
+            if (!sample.echoed) {
+                sample.latencyMicros = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+                sample.echoed = true;
+            }
+            sample.bytes += n;
+        }
+        return sample;
+    }
+
+    bool waitFor(const std::string& text) {
+        auto deadline = Clock::now() + std::chrono::milliseconds(EXPECT_TIMEOUT_MS);
+        while (output.find(text, mark) == std::string::npos) {
+            if (exited || Clock::now() > deadline) return false;
+            pump(50);
+        }
+        mark = output.find(text, mark) + text.size();
+        return true;
+    }
+
+    bool seen(const std::string& text) const { return output.find(text, mark) != std::string::npos; }
+
+    bool finish() {
+        int status = 0;
+        auto deadline = Clock::now() + std::chrono::milliseconds(EXPECT_TIMEOUT_MS);
+        while (Clock::now() < deadline) {
+            pump(20);
+            pid_t r = waitpid(pid, &status, WNOHANG);
+            if (r == pid) {
+                pid = -1;
+                return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+            }
+        }
+        return false;
+    }
+
+    std::string output;
+
+private:
+    int master = -1;
+    pid_t pid = -1;
+    size_t mark = 0;
+    bool exited = false;
+};
+
+static std::string unescape(const std::string& s) {
+    std::string out;
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (s[i] != '\\' || i + 1 == s.size()) {
+            out += s[i];
+            continue;
+        }
+        char c = s[++i];
+        switch (c) {
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'e': out += '\x1b'; break;
+            case 's': out += ' '; break;
+            case 'x':
+                out += (char)std::stoi(s.substr(i + 1, 2), nullptr, 16);
+                i += 2;
+                break;
+            default: out += c;
+        }
+    }
+    return out;
+}
+
+static double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "uso: pty_harness <myterm> <replay.keys>" << std::endl;
+        return 2;
+    }
+    std::ifstream script(argv[2]);
+    if (!script) {
+        std::cerr << "no se pudo abrir " << argv[2] << std::endl;
+        return 2;
+    }
+
+    char tmpl[] = "/tmp/myterm-pty-XXXXXX";
+    fs::path workdir = mkdtemp(tmpl);
+    int failures = 0;
+    double maxLatencyMs = 250;
+    std::vector<KeySample> samples;
+    {
+        Session session(fs::absolute(argv[1]).string(), workdir);
+        if (!session.waitFor("$ ")) {
+            std::cerr << "FALLO: no aparecio el prompt inicial" << std::endl;
+            failures++;
+        }
+        // The editor switches the tty to raw mode right after printing the
+        // prompt; give it a moment so the first key isn't echoed twice
+        session.pump(100);
+
+        std::string raw;
+        int lineNo = 0;
+        while (failures == 0 && std::getline(script, raw)) {
+            lineNo++;
+            if (raw.empty() || raw[0] == '#') continue;
+            size_t sp = raw.find(' ');
+            std::string op = raw.substr(0, sp);
+            std::string arg = sp == std::string::npos ? "" : raw.substr(sp + 1);
+
+            if (op == "type" || op == "line") {
+                for (char c : arg) samples.push_back(session.send(std::string(1, c)));
+                if (op == "line") samples.push_back(session.send("\r"));
+            } else if (op == "key") {
+                samples.push_back(session.send(unescape(arg)));
+            } else if (op == "paste") {
+                session.send(unescape(arg));
+            } else if (op == "expect") {
+                if (!session.waitFor(unescape(arg))) {
+                    std::cerr << argv[2] << ":" << lineNo << ": FALLO: no se encontro '" << arg << "'" << std::endl;
+                    failures++;
+                }
+            } else if (op == "reject") {
+                if (session.seen(unescape(arg))) {
+                    std::cerr << argv[2] << ":" << lineNo << ": FALLO: aparecio '" << arg << "'" << std::endl;
+                    failures++;
+                }
+            } else if (op == "mkdir") {
+                fs::create_directories(workdir / arg);
+            } else if (op == "file") {
+                size_t split = arg.find(' ');
+                fs::path target = workdir / arg.substr(0, split);
+                fs::create_directories(target.parent_path());
+                std::ofstream(target, std::ios::binary) << (split == std::string::npos ? "" : unescape(arg.substr(split + 1)));
+            } else if (op == "max-latency-ms") {
+                maxLatencyMs = std::stod(arg);
+            } else {
+                std::cerr << argv[2] << ":" << lineNo << ": directiva desconocida '" << op << "'" << std::endl;
+                return 2;
+            }
+        }
+
+        if (failures == 0) {
+            for (char c : std::string("exit")) session.send(std::string(1, c));
+            session.send("\r");
+            if (!session.finish()) {
+                std::cerr << "FALLO: myterm no termino con 'exit'" << std::endl;
+                failures++;
+            }
+        }
+        if (failures) std::cerr << "---- salida ----\n" << session.output << "\n----------------" << std::endl;
+    }
+    fs::remove_all(workdir);
+
+    std::vector<double> keyLatencies;
+    size_t keyBytes = 0;
+    for (const auto& s : samples) {
+        if (s.enter || !s.echoed) continue;
+        keyLatencies.push_back(s.latencyMicros);
+        keyBytes += s.bytes;
+    }
+    double p50 = percentile(keyLatencies, 0.50);
+    double p99 = percentile(keyLatencies, 0.99);
+    double worst = keyLatencies.empty() ? 0 : *std::max_element(keyLatencies.begin(), keyLatencies.end());
+    printf("%s: %zu teclas, latencia p50 %.0fus p99 %.0fus max %.0fus, %zu bytes (%.1f por tecla)\n",
+           fs::path(argv[2]).filename().c_str(), keyLatencies.size(), p50, p99, worst, keyBytes,
+           keyLatencies.empty() ? 0.0 : (double)keyBytes / keyLatencies.size());
+
+    if (worst > maxLatencyMs * 1000) {
+        std::cerr << "FALLO: latencia maxima " << worst / 1000 << "ms > " << maxLatencyMs << "ms" << std::endl;
+        failures++;
+    }
+    return failures ? 1 : 0;
+}